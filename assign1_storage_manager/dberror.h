@@ -17,18 +17,29 @@ typedef int RC;
 #define RC_READ_FAILED 5
 #define RC_SEEK_FAILED 6
 
+#define RC_BM_PAGES_STILL_PINNED 100
+#define RC_BM_PAGE_BEING_WRITTEN 101
+#define RC_BM_CORRUPTED_PAGE 102
+
 #define RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE 200
 #define RC_RM_EXPR_RESULT_IS_NOT_BOOLEAN 201
 #define RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN 202
 #define RC_RM_NO_MORE_TUPLES 203
 #define RC_RM_NO_PRINT_FOR_DATATYPE 204
 #define RC_RM_UNKOWN_DATATYPE 205
+#define RC_RM_NO_ROOM_FOR_RECORD 206
+#define RC_RM_UNKNOWN_ATTRIBUTE 207
+#define RC_RM_STATISTICS_TOO_LARGE 208
+#define RC_RM_INVALID_SAMPLE_FRACTION 209
+#define RC_RM_DICTIONARY_FULL 210
 
 #define RC_IM_KEY_NOT_FOUND 300
 #define RC_IM_KEY_ALREADY_EXISTS 301
 #define RC_IM_N_TO_LAGE 302
 #define RC_IM_NO_MORE_ENTRIES 303
 
+#define RC_WAL_END_OF_LOG 400
+
 
 /* holder for error messages */
 extern char *RC_message;
@@ -3,6 +3,7 @@
 #include "storage_mgr.h"
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
 
 
@@ -232,11 +233,136 @@ extern RC appendEmptyBlock (SM_FileHandle *fHandle){
     return RC_OK;
 }
 
+/*
+ * All the missing pages are appended with a single write and the number of pages is written once
+ */
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle){
-    while (fHandle->totalNumPages < numberOfPages){
-        if (appendEmptyBlock(fHandle) != RC_OK){
-            return RC_WRITE_FAILED;
-        }
+    if (fHandle->totalNumPages >= numberOfPages){
+        return RC_OK;
+    }
+    int curBlockPos = getBlockPos(fHandle);
+    FILE * file = fHandle->mgmtInfo;
+    fseek(file, 0L, SEEK_END);
+
+    int numberOfChar = (numberOfPages - fHandle->totalNumPages)*PAGE_SIZE/(sizeof (char));
+    char * charArray = calloc(numberOfChar, sizeof(char));
+    int wrote = fwrite(charArray, sizeof(char), numberOfChar, file);
+    free(charArray);
+    if (wrote < numberOfChar){
+        return RC_WRITE_FAILED;
+    }
+    fHandle->totalNumPages = numberOfPages;
+
+    // writing new number of pages in the file
+    fseek(file, 0L, SEEK_SET);
+    if (fprintf(file, "%d", fHandle->totalNumPages) < 1){
+        return RC_WRITE_FAILED;
+    }
+
+    fseek(file, curBlockPos*PAGE_SIZE, SEEK_SET);
+    return RC_OK;
+}
+
+/*
+ * Remove the pages after the first numberOfPages ones from the file, it has numberOfPages pages afterwards.
+ * The number of pages is followed by a '\0' so the digits of a longer previous number are not read with it.
+ */
+extern RC truncatePageFile (int numberOfPages, SM_FileHandle *fHandle){
+    if (numberOfPages < 0){
+        return RC_WRITE_FAILED;
+    }
+    if (fHandle->totalNumPages <= numberOfPages){
+        return RC_OK;
+    }
+    FILE * file = fHandle->mgmtInfo;
+    fflush(file);
+    // + 1 for the reserved page
+    if (ftruncate(fileno(file), (long)(numberOfPages + 1)*PAGE_SIZE) != 0){
+        return RC_WRITE_FAILED;
+    }
+    fHandle->totalNumPages = numberOfPages;
+
+    // writing new number of pages in the file
+    fseek(file, 0L, SEEK_SET);
+    if (fprintf(file, "%d", fHandle->totalNumPages) < 1 || fputc('\0', file) == EOF){
+        return RC_WRITE_FAILED;
+    }
+    fflush(file);
+
+    if (fHandle->curPagePos > numberOfPages){
+        fHandle->curPagePos = numberOfPages;
+    }
+    fseek(file, fHandle->curPagePos*PAGE_SIZE, SEEK_SET);
+    return RC_OK;
+}
+
+/*
+ * Byte access to a page file, the offsets start at the beginning of the file (reserved page included).
+ * The number of pages of the file is not changed, the caller keeps track of what the bytes hold.
+ */
+extern long getFileSize (SM_FileHandle *fHandle){
+    FILE * file = fHandle->mgmtInfo;
+    fseek(file, 0L, SEEK_END);
+    return ftell(file);
+}
+
+extern RC readBytes (long offset, int length, SM_FileHandle *fHandle, char *memory){
+    FILE * file = fHandle->mgmtInfo;
+    if (fseek(file, offset, SEEK_SET) != 0){
+        return RC_SEEK_FAILED;
+    }
+    if (fread(memory, sizeof (char), length, file) != (size_t) length){
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    return RC_OK;
+}
+
+// writing after the end of the file extends it
+extern RC writeBytes (long offset, int length, SM_FileHandle *fHandle, char *memory){
+    FILE * file = fHandle->mgmtInfo;
+    if (fseek(file, offset, SEEK_SET) != 0){
+        return RC_WRITE_FAILED;
+    }
+    if (fwrite(memory, sizeof (char), length, file) != (size_t) length){
+        return RC_WRITE_FAILED;
     }
     return RC_OK;
 }
+
+extern RC truncateBytes (long size, SM_FileHandle *fHandle){
+    FILE * file = fHandle->mgmtInfo;
+    fflush(file);
+    if (ftruncate(fileno(file), size) != 0){
+        return RC_WRITE_FAILED;
+    }
+    return RC_OK;
+}
+
+// the writes to the file reach the disk before it returns, not only the cache of the operating system
+extern RC syncPageFile (SM_FileHandle *fHandle){
+    FILE * file = fHandle->mgmtInfo;
+    if (fflush(file) != 0 || fsync(fileno(file)) != 0){
+        return RC_WRITE_FAILED;
+    }
+    return RC_OK;
+}
+
+/*
+ * Rename the page file fileName to newName, replacing newName if it exists. The directory holding it is synced so the
+ * rename survives a crash: the file is found under one name or the other, never under none.
+ */
+extern RC renamePageFile (char *fileName, char *newName){
+    if (rename(fileName, newName) != 0){
+        return RC_WRITE_FAILED;
+    }
+    const char * slash = strrchr(newName, '/');
+    char * directoryName = slash == NULL ? strdup(".") : strndup(newName, slash == newName ? 1 : slash - newName);
+    int directory = open(directoryName, O_RDONLY);
+    free(directoryName);
+    if (directory < 0){
+        return RC_WRITE_FAILED;
+    }
+    int synced = fsync(directory);
+    close(directory);
+    return synced == 0 ? RC_OK : RC_WRITE_FAILED;
+}
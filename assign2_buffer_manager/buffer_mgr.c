@@ -2,8 +2,120 @@
 #include "buffer_mgr.h"
 #include "storage_mgr.h"
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <sys/time.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define MAX_NUMA_NODES 64
+
+// NUMA memory policies of the mbind system call (linux/mempolicy.h)
+#define MPOL_BIND_MODE 2
+
+// The governor never shrinks a pool under this number of frames, unless the pool sets a minimum of its own
+#define GOVERNOR_MIN_FRAMES 2
+// Number of reads from disk, all pools together, between two automatic rebalancing of the governor
+#define GOVERNOR_REBALANCE_INTERVAL 256
+
+/*
+ * A compressed page file has two trailer slots at the end of its reserved page, each [directoryOffset numberOfPages codec
+ * sequence magic]: the valid one with the highest sequence points to the directory in use, with an entry per page
+ */
+#define COMPRESSED_FILE_MAGIC 0x4c5a5046
+#define COMPRESSED_TRAILER_SIZE (sizeof(long) + 4 * sizeof(int))
+#define COMPRESSED_TRAILERS_OFFSET (PAGE_SIZE - 2 * COMPRESSED_TRAILER_SIZE)
+#define COMPRESSED_ENTRY_SIZE (sizeof(long) + sizeof(int))
+
+// Shortest copy of the LZ codec, and bits of the hash of 4 bytes used to find where they were seen before in the page
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 12
+
+/*
+ * A contiguous piece of memory holding pages of frames. A pool has one arena per allocation: one at init and one
+ * each time it grows.
+ */
+typedef struct BM_FrameArena BM_FrameArena;
+
+typedef struct BM_FrameArena {
+    char *memory;
+    size_t size;
+    BM_FrameArena *next;
+} BM_FrameArena;
+
+/*
+ * A pool registered in the memory governor with its counters at the previous rebalancing. The other fields are what
+ * readGovernedPool read under the lock of the pool, the rebalancing decides on them.
+ */
+typedef struct BM_GovernedPool {
+    BM_BufferPool *pool;
+    int lastReadIO;
+    int numPages;
+    int numberOfReadIO;
+    int minFrames;
+    bool held;
+} BM_GovernedPool;
+
+/*
+ * Process wide memory governor. budget is 0 while no budget has been set, pools are then never resized.
+ * lock is never taken by a thread holding the lock of a pool, the governor locks the pools it resizes.
+ */
+typedef struct BM_MemoryGovernor {
+    int budget;
+    BM_GovernedPool *pools;
+    int numberOfPools;
+    int readIOSinceRebalance; // changed atomically by the pools
+    pthread_mutex_t lock;
+} BM_MemoryGovernor;
+
+BM_MemoryGovernor governor = {0, NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER};
+
+/*
+ * Memory of the frames of a pool. The page memory of the arenas is handed to the frames and given back when a frame
+ * is removed from the pool, it is never unmapped before the pool is shut down.
+ */
+typedef struct BM_FrameMemory {
+    BM_MemoryOptions options;
+    int numberOfNodes;
+    BM_FrameArena *arenas;
+    char **freePages; // page memory not used by any frame
+    int *freePagesNode; // NUMA node of each free page, -1 if unknown
+    int numberOfFreePages;
+    int capacity; // number of pages in all the arenas
+    unsigned long nextFrameVersion; // a new frame never starts with the version of a previous frame of the pool
+} BM_FrameMemory;
+
+/*
+ * Where a page of a compressed page file is. length is 0 for a page never written (it reads as zeros) and PAGE_SIZE
+ * for a page the codec could not make smaller, stored as is.
+ */
+typedef struct BM_CompressedPage {
+    long offset;
+    int length;
+} BM_CompressedPage;
+
+/*
+ * Directory of a compressed page file, loaded when the pool is initialized. After the reserved page the file holds the
+ * encoded pages and the directories, written when the pool is flushed or shut down, always appended: the bytes the
+ * directory in use points to are never overwritten, so a crash leaves the file as of that directory. A page is only
+ * rewritten in place when it was appended after it and its new encoding fits. The bytes of replaced pages and
+ * directories are dead, the file is compacted when they outweigh the live ones.
+ */
+typedef struct BM_CompressedFile {
+    BM_PageCodec codec;
+    BM_CompressedPage *pages;
+    int numberOfPages;
+    int capacity;
+    long end; // end of the file, where the next page or directory is appended
+    long committed; // end of the file when the directory in use was written
+    long directoryLength; // of the directory in use
+    long deadBytes;
+    int sequence; // of the directory in use, -1 if there is none
+    bool changed; // the pages differ from the directory in use
+} BM_CompressedFile;
 
 
 /*
@@ -18,9 +130,284 @@ BM_FramesHandle *createFrames(int numberOfFrames) {
     }
     frames->actualUsedFrames = 0;
     frames->lastPinnedPosition = -1;
+    frames->retired = NULL;
+    frames->numberOfRetired = 0;
+    frames->memory = NULL;
+    frames->sizeHolds = 0;
+    frames->minFrames = GOVERNOR_MIN_FRAMES;
+    frames->compressedFile = NULL;
+    frames->beforeWrite = NULL;
+    frames->beforeWriteData = NULL;
+    frames->lock = malloc(sizeof(pthread_mutex_t));
+    pthread_mutex_init((pthread_mutex_t *) frames->lock, NULL);
     return frames;
 }
 
+/*
+ * Every function of the interface changing a pool holds its lock, the functions ending with Locked expect the caller
+ * to hold it.
+ */
+void lockPool(BM_BufferPool *const bm) {
+    pthread_mutex_lock((pthread_mutex_t *) ((BM_FramesHandle *) bm->mgmtData)->lock);
+}
+
+void unlockPool(BM_BufferPool *const bm) {
+    pthread_mutex_unlock((pthread_mutex_t *) ((BM_FramesHandle *) bm->mgmtData)->lock);
+}
+
+/*
+ * Number of NUMA nodes of the machine, 1 if it can't be known
+ */
+int countNumaNodes() {
+    int numberOfNodes = 0;
+    char path[64];
+    while (numberOfNodes < MAX_NUMA_NODES) {
+        sprintf(path, "/sys/devices/system/node/node%d", numberOfNodes);
+        if (access(path, F_OK) != 0) {
+            break;
+        }
+        numberOfNodes++;
+    }
+    return numberOfNodes == 0 ? 1 : numberOfNodes;
+}
+
+/*
+ * NUMA node of the CPU the calling thread is running on, 0 if it can't be known
+ */
+int currentNumaNode() {
+#ifdef SYS_getcpu
+    unsigned int cpu, node;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL) == 0) {
+        return (int) node;
+    }
+#endif
+    return 0;
+}
+
+/*
+ * Ask the kernel to place the memory [start, start + size) on node. Nothing is done if it is not possible, the memory
+ * is then placed by the default policy.
+ */
+void bindMemoryToNode(char *start, size_t size, int node) {
+#ifdef SYS_mbind
+    unsigned long nodeMask[MAX_NUMA_NODES / (8 * sizeof(unsigned long)) + 1] = {0};
+    nodeMask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+    syscall(SYS_mbind, start, size, MPOL_BIND_MODE, nodeMask, MAX_NUMA_NODES + 1, 0);
+#endif
+}
+
+/*
+ * Map size bytes for frame pages, backed by huge pages if asked.
+ * Returns NULL if the memory can't be mapped.
+ */
+char *mapArenaMemory(size_t size, BM_HugePages hugePages) {
+    char *memory;
+#ifdef MAP_HUGETLB
+    if (hugePages == BM_HUGE_PAGES_EXPLICIT) {
+        memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (memory != MAP_FAILED) {
+            return memory;
+        }
+    }
+#endif
+    if (hugePages == BM_HUGE_PAGES_NONE) {
+        memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        return memory == MAP_FAILED ? NULL : memory;
+    }
+
+    /* transparent huge pages need 2 MB aligned memory: mapping one huge page more and cutting what is not aligned */
+    char *mapped = mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped == MAP_FAILED) {
+        return NULL;
+    }
+    memory = (char *) (((unsigned long) mapped + HUGE_PAGE_SIZE - 1) & ~((unsigned long) HUGE_PAGE_SIZE - 1));
+    if (memory > mapped) {
+        munmap(mapped, memory - mapped);
+    }
+    if (memory + size < mapped + size + HUGE_PAGE_SIZE) {
+        munmap(memory + size, (mapped + size + HUGE_PAGE_SIZE) - (memory + size));
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(memory, size, MADV_HUGEPAGE);
+#endif
+    return memory;
+}
+
+/*
+ * Add an arena with numberOfPages pages to memory, its pages are added to the free pages.
+ * With BM_NUMA_INTERLEAVE the arena is cut in one region per node, the pages of a region are bound to its node.
+ */
+RC addFrameArena(BM_FrameMemory *memory, int numberOfPages) {
+    int numberOfRegions = memory->options.numaPolicy == BM_NUMA_INTERLEAVE ? memory->numberOfNodes : 1;
+    size_t regionSize = (size_t) ((numberOfPages + numberOfRegions - 1) / numberOfRegions) * PAGE_SIZE;
+    if (memory->options.hugePages != BM_HUGE_PAGES_NONE) {
+        regionSize = (regionSize + HUGE_PAGE_SIZE - 1) & ~((size_t) HUGE_PAGE_SIZE - 1);
+    }
+
+    BM_FrameArena *arena = malloc(sizeof(BM_FrameArena));
+    arena->size = regionSize * numberOfRegions;
+    arena->memory = mapArenaMemory(arena->size, memory->options.hugePages);
+    if (arena->memory == NULL) {
+        free(arena);
+        // CHANGE RETURN CODE
+        return RC_WRITE_FAILED;
+    }
+    arena->next = memory->arenas;
+    memory->arenas = arena;
+
+    /* the whole arena can be used: rounding up to huge pages gives more pages than asked */
+    int pagesPerRegion = regionSize / PAGE_SIZE;
+    int newPages = pagesPerRegion * numberOfRegions;
+    memory->freePages = realloc(memory->freePages, sizeof(char *) * (memory->capacity + newPages));
+    memory->freePagesNode = realloc(memory->freePagesNode, sizeof(int) * (memory->capacity + newPages));
+
+    for (int region = 0; region < numberOfRegions; region++) {
+        char *regionStart = arena->memory + region * regionSize;
+        int node = -1;
+        if (memory->options.numaPolicy == BM_NUMA_INTERLEAVE) {
+            node = region;
+        } else if (memory->options.numaPolicy == BM_NUMA_BIND) {
+            node = memory->options.numaNode;
+        }
+        if (node != -1) {
+            bindMemoryToNode(regionStart, regionSize, node);
+        }
+        for (int i = 0; i < pagesPerRegion; i++) {
+            memory->freePages[memory->numberOfFreePages] = regionStart + i * PAGE_SIZE;
+            memory->freePagesNode[memory->numberOfFreePages] = node;
+            memory->numberOfFreePages++;
+        }
+    }
+    memory->capacity += newPages;
+    return RC_OK;
+}
+
+/*
+ * Create the memory for numberOfPages frames. options can be NULL for plain memory.
+ * Returns NULL if the memory can't be mapped.
+ */
+BM_FrameMemory *createFrameMemory(int numberOfPages, BM_MemoryOptions *options) {
+    BM_FrameMemory *memory = malloc(sizeof(BM_FrameMemory));
+    memory->options.hugePages = BM_HUGE_PAGES_NONE;
+    memory->options.numaPolicy = BM_NUMA_NONE;
+    memory->options.numaNode = 0;
+    if (options != NULL) {
+        memory->options = *options;
+    }
+    memory->numberOfNodes = countNumaNodes();
+    if (memory->options.numaNode < 0 || memory->options.numaNode >= memory->numberOfNodes) {
+        memory->options.numaNode = 0;
+    }
+    memory->arenas = NULL;
+    memory->freePages = NULL;
+    memory->freePagesNode = NULL;
+    memory->numberOfFreePages = 0;
+    memory->capacity = 0;
+    memory->nextFrameVersion = 0;
+
+    if (addFrameArena(memory, numberOfPages) != RC_OK) {
+        free(memory);
+        return NULL;
+    }
+    return memory;
+}
+
+/*
+ * Take a free page for a new frame, preferring one on the NUMA node of the calling thread.
+ * node is filled with the node of the page. Returns NULL if no page is free.
+ */
+char *takeFramePage(BM_FrameMemory *memory, int *node) {
+    if (memory->numberOfFreePages == 0) {
+        return NULL;
+    }
+    int chosen = memory->numberOfFreePages - 1;
+    if (memory->options.numaPolicy == BM_NUMA_INTERLEAVE) {
+        int localNode = currentNumaNode();
+        for (int i = memory->numberOfFreePages - 1; i >= 0; i--) {
+            if (memory->freePagesNode[i] == localNode) {
+                chosen = i;
+                break;
+            }
+        }
+    }
+
+    char *page = memory->freePages[chosen];
+    *node = memory->freePagesNode[chosen];
+    memory->numberOfFreePages--;
+    memory->freePages[chosen] = memory->freePages[memory->numberOfFreePages];
+    memory->freePagesNode[chosen] = memory->freePagesNode[memory->numberOfFreePages];
+    return page;
+}
+
+/*
+ * Give back the page of a frame removed from the pool, version is the last version of the frame. The page stays
+ * mapped, but its physical memory is given back to the system (unless it is part of a reserved huge page).
+ */
+void releaseFramePage(BM_FrameMemory *memory, char *page, int node, unsigned long version) {
+    if (memory->nextFrameVersion <= version) {
+        memory->nextFrameVersion = (version + 2) & ~1UL;
+    }
+#ifdef MADV_DONTNEED
+    if (memory->options.hugePages != BM_HUGE_PAGES_EXPLICIT) {
+        madvise(page, PAGE_SIZE, MADV_DONTNEED);
+    }
+#endif
+    memory->freePages[memory->numberOfFreePages] = page;
+    memory->freePagesNode[memory->numberOfFreePages] = node;
+    memory->numberOfFreePages++;
+}
+
+void freeFrameMemory(BM_FrameMemory *memory) {
+    while (memory->arenas != NULL) {
+        BM_FrameArena *next = memory->arenas->next;
+        munmap(memory->arenas->memory, memory->arenas->size);
+        free(memory->arenas);
+        memory->arenas = next;
+    }
+    free(memory->freePages);
+    free(memory->freePagesNode);
+    free(memory);
+}
+
+/*
+ * Keep memory that is no longer used by the pool until it is shut down, because an optimistic reader may still be
+ * looking at it (see readPageOptimistic).
+ */
+void retireMemory(BM_FramesHandle *framesHandle, void *memory) {
+    framesHandle->retired = realloc(framesHandle->retired, sizeof(void *) * (framesHandle->numberOfRetired + 1));
+    framesHandle->retired[framesHandle->numberOfRetired] = memory;
+    framesHandle->numberOfRetired++;
+}
+
+/*
+ * Allocate a frames array of numberOfFrames positions containing the frames of the current array that fit in it.
+ * The previous array is retired.
+ */
+void reallocFramesArray(BM_FramesHandle *framesHandle, int oldNumberOfFrames, int numberOfFrames) {
+    BM_FrameHandle **frames = malloc(sizeof(BM_FrameHandle *) * numberOfFrames);
+    for (int i = 0; i < numberOfFrames; i++) {
+        frames[i] = (i < oldNumberOfFrames) ? framesHandle->frames[i] : NULL;
+    }
+    retireMemory(framesHandle, framesHandle->frames);
+    framesHandle->frames = frames;
+}
+
+
+/*
+ * Find an empty position (i.e a NULL pointer) in the frames array, starting after the last pinned position so the
+ * array keeps being filled in order.
+ * Returns -1 if every position is used
+ */
+int findFreePosition(BM_BufferPool *const bm) {
+    BM_FramesHandle *framesHandle = (BM_FramesHandle *) bm->mgmtData;
+    for (int i = 1; i <= bm->numPages; i++) {
+        int position = (framesHandle->lastPinnedPosition + i) % bm->numPages;
+        if (framesHandle->frames[position] == NULL) {
+            return position;
+        }
+    }
+    return -1;
+}
 
 /*
  * Loop over the frames in order to find which one contains the page number pageNum and returns it
@@ -39,6 +426,587 @@ BM_FrameHandle *findFrameNumberN(BM_BufferPool *const bm, const PageNumber pageN
     return (BM_FrameHandle *) NULL;
 }
 
+// Page codecs
+
+int lzHash(const char *position) {
+    uint32_t sequence;
+    memcpy(&sequence, position, sizeof(uint32_t));
+    return (sequence * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+// The part of a length not fitting in the 4 bits of the token follows it, as bytes of 255 ended by a smaller one
+int lzWriteLength(unsigned char *out, int length) {
+    int written = 0;
+    while (length >= 255) {
+        out[written++] = 255;
+        length -= 255;
+    }
+    out[written++] = length;
+    return written;
+}
+
+/*
+ * Append to the outLength bytes of out a sequence: numberOfLiterals literals then a copy of matchLength bytes seen offset
+ * bytes before (matchLength is 0 for the last sequence, made of literals only).
+ * Returns the new length of out, -1 if it could reach PAGE_SIZE.
+ */
+int lzWriteSequence(unsigned char *out, int outLength, const char *literals, int numberOfLiterals, int offset,
+                    int matchLength) {
+    if (outLength + numberOfLiterals + numberOfLiterals / 255 + matchLength / 255 + 5 >= PAGE_SIZE) {
+        return -1;
+    }
+    unsigned char *token = out + outLength++;
+    int matchCode = matchLength == 0 ? 0 : matchLength - LZ_MIN_MATCH;
+    *token = (numberOfLiterals < 15 ? numberOfLiterals : 15) << 4 | (matchCode < 15 ? matchCode : 15);
+    if (numberOfLiterals >= 15) {
+        outLength += lzWriteLength(out + outLength, numberOfLiterals - 15);
+    }
+    memcpy(out + outLength, literals, numberOfLiterals);
+    outLength += numberOfLiterals;
+    if (matchLength == 0) {
+        return outLength;
+    }
+    out[outLength++] = offset & 0xff;
+    out[outLength++] = offset >> 8;
+    if (matchCode >= 15) {
+        outLength += lzWriteLength(out + outLength, matchCode - 15);
+    }
+    return outLength;
+}
+
+/*
+ * Encode page in out, returns the length of the encoding or -1 if it is not smaller than a page. The last position
+ * where each hash of 4 bytes was seen is the only candidate for a copy, as in LZ4.
+ */
+int lzEncodePage(const char *page, char *out) {
+    int positions[1 << LZ_HASH_BITS];
+    memset(positions, -1, sizeof(positions));
+    unsigned char *encoded = (unsigned char *) out;
+    int length = 0;
+    int anchor = 0; // first byte not encoded yet
+    int position = 0;
+    while (position <= PAGE_SIZE - LZ_MIN_MATCH) {
+        int hash = lzHash(page + position);
+        int candidate = positions[hash];
+        positions[hash] = position;
+        if (candidate == -1 || memcmp(page + candidate, page + position, LZ_MIN_MATCH) != 0) {
+            position++;
+            continue;
+        }
+        int matchLength = LZ_MIN_MATCH;
+        while (position + matchLength < PAGE_SIZE && page[candidate + matchLength] == page[position + matchLength]) {
+            matchLength++;
+        }
+        length = lzWriteSequence(encoded, length, page + anchor, position - anchor, position - candidate, matchLength);
+        if (length == -1) {
+            return -1;
+        }
+        position += matchLength;
+        anchor = position;
+    }
+    return lzWriteSequence(encoded, length, page + anchor, PAGE_SIZE - anchor, 0, 0);
+}
+
+// Read a length continued after the token, position is moved after it. Returns -1 if the encoding ends before it does.
+int lzReadLength(const unsigned char *encoded, int length, int *position) {
+    int value = 0;
+    int byte;
+    do {
+        if (*position >= length) {
+            return -1;
+        }
+        byte = encoded[(*position)++];
+        value += byte;
+    } while (byte == 255);
+    return value;
+}
+
+// Decode the length bytes of an encoded page, RC_BM_CORRUPTED_PAGE if they do not give exactly a page
+RC lzDecodePage(const char *in, int length, char *page) {
+    const unsigned char *encoded = (const unsigned char *) in;
+    int position = 0;
+    int pageLength = 0;
+    while (position < length) {
+        int token = encoded[position++];
+        int numberOfLiterals = token >> 4;
+        if (numberOfLiterals == 15) {
+            int extra = lzReadLength(encoded, length, &position);
+            if (extra == -1) {
+                return RC_BM_CORRUPTED_PAGE;
+            }
+            numberOfLiterals += extra;
+        }
+        if (position + numberOfLiterals > length || pageLength + numberOfLiterals > PAGE_SIZE) {
+            return RC_BM_CORRUPTED_PAGE;
+        }
+        memcpy(page + pageLength, encoded + position, numberOfLiterals);
+        position += numberOfLiterals;
+        pageLength += numberOfLiterals;
+        /* the last sequence has no copy */
+        if (position == length) {
+            break;
+        }
+
+        if (position + 2 > length) {
+            return RC_BM_CORRUPTED_PAGE;
+        }
+        int offset = encoded[position] | encoded[position + 1] << 8;
+        position += 2;
+        int matchLength = token & 15;
+        if (matchLength == 15) {
+            int extra = lzReadLength(encoded, length, &position);
+            if (extra == -1) {
+                return RC_BM_CORRUPTED_PAGE;
+            }
+            matchLength += extra;
+        }
+        matchLength += LZ_MIN_MATCH;
+        if (offset == 0 || offset > pageLength || pageLength + matchLength > PAGE_SIZE) {
+            return RC_BM_CORRUPTED_PAGE;
+        }
+        /* byte by byte: a copy can overlap the bytes it produces, this is how runs are encoded */
+        for (int i = 0; i < matchLength; i++) {
+            page[pageLength + i] = page[pageLength - offset + i];
+        }
+        pageLength += matchLength;
+    }
+    return pageLength == PAGE_SIZE ? RC_OK : RC_BM_CORRUPTED_PAGE;
+}
+
+// Encode page with codec in out (PAGE_SIZE bytes), returns the length stored: PAGE_SIZE when the page is kept as is
+int encodePage(BM_PageCodec codec, const char *page, char *out) {
+    int length = -1;
+    if (codec == BM_CODEC_LZ) {
+        length = lzEncodePage(page, out);
+    }
+    if (length == -1) {
+        memcpy(out, page, PAGE_SIZE);
+        return PAGE_SIZE;
+    }
+    return length;
+}
+
+RC decodePage(BM_PageCodec codec, const char *in, int length, char *page) {
+    if (length == 0) {
+        memset(page, 0, PAGE_SIZE);
+        return RC_OK;
+    }
+    if (length == PAGE_SIZE) {
+        memcpy(page, in, PAGE_SIZE);
+        return RC_OK;
+    }
+    if (codec == BM_CODEC_LZ) {
+        return lzDecodePage(in, length, page);
+    }
+    return RC_BM_CORRUPTED_PAGE;
+}
+
+// Compressed page files
+
+void ensureCompressedPages(BM_CompressedFile *file, int numberOfPages) {
+    if (numberOfPages <= file->numberOfPages) {
+        return;
+    }
+    if (numberOfPages > file->capacity) {
+        file->capacity = numberOfPages > 2 * file->capacity ? numberOfPages : 2 * file->capacity;
+        file->pages = realloc(file->pages, sizeof(BM_CompressedPage) * file->capacity);
+    }
+    for (int i = file->numberOfPages; i < numberOfPages; i++) {
+        file->pages[i].offset = 0;
+        file->pages[i].length = 0;
+    }
+    file->numberOfPages = numberOfPages;
+    file->changed = TRUE;
+}
+
+// Directory of an empty compressed page file of numberOfPages pages, none written yet
+BM_CompressedFile *createCompressedFile(BM_PageCodec codec, int numberOfPages) {
+    BM_CompressedFile *file = calloc(1, sizeof(BM_CompressedFile));
+    file->codec = codec;
+    file->end = PAGE_SIZE;
+    file->committed = PAGE_SIZE;
+    file->sequence = -1;
+    ensureCompressedPages(file, numberOfPages);
+    return file;
+}
+
+void freeCompressedFile(BM_CompressedFile *file) {
+    if (file == NULL) {
+        return;
+    }
+    free(file->pages);
+    free(file);
+}
+
+// Offset of the trailer slot of the directory numbered sequence, the slots are used in turn
+long compressedTrailerOffset(int sequence) {
+    return COMPRESSED_TRAILERS_OFFSET + (long) (sequence % 2) * COMPRESSED_TRAILER_SIZE;
+}
+
+/*
+ * Directory of the page file of fh if it is a compressed page file, NULL for a plain page file (no trailer slot of its
+ * reserved page points to a directory inside the file). The bytes after the directory in use, written before a crash,
+ * are dead.
+ */
+BM_CompressedFile *readCompressedFile(SM_FileHandle *fh) {
+    long size = getFileSize(fh);
+    char trailers[2 * COMPRESSED_TRAILER_SIZE];
+    if (size < PAGE_SIZE || readBytes(COMPRESSED_TRAILERS_OFFSET, 2 * COMPRESSED_TRAILER_SIZE, fh, trailers) != RC_OK) {
+        return NULL;
+    }
+    long directoryOffset = 0;
+    int numberOfPages = 0, codec = 0, sequence = -1;
+    for (int i = 0; i < 2; i++) {
+        char *trailer = trailers + i * COMPRESSED_TRAILER_SIZE;
+        long slotDirectoryOffset;
+        int slotNumberOfPages, slotCodec, slotSequence, magic;
+        memcpy(&slotDirectoryOffset, trailer, sizeof(long));
+        memcpy(&slotNumberOfPages, trailer + sizeof(long), sizeof(int));
+        memcpy(&slotCodec, trailer + sizeof(long) + sizeof(int), sizeof(int));
+        memcpy(&slotSequence, trailer + sizeof(long) + 2 * sizeof(int), sizeof(int));
+        memcpy(&magic, trailer + sizeof(long) + 3 * sizeof(int), sizeof(int));
+        if (magic == COMPRESSED_FILE_MAGIC && slotSequence > sequence && slotSequence % 2 == i
+            && slotNumberOfPages >= 0 && slotDirectoryOffset >= PAGE_SIZE
+            && slotDirectoryOffset + (long) (slotNumberOfPages * COMPRESSED_ENTRY_SIZE) <= size) {
+            directoryOffset = slotDirectoryOffset;
+            numberOfPages = slotNumberOfPages;
+            codec = slotCodec;
+            sequence = slotSequence;
+        }
+    }
+    if (sequence < 0) {
+        return NULL;
+    }
+
+    long directoryLength = (long) numberOfPages * COMPRESSED_ENTRY_SIZE;
+    char *directory = malloc(directoryLength + 1);
+    if (readBytes(directoryOffset, directoryLength, fh, directory) != RC_OK) {
+        free(directory);
+        return NULL;
+    }
+    BM_CompressedFile *file = createCompressedFile(codec, numberOfPages);
+    long liveBytes = 0;
+    for (int i = 0; i < numberOfPages; i++) {
+        memcpy(&file->pages[i].offset, directory + i * COMPRESSED_ENTRY_SIZE, sizeof(long));
+        memcpy(&file->pages[i].length, directory + i * COMPRESSED_ENTRY_SIZE + sizeof(long), sizeof(int));
+        liveBytes += file->pages[i].length;
+    }
+    free(directory);
+    file->end = size;
+    file->committed = size;
+    file->directoryLength = directoryLength;
+    file->deadBytes = size - PAGE_SIZE - liveBytes - directoryLength;
+    file->sequence = sequence;
+    file->changed = FALSE;
+    return file;
+}
+
+// Write the encoding of page pageNum at the end of the file
+RC appendCompressedPage(BM_CompressedFile *file, SM_FileHandle *fh, int pageNum, char *encoded, int length) {
+    BM_CompressedPage *page = &file->pages[pageNum];
+    page->offset = file->end;
+    page->length = length;
+    file->end += length;
+    file->changed = TRUE;
+    return writeBytes(page->offset, length, fh, encoded);
+}
+
+/*
+ * Append the directory of file and point the other trailer slot to it, syncing the file before each step so the trailer
+ * never points to bytes not on the disk yet. A crash at any point leaves the file as of the previous directory.
+ */
+RC commitCompressedDirectory(BM_CompressedFile *file, SM_FileHandle *fh) {
+    long directoryLength = (long) file->numberOfPages * COMPRESSED_ENTRY_SIZE;
+    char *directory = malloc(directoryLength + 1);
+    for (int i = 0; i < file->numberOfPages; i++) {
+        memcpy(directory + i * COMPRESSED_ENTRY_SIZE, &file->pages[i].offset, sizeof(long));
+        memcpy(directory + i * COMPRESSED_ENTRY_SIZE + sizeof(long), &file->pages[i].length, sizeof(int));
+    }
+    char trailer[COMPRESSED_TRAILER_SIZE];
+    int codec = file->codec;
+    int sequence = file->sequence + 1;
+    int magic = COMPRESSED_FILE_MAGIC;
+    memcpy(trailer, &file->end, sizeof(long));
+    memcpy(trailer + sizeof(long), &file->numberOfPages, sizeof(int));
+    memcpy(trailer + sizeof(long) + sizeof(int), &codec, sizeof(int));
+    memcpy(trailer + sizeof(long) + 2 * sizeof(int), &sequence, sizeof(int));
+    memcpy(trailer + sizeof(long) + 3 * sizeof(int), &magic, sizeof(int));
+
+    RC rc = writeBytes(file->end, directoryLength, fh, directory);
+    free(directory);
+    if (rc == RC_OK) {
+        rc = syncPageFile(fh);
+    }
+    if (rc == RC_OK) {
+        rc = writeBytes(compressedTrailerOffset(sequence), COMPRESSED_TRAILER_SIZE, fh, trailer);
+    }
+    if (rc == RC_OK) {
+        rc = syncPageFile(fh);
+    }
+    if (rc != RC_OK) {
+        return RC_WRITE_FAILED;
+    }
+    file->deadBytes += file->directoryLength;
+    file->directoryLength = directoryLength;
+    file->end += directoryLength;
+    file->committed = file->end;
+    file->sequence = sequence;
+    file->changed = FALSE;
+    return RC_OK;
+}
+
+// Drop a copy that is not completed, its file is removed
+void discardCompressedCopy(SM_FileHandle *copy) {
+    char *copyName = copy->fileName;
+    closePageFile(copy);
+    destroyPageFile(copyName);
+    free(copyName);
+}
+
+/*
+ * Start the copy a compressed page file is rewritten in, next to the page file of fh: it holds the reserved page
+ * without the trailers. The copy is then completed with replaceWithCompressedCopy or dropped with
+ * discardCompressedCopy, which free its name.
+ */
+RC createCompressedCopy(SM_FileHandle *fh, SM_FileHandle *copy) {
+    char reserved[PAGE_SIZE];
+    if (readBytes(0, PAGE_SIZE, fh, reserved) != RC_OK) {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    memset(reserved + COMPRESSED_TRAILERS_OFFSET, 0, 2 * COMPRESSED_TRAILER_SIZE);
+    char *copyName = malloc(strlen(fh->fileName) + strlen(".new") + 1);
+    strcpy(copyName, fh->fileName);
+    strcat(copyName, ".new");
+    if (createPageFile(copyName) != RC_OK || openPageFile(copyName, copy) != RC_OK) {
+        free(copyName);
+        return RC_WRITE_FAILED;
+    }
+    if (writeBytes(0, PAGE_SIZE, copy, reserved) != RC_OK || truncateBytes(PAGE_SIZE, copy) != RC_OK) {
+        discardCompressedCopy(copy);
+        return RC_WRITE_FAILED;
+    }
+    return RC_OK;
+}
+
+/*
+ * Write the directory of file, whose pages were appended to copy, and rename copy over the page file of fh. fh is
+ * reopened on it. A crash before the rename leaves the old page file as it was.
+ */
+RC replaceWithCompressedCopy(BM_CompressedFile *file, SM_FileHandle *fh, SM_FileHandle *copy) {
+    if (commitCompressedDirectory(file, copy) != RC_OK) {
+        discardCompressedCopy(copy);
+        return RC_WRITE_FAILED;
+    }
+    char *copyName = copy->fileName;
+    closePageFile(copy);
+    if (renamePageFile(copyName, fh->fileName) != RC_OK) {
+        destroyPageFile(copyName);
+        free(copyName);
+        return RC_WRITE_FAILED;
+    }
+    free(copyName);
+    closePageFile(fh);
+    return openPageFile(fh->fileName, fh);
+}
+
+/*
+ * Rewrite the page file of fh with the encoded pages next to each other after the reserved page, dropping the dead
+ * bytes. The pages are copied one at a time, the copy replaces the page file once complete.
+ */
+RC compactCompressedFile(BM_CompressedFile *file, SM_FileHandle *fh) {
+    SM_FileHandle copy;
+    if (createCompressedCopy(fh, &copy) != RC_OK) {
+        return RC_WRITE_FAILED;
+    }
+    BM_CompressedFile *compacted = createCompressedFile(file->codec, file->numberOfPages);
+    char encoded[PAGE_SIZE];
+    RC rc = RC_OK;
+    for (int i = 0; rc == RC_OK && i < file->numberOfPages; i++) {
+        BM_CompressedPage *page = &file->pages[i];
+        if (page->length > 0 && readBytes(page->offset, page->length, fh, encoded) != RC_OK) {
+            rc = RC_READ_NON_EXISTING_PAGE;
+        } else {
+            rc = appendCompressedPage(compacted, &copy, i, encoded, page->length);
+        }
+    }
+    if (rc != RC_OK) {
+        discardCompressedCopy(&copy);
+    } else {
+        rc = replaceWithCompressedCopy(compacted, fh, &copy);
+    }
+    if (rc == RC_OK) {
+        free(file->pages);
+        *file = *compacted;
+        free(compacted);
+    } else {
+        freeCompressedFile(compacted);
+    }
+    return rc;
+}
+
+/*
+ * Make the pages written since the last directory durable. The file is compacted instead when the dead bytes outweigh
+ * the live ones.
+ */
+RC writeCompressedDirectory(BM_CompressedFile *file, SM_FileHandle *fh) {
+    if (!file->changed) {
+        return RC_OK;
+    }
+    if (file->deadBytes > file->end - PAGE_SIZE - file->deadBytes) {
+        return compactCompressedFile(file, fh);
+    }
+    return commitCompressedDirectory(file, fh);
+}
+
+/*
+ * Read page pageNum of the file of the pool in data, the file is extended if the page does not exist yet. The pages of a
+ * compressed page file are decoded.
+ */
+RC readPoolPage(BM_BufferPool *const bm, SM_FileHandle *fh, const PageNumber pageNum, char *data) {
+    BM_CompressedFile *file = ((BM_FramesHandle *) bm->mgmtData)->compressedFile;
+    if (file == NULL) {
+        ensureCapacity(pageNum + 1, fh); // +1 because pages are numbered started from 0
+        RC rc = readBlock(pageNum, fh, data);
+        if (rc == RC_OK) {
+            bm->numberOfReadBytes += PAGE_SIZE;
+        }
+        return rc;
+    }
+
+    ensureCompressedPages(file, pageNum + 1);
+    BM_CompressedPage *page = &file->pages[pageNum];
+    char encoded[PAGE_SIZE];
+    if (page->length > 0 && readBytes(page->offset, page->length, fh, encoded) != RC_OK) {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    bm->numberOfReadBytes += page->length;
+    return decodePage(file->codec, encoded, page->length, data);
+}
+
+/*
+ * Write data as page pageNum of the file of the pool, encoded for a compressed page file. The before write hook of the
+ * pool is called first, the page is not written if it fails.
+ */
+RC writePoolPage(BM_BufferPool *const bm, SM_FileHandle *fh, const PageNumber pageNum, char *data) {
+    BM_FramesHandle *frames = bm->mgmtData;
+    if (frames->beforeWrite != NULL && frames->beforeWrite(frames->beforeWriteData, pageNum, data) != RC_OK) {
+        return RC_WRITE_FAILED;
+    }
+    BM_CompressedFile *file = frames->compressedFile;
+    if (file == NULL) {
+        return writeBlock(pageNum, fh, data);
+    }
+
+    ensureCompressedPages(file, pageNum + 1);
+    char encoded[PAGE_SIZE];
+    int length = encodePage(file->codec, data, encoded);
+    BM_CompressedPage *page = &file->pages[pageNum];
+    if (page->offset >= file->committed && length <= page->length) {
+        /* appended after the directory in use, which does not point to it */
+        file->deadBytes += page->length - length;
+        page->length = length;
+        file->changed = TRUE;
+        return writeBytes(page->offset, length, fh, encoded);
+    }
+    file->deadBytes += page->length;
+    return appendCompressedPage(file, fh, pageNum, encoded, length);
+}
+
+/*
+ * Rewrite a plain page file with its pages encoded with codec. They are written in a copy of the file, which replaces
+ * it once complete. A compressed page file is left as it is.
+ */
+RC compressPageFile(char *fileName, BM_PageCodec codec) {
+    SM_FileHandle fh;
+    if (openPageFile(fileName, &fh) != RC_OK) {
+        return RC_FILE_NOT_FOUND;
+    }
+    BM_CompressedFile *file = readCompressedFile(&fh);
+    if (file != NULL) {
+        freeCompressedFile(file);
+        closePageFile(&fh);
+        return RC_OK;
+    }
+    SM_FileHandle copy;
+    if (createCompressedCopy(&fh, &copy) != RC_OK) {
+        closePageFile(&fh);
+        return RC_WRITE_FAILED;
+    }
+
+    file = createCompressedFile(codec, fh.totalNumPages);
+    char page[PAGE_SIZE];
+    char encoded[PAGE_SIZE];
+    RC rc = RC_OK;
+    for (int i = 0; rc == RC_OK && i < fh.totalNumPages; i++) {
+        rc = readBlock(i, &fh, page);
+        if (rc == RC_OK) {
+            rc = appendCompressedPage(file, &copy, i, encoded, encodePage(codec, page, encoded));
+        }
+    }
+    if (rc == RC_OK) {
+        rc = replaceWithCompressedCopy(file, &fh, &copy);
+    } else {
+        discardCompressedCopy(&copy);
+    }
+    freeCompressedFile(file);
+    closePageFile(&fh);
+    return rc;
+}
+
+// beforeWrite replaces the hook of the pool, NULL removes it
+RC setBeforeWriteHook(BM_BufferPool *const bm, BM_BeforeWriteHook beforeWrite, void *hookData) {
+    lockPool(bm);
+    BM_FramesHandle *frames = bm->mgmtData;
+    frames->beforeWrite = beforeWrite;
+    frames->beforeWriteData = hookData;
+    unlockPool(bm);
+    return RC_OK;
+}
+
+/*
+ * Evict the content of frame (writing it on disk if it is dirty) and put the page read in page->data in it instead.
+ * The page is copied in the frame's own memory so that the memory of a frame is never freed while the pool is alive,
+ * optimistic readers can then always look at it safely. page->data is updated to point to the frame.
+ */
+RC replaceFrameContent(BM_BufferPool *const bm, BM_FrameHandle *frame, BM_PageHandle *const page, SM_FileHandle *fh) {
+    BM_FramesHandle *framesHandle = (BM_FramesHandle *) bm->mgmtData;
+    struct timeval tv;
+
+    /*
+     * odd while the frame changes page: optimistic readers see a write in progress. The fence keeps the odd version
+     * visible before any byte of the new page.
+     */
+    bool wasEven = (frame->version & 1) == 0;
+    if (wasEven) {
+        __atomic_add_fetch(&frame->version, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+    if (frame->isDirty == TRUE) {
+        if (writePoolPage(bm, fh, frame->page->pageNum, frame->page->data) != RC_OK) {
+            if (wasEven) {
+                __atomic_add_fetch(&frame->version, 1, __ATOMIC_RELEASE);
+            }
+            return RC_WRITE_FAILED;
+        }
+        bm->numberOfWriteIO++;
+    }
+    memcpy(frame->page->data, page->data, PAGE_SIZE);
+    free(page->data);
+    page->data = frame->page->data;
+    frame->page->pageNum = page->pageNum;
+
+    /* even again once the data and the page number are stored, readers of the old page fail their validation */
+    __atomic_add_fetch(&frame->version, 1, __ATOMIC_RELEASE);
+    frame->fixCount = 1;
+    frame->isDirty = 0;
+    gettimeofday(&tv, NULL);
+    frame->lastAccess = tv.tv_usec;
+
+    framesHandle->lastPinnedPosition = frame->positionInFramesArray;
+    closePageFile(fh);
+    return RC_OK;
+}
+
 /*
  * Taking a buffer pool, page handle already initialized (i.e pageNum and data are correct) finds a frame in the buffer
  * pool to store the information.
@@ -51,21 +1019,7 @@ RC fifoReplacement(BM_BufferPool *const bm, BM_PageHandle *const page, SM_FileHa
         BM_FrameHandle *frame = framesHandle->frames[position];
         /* The frame can be evicted */
         if (frame->fixCount == 0) {
-            if (frame->isDirty == TRUE) {
-                if (writeBlock(frame->page->pageNum, &fh, frame->page->data) != RC_OK)
-                    return RC_WRITE_FAILED;
-                bm->numberOfWriteIO++;
-            }
-            free(frame->page->data);
-            frame->page->data = page->data;
-            frame->page->pageNum = page->pageNum;
-            frame->fixCount = 1;
-            frame->isDirty = 0;
-            time(&frame->lastAccess);
-            frame->positionInFramesArray = position;
-            framesHandle->lastPinnedPosition = position;
-            closePageFile(&fh);
-            return RC_OK;
+            return replaceFrameContent(bm, frame, page, &fh);
         }
     }
     // CHANGE RETURN CODE
@@ -79,92 +1033,214 @@ RC fifoReplacement(BM_BufferPool *const bm, BM_PageHandle *const page, SM_FileHa
  */
 RC lruReplacement(BM_BufferPool *const bm, BM_PageHandle *const page, SM_FileHandle fh) {
     BM_FramesHandle *framesHandle = (BM_FramesHandle *) bm->mgmtData;
-    BM_FrameHandle *leastRecentlyUsedFrame = framesHandle->frames[0];
+    BM_FrameHandle *leastRecentlyUsedFrame = NULL;
     for (int i =0; i < bm->numPages; i++) {
         BM_FrameHandle *frame = framesHandle->frames[i];
         /* Searching the least recently used frame from the one that can be evicted (i.e fixCount = 0) */
         if (frame->fixCount == 0) {
-            if (difftime(leastRecentlyUsedFrame->lastAccess, frame->lastAccess) >= 0) {
+            if (leastRecentlyUsedFrame == NULL || difftime(leastRecentlyUsedFrame->lastAccess, frame->lastAccess) >= 0) {
                 leastRecentlyUsedFrame = frame;
             }
         }
     }
 
-    /* Every frames are pinned at least once */
-    if (leastRecentlyUsedFrame->fixCount != 0){
-        // CHANGE RETURN CODE
+    /* Every frames are pinned at least once */
+    if (leastRecentlyUsedFrame == NULL){
+        // CHANGE RETURN CODE
+        return RC_WRITE_FAILED;
+    }
+
+    return replaceFrameContent(bm, leastRecentlyUsedFrame, page, &fh);
+}
+
+/*
+ * Remember that pageNum has been loaded through the strategy. It takes the place of the ring entry that was
+ * just tried as a victim, so the ring keeps cycling over its own frames.
+ */
+void addPageToRing(BM_AccessStrategy *strategy, const PageNumber pageNum) {
+    strategy->ring[strategy->nextVictim] = pageNum;
+    strategy->nextVictim = (strategy->nextVictim + 1) % strategy->ringSize;
+}
+
+/*
+ * Taking a buffer pool, page handle already initialized (i.e pageNum and data are correct) puts the page in the
+ * frame holding the oldest page of the strategy ring.
+ * Only works once the ring is full and if that frame is still holding the ring page and is not pinned. Otherwise
+ * nothing is done and the caller falls back on the pool replacement strategy.
+ */
+RC ringReplacement(BM_BufferPool *const bm, BM_PageHandle *const page, SM_FileHandle fh,
+                   BM_AccessStrategy *strategy) {
+    PageNumber victimPage = strategy->ring[strategy->nextVictim];
+    if (victimPage == NO_PAGE) {
+        return RC_WRITE_FAILED;
+    }
+
+    BM_FrameHandle *frame = findFrameNumberN(bm, victimPage);
+    if (frame == NULL || frame->fixCount != 0) {
         return RC_WRITE_FAILED;
     }
 
-    if (leastRecentlyUsedFrame->isDirty == TRUE) {
-        if (writeBlock(leastRecentlyUsedFrame->page->pageNum, &fh, leastRecentlyUsedFrame->page->data) != RC_OK)
-            return RC_WRITE_FAILED;
-        bm->numberOfWriteIO++;
+    if (replaceFrameContent(bm, frame, page, &fh) != RC_OK) {
+        return RC_WRITE_FAILED;
     }
-    struct timeval tv;
-    free(leastRecentlyUsedFrame->page->data);
+    addPageToRing(strategy, page->pageNum);
+    return RC_OK;
+}
 
-    leastRecentlyUsedFrame->page->data = page->data;
-    leastRecentlyUsedFrame->page->pageNum = page->pageNum;
-    leastRecentlyUsedFrame->fixCount = 1;
-    leastRecentlyUsedFrame->isDirty = 0;
-    gettimeofday(&tv, NULL);
-    leastRecentlyUsedFrame->lastAccess = tv.tv_usec;
+void registerPoolInGovernor(BM_BufferPool *const bm) {
+    pthread_mutex_lock(&governor.lock);
+    governor.pools = realloc(governor.pools, sizeof(BM_GovernedPool) * (governor.numberOfPools + 1));
+    memset(&governor.pools[governor.numberOfPools], 0, sizeof(BM_GovernedPool));
+    governor.pools[governor.numberOfPools].pool = bm;
+    governor.numberOfPools++;
+    pthread_mutex_unlock(&governor.lock);
+}
 
-    framesHandle->lastPinnedPosition = leastRecentlyUsedFrame->positionInFramesArray;
-    closePageFile(&fh);
-    return RC_OK;
+void unregisterPoolFromGovernor(BM_BufferPool *const bm) {
+    pthread_mutex_lock(&governor.lock);
+    for (int i = 0; i < governor.numberOfPools; i++) {
+        if (governor.pools[i].pool == bm) {
+            governor.pools[i] = governor.pools[governor.numberOfPools - 1];
+            governor.numberOfPools--;
+            break;
+        }
+    }
+    if (governor.numberOfPools == 0) {
+        free(governor.pools);
+        governor.pools = NULL;
+    }
+    pthread_mutex_unlock(&governor.lock);
+}
+
+/*
+ * Marginal utility of one more frame for a pool: its misses since the last rebalancing divided by its number of frames.
+ * A pool with many misses for few frames is the one that would gain the most from new frames.
+ */
+double poolUtility(BM_GovernedPool *governedPool) {
+    int misses = governedPool->numberOfReadIO - governedPool->lastReadIO;
+    return (double) misses / governedPool->numPages;
+}
+
+/*
+ * Read what the governor needs of a pool under its lock, other threads change it meanwhile.
+ * A held pool is neither a donor nor a receiver of the governor. Its frames still count in the budget, the frames it
+ * got for a while included, so the other pools can shrink until it is released.
+ */
+void readGovernedPool(BM_GovernedPool *governedPool) {
+    BM_BufferPool *pool = governedPool->pool;
+    BM_FramesHandle *frames = (BM_FramesHandle *) pool->mgmtData;
+    lockPool(pool);
+    governedPool->numPages = pool->numPages;
+    governedPool->numberOfReadIO = pool->numberOfReadIO;
+    governedPool->minFrames = frames->minFrames;
+    governedPool->held = frames->sizeHolds != 0;
+    unlockPool(pool);
+}
+
+// a pool the governor can take frames from
+bool canShrink(BM_GovernedPool *governedPool) {
+    return !governedPool->held && governedPool->numPages > governedPool->minFrames;
 }
 
 // Buffer Manager Interface Pool Handling
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
                   const int numPages, ReplacementStrategy strategy,
                   void *stratData) {
+    return initBufferPoolWithMemoryOptions(bm, pageFileName, numPages, strategy, stratData, NULL);
+}
+
+/*
+ * Same as initBufferPool, options tells how the memory of the frames is allocated (huge pages, NUMA placement).
+ * options can be NULL for plain memory.
+ */
+RC initBufferPoolWithMemoryOptions(BM_BufferPool *const bm, const char *const pageFileName,
+                                   const int numPages, ReplacementStrategy strategy,
+                                   void *stratData, BM_MemoryOptions *options) {
     // CHECK IF FILE EXISTS
     if (access(pageFileName, F_OK) == 0) {
         // file exists
+        BM_FrameMemory *memory = createFrameMemory(numPages, options);
+        if (memory == NULL) {
+            // CHANGE RETURN CODE
+            return RC_WRITE_FAILED;
+        }
         initStorageManager();
         bm->pageFile = pageFileName;
         bm->numPages = numPages;
         bm->mgmtData = createFrames(numPages);
+        ((BM_FramesHandle *) bm->mgmtData)->memory = memory;
+        SM_FileHandle fh;
+        if (openPageFile((char *) pageFileName, &fh) == RC_OK) {
+            ((BM_FramesHandle *) bm->mgmtData)->compressedFile = readCompressedFile(&fh);
+            closePageFile(&fh);
+        }
         bm->strategy = strategy;
         bm->numberOfReadIO = 0;
         bm->numberOfWriteIO = 0;
+        bm->numberOfHits = 0;
+        bm->numberOfReadBytes = 0;
+        registerPoolInGovernor(bm);
 
         return RC_OK;
     }
     return RC_FILE_NOT_FOUND;
 }
 
+// TRUE if a page of the pool is pinned, the lock of the pool must be held
+bool hasPinnedPages(BM_BufferPool *const bm) {
+    BM_FramesHandle *frames = bm->mgmtData;
+    for (int i = 0; i < bm->numPages; i++) {
+        if (frames->frames[i] != NULL && frames->frames[i]->fixCount != 0) {
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
 RC shutdownBufferPool(BM_BufferPool *const bm) {
+    // a pool with a pinned page is left as it is: still governed, nothing written or freed
+    lockPool(bm);
+    bool pinned = hasPinnedPages(bm);
+    unlockPool(bm);
+    if (pinned) {
+        //CHANGE RETURN CODE
+        return RC_WRITE_FAILED;
+    }
     char *filename = (char *) bm->pageFile;
     SM_FileHandle fh;
     if (openPageFile(filename, &fh) != RC_OK) {
         return RC_FILE_NOT_FOUND;
     }
+    unregisterPoolFromGovernor(bm);
     BM_FramesHandle *frames = bm->mgmtData;
     for (int i = 0; i < bm->numPages; i++) {
         BM_FrameHandle *frame = frames->frames[i];
         if (frame != NULL) {
-            if (frame->fixCount != 0) {
-                //CHANGE RETURN CODE
-                return RC_WRITE_FAILED;
-            }
             if (frame->isDirty == TRUE) {
-                writeBlock(frame->page->pageNum, &fh, frame->page->data);
+                writePoolPage(bm, &fh, frame->page->pageNum, frame->page->data);
             }
-            free(frame->page->data);
             free(frame->page);
             free(frame);
         }
     }
+    if (frames->compressedFile != NULL) {
+        writeCompressedDirectory(frames->compressedFile, &fh);
+        freeCompressedFile(frames->compressedFile);
+    }
+    for (int i = 0; i < frames->numberOfRetired; i++) {
+        free(frames->retired[i]);
+    }
+    free(frames->retired);
+    freeFrameMemory(frames->memory);
+    pthread_mutex_destroy((pthread_mutex_t *) frames->lock);
+    free(frames->lock);
     free(frames->frames);
     free(frames);
     closePageFile(&fh);
     return RC_OK;
 }
 
-RC forceFlushPool(BM_BufferPool *const bm) {
+RC forceFlushPoolLocked(BM_BufferPool *const bm) {
     char *filename = (char *) bm->pageFile;
     SM_FileHandle fh;
     if (openPageFile(filename, &fh) != RC_OK) {
@@ -175,40 +1251,402 @@ RC forceFlushPool(BM_BufferPool *const bm) {
         BM_FrameHandle *frame = frames->frames[i];
         if (frame != NULL) {
             if (frame->isDirty == TRUE) {
-                writeBlock(frame->page->pageNum, &fh, frame->page->data);
+                writePoolPage(bm, &fh, frame->page->pageNum, frame->page->data);
                 frame->isDirty = FALSE;
                 bm->numberOfWriteIO++;
             }
         }
     }
+    /* the directory of a compressed page file is only written here and at shutdown, forcePage does not write it */
+    RC rc = RC_OK;
+    if (frames->compressedFile != NULL) {
+        rc = writeCompressedDirectory(frames->compressedFile, &fh);
+    }
+    closePageFile(&fh);
+    return rc;
+}
+
+RC forceFlushPool(BM_BufferPool *const bm) {
+    lockPool(bm);
+    RC rc = forceFlushPoolLocked(bm);
+    unlockPool(bm);
+    return rc;
+}
+
+/*
+ * Take frame out of the pool without writing it, its page goes back to the frame memory. Optimistic readers of the frame
+ * fail their validation.
+ */
+void removeFrame(BM_FramesHandle *framesHandle, BM_FrameHandle *frame) {
+    framesHandle->frames[frame->positionInFramesArray] = NULL;
+    framesHandle->actualUsedFrames--;
+    __atomic_add_fetch(&frame->version, 2, __ATOMIC_RELEASE);
+    releaseFramePage((BM_FrameMemory *) framesHandle->memory, frame->page->data, frame->numaNode, frame->version);
+    retireMemory(framesHandle, frame->page);
+    retireMemory(framesHandle, frame);
+}
+
+/*
+ * Grow or shrink the pool to newNumPages frames without shutting it down.
+ * When shrinking, the least recently used unpinned frames are evicted (and written to disk if dirty) until the
+ * remaining frames fit, then they are moved to the first positions of the frames array.
+ * Returns RC_BM_PAGES_STILL_PINNED if there are more pinned pages than newNumPages, the pool is left untouched.
+ */
+RC resizeBufferPoolLocked(BM_BufferPool *const bm, const int newNumPages) {
+    BM_FramesHandle *framesHandle = (BM_FramesHandle *) bm->mgmtData;
+    if (newNumPages < 1) {
+        // CHANGE RETURN CODE
+        return RC_WRITE_FAILED;
+    }
+
+    if (newNumPages >= bm->numPages) {
+        BM_FrameMemory *memory = (BM_FrameMemory *) framesHandle->memory;
+        if (memory->capacity < newNumPages && addFrameArena(memory, newNumPages - memory->capacity) != RC_OK) {
+            // CHANGE RETURN CODE
+            return RC_WRITE_FAILED;
+        }
+        reallocFramesArray(framesHandle, bm->numPages, newNumPages);
+        bm->numPages = newNumPages;
+        return RC_OK;
+    }
+
+    int pinnedFrames = 0;
+    for (int i = 0; i < bm->numPages; i++) {
+        if (framesHandle->frames[i] != NULL && framesHandle->frames[i]->fixCount != 0) {
+            pinnedFrames++;
+        }
+    }
+    if (pinnedFrames > newNumPages) {
+        return RC_BM_PAGES_STILL_PINNED;
+    }
+
+    SM_FileHandle fh;
+    if (framesHandle->actualUsedFrames > newNumPages && openPageFile((char *) bm->pageFile, &fh) != RC_OK) {
+        return RC_FILE_NOT_FOUND;
+    }
+
+    /* Evicting the least recently used unpinned frames until the remaining ones fit */
+    while (framesHandle->actualUsedFrames > newNumPages) {
+        BM_FrameHandle *victim = NULL;
+        for (int i = 0; i < bm->numPages; i++) {
+            BM_FrameHandle *frame = framesHandle->frames[i];
+            if (frame != NULL && frame->fixCount == 0) {
+                if (victim == NULL || difftime(victim->lastAccess, frame->lastAccess) >= 0) {
+                    victim = frame;
+                }
+            }
+        }
+
+        if (victim->isDirty == TRUE) {
+            if (writePoolPage(bm, &fh, victim->page->pageNum, victim->page->data) != RC_OK) {
+                closePageFile(&fh);
+                return RC_WRITE_FAILED;
+            }
+            bm->numberOfWriteIO++;
+        }
+        removeFrame(framesHandle, victim);
+
+        if (framesHandle->actualUsedFrames == newNumPages) {
+            closePageFile(&fh);
+        }
+    }
+
+    /* Moving the frames at the end of the array in the free positions at the beginning */
+    int freePosition = 0;
+    for (int i = newNumPages; i < bm->numPages; i++) {
+        BM_FrameHandle *frame = framesHandle->frames[i];
+        if (frame != NULL) {
+            while (framesHandle->frames[freePosition] != NULL) {
+                freePosition++;
+            }
+            framesHandle->frames[freePosition] = frame;
+            framesHandle->frames[i] = NULL;
+            frame->positionInFramesArray = freePosition;
+        }
+    }
+
+    reallocFramesArray(framesHandle, bm->numPages, newNumPages);
+    if (framesHandle->lastPinnedPosition >= newNumPages) {
+        framesHandle->lastPinnedPosition = newNumPages - 1;
+    }
+    bm->numPages = newNumPages;
+    return RC_OK;
+}
+
+RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages) {
+    lockPool(bm);
+    RC rc = resizeBufferPoolLocked(bm, newNumPages);
+    unlockPool(bm);
+    return rc;
+}
+
+/*
+ * resizeBufferPool for the memory governor: the hold is checked again with the pool locked, as it can be taken after
+ * the governor chose the pool. Returns RC_BM_PAGES_STILL_PINNED, without resizing, if the pool is held.
+ */
+RC governorResizeBufferPool(BM_BufferPool *const bm, const int newNumPages) {
+    lockPool(bm);
+    RC rc = RC_BM_PAGES_STILL_PINNED;
+    if (((BM_FramesHandle *) bm->mgmtData)->sizeHolds == 0) {
+        rc = resizeBufferPoolLocked(bm, newNumPages);
+    }
+    unlockPool(bm);
+    return rc;
+}
+
+/*
+ * resizeBufferPool for the memory governor, the rebalancing goes on with the size and counters read again. Returns
+ * RC_BM_PAGES_STILL_PINNED, without resizing, if the pool is held.
+ */
+RC governorResize(BM_GovernedPool *governedPool, const int newNumPages) {
+    RC rc = governorResizeBufferPool(governedPool->pool, newNumPages);
+    readGovernedPool(governedPool);
+    return rc;
+}
+
+/*
+ * A caller growing the pool for a while (e.g. a parallel scan adding a frame per thread) holds it first, otherwise the
+ * governor could shrink it meanwhile or the caller could undo a resize of the governor when it shrinks it back.
+ */
+void holdBufferPoolSize(BM_BufferPool *const bm) {
+    lockPool(bm);
+    __atomic_add_fetch(&((BM_FramesHandle *) bm->mgmtData)->sizeHolds, 1, __ATOMIC_RELEASE);
+    unlockPool(bm);
+}
+
+void releaseBufferPoolSize(BM_BufferPool *const bm) {
+    lockPool(bm);
+    __atomic_sub_fetch(&((BM_FramesHandle *) bm->mgmtData)->sizeHolds, 1, __ATOMIC_RELEASE);
+    unlockPool(bm);
+}
+
+/*
+ * A pool whose user pins several pages at once (e.g. a record moving between two data pages and a free space map page)
+ * sets the number of frames it needs, so the governor never leaves it unable to pin them.
+ */
+RC setBufferPoolMinimum(BM_BufferPool *const bm, const int minFrames) {
+    if (minFrames < 1) {
+        // CHANGE RETURN CODE
+        return RC_WRITE_FAILED;
+    }
+    lockPool(bm);
+    ((BM_FramesHandle *) bm->mgmtData)->minFrames = minFrames;
+    unlockPool(bm);
+    return RC_OK;
+}
+
+/*
+ * Extend the page file of the pool to numberOfPages pages at once, for callers about to add many pages.
+ * Pinning a page after the end of the file also extends it, one page at a time.
+ */
+RC ensurePoolCapacity(BM_BufferPool *const bm, const int numberOfPages) {
+    SM_FileHandle fh;
+    lockPool(bm);
+    if (openPageFile((char *) bm->pageFile, &fh) != RC_OK) {
+        unlockPool(bm);
+        return RC_FILE_NOT_FOUND;
+    }
+    RC rc = RC_OK;
+    BM_CompressedFile *file = ((BM_FramesHandle *) bm->mgmtData)->compressedFile;
+    if (file != NULL) {
+        ensureCompressedPages(file, numberOfPages);
+    } else {
+        rc = ensureCapacity(numberOfPages, &fh);
+    }
+    closePageFile(&fh);
+    unlockPool(bm);
+    return rc;
+}
+
+/*
+ * Cut the page file of the pool to its first numberOfPages pages. The frames of the pages removed are dropped without
+ * being written. Returns RC_BM_PAGES_STILL_PINNED, without changing anything, if one of them is pinned.
+ */
+RC truncatePool(BM_BufferPool *const bm, const int numberOfPages) {
+    BM_FramesHandle *framesHandle = (BM_FramesHandle *) bm->mgmtData;
+    SM_FileHandle fh;
+    lockPool(bm);
+    for (int i = 0; i < bm->numPages; i++) {
+        BM_FrameHandle *frame = framesHandle->frames[i];
+        if (frame != NULL && frame->page->pageNum >= numberOfPages && frame->fixCount != 0) {
+            unlockPool(bm);
+            return RC_BM_PAGES_STILL_PINNED;
+        }
+    }
+    for (int i = 0; i < bm->numPages; i++) {
+        BM_FrameHandle *frame = framesHandle->frames[i];
+        if (frame != NULL && frame->page->pageNum >= numberOfPages) {
+            removeFrame(framesHandle, frame);
+        }
+    }
+    if (openPageFile((char *) bm->pageFile, &fh) != RC_OK) {
+        unlockPool(bm);
+        return RC_FILE_NOT_FOUND;
+    }
+    RC rc = RC_OK;
+    BM_CompressedFile *file = framesHandle->compressedFile;
+    if (file != NULL) {
+        /* the bytes of the pages removed are dropped when the file is compacted */
+        for (int i = numberOfPages; i < file->numberOfPages; i++) {
+            file->deadBytes += file->pages[i].length;
+        }
+        if (numberOfPages < file->numberOfPages) {
+            file->numberOfPages = numberOfPages;
+            file->changed = TRUE;
+        }
+    } else {
+        rc = truncatePageFile(numberOfPages, &fh);
+    }
     closePageFile(&fh);
+    unlockPool(bm);
+    return rc;
+}
+
+// Buffer Manager Interface Memory Governor
+
+/*
+ * Set the total number of frames all the pools can use together and rebalance the pools right away.
+ * 0 removes the budget, the pools then keep their size.
+ */
+RC setBufferPoolBudget(const int totalFrames) {
+    if (totalFrames < 0) {
+        // CHANGE RETURN CODE
+        return RC_WRITE_FAILED;
+    }
+    pthread_mutex_lock(&governor.lock);
+    governor.budget = totalFrames;
+    pthread_mutex_unlock(&governor.lock);
+    return rebalanceBufferPools();
+}
+
+/*
+ * Move frames between the registered pools according to their miss rates since the previous call:
+ * - if the pools use more frames than the budget, the pools with the lowest utility shrink until they fit.
+ * - unused frames of the budget go to the pool with the highest utility, if it had misses.
+ * - otherwise when the highest utility is more than twice the lowest one, an eighth of the frames of the lowest utility
+ *   pool are given to the highest utility one.
+ * Pools never go under their minimum (GOVERNOR_MIN_FRAMES unless set with setBufferPoolMinimum) and pinned pages are
+ * never evicted. Held pools are not resized.
+ */
+RC rebalanceBufferPoolsLocked(void) {
+    __atomic_store_n(&governor.readIOSinceRebalance, 0, __ATOMIC_RELAXED);
+    if (governor.budget == 0 || governor.numberOfPools == 0) {
+        return RC_OK;
+    }
+
+    int usedFrames = 0;
+    for (int i = 0; i < governor.numberOfPools; i++) {
+        readGovernedPool(&governor.pools[i]);
+        usedFrames += governor.pools[i].numPages;
+    }
+
+    /* over budget: shrinking the least useful pools first */
+    while (usedFrames > governor.budget) {
+        BM_GovernedPool *donor = NULL;
+        for (int i = 0; i < governor.numberOfPools; i++) {
+            BM_GovernedPool *candidate = &governor.pools[i];
+            if (canShrink(candidate) && (donor == NULL || poolUtility(candidate) < poolUtility(donor))) {
+                donor = candidate;
+            }
+        }
+        if (donor == NULL) {
+            break;
+        }
+        int newNumPages = donor->numPages - (usedFrames - governor.budget);
+        if (newNumPages < donor->minFrames) {
+            newNumPages = donor->minFrames;
+        }
+        int oldNumPages = donor->numPages;
+        if (governorResize(donor, newNumPages) != RC_OK) {
+            break;
+        }
+        usedFrames -= oldNumPages - donor->numPages;
+    }
+
+    BM_GovernedPool *receiver = NULL;
+    BM_GovernedPool *donor = NULL;
+    for (int i = 0; i < governor.numberOfPools; i++) {
+        BM_GovernedPool *candidate = &governor.pools[i];
+        if (candidate->held) {
+            continue;
+        }
+        if (receiver == NULL || poolUtility(candidate) > poolUtility(receiver)) {
+            receiver = candidate;
+        }
+        if (canShrink(candidate) && (donor == NULL || poolUtility(candidate) < poolUtility(donor))) {
+            donor = candidate;
+        }
+    }
+
+    if (usedFrames < governor.budget) {
+        if (receiver != NULL && poolUtility(receiver) > 0) {
+            governorResize(receiver, receiver->numPages + governor.budget - usedFrames);
+        }
+    } else if (donor != NULL && donor != receiver && poolUtility(receiver) > 2 * poolUtility(donor)) {
+        int step = donor->numPages / 8;
+        if (step < 1) {
+            step = 1;
+        }
+        if (donor->numPages - step < donor->minFrames) {
+            step = donor->numPages - donor->minFrames;
+        }
+        if (governorResize(donor, donor->numPages - step) == RC_OK) {
+            governorResize(receiver, receiver->numPages + step);
+        }
+    }
+
+    /* starting a new observation window, from the reads counted when the pools were last read */
+    for (int i = 0; i < governor.numberOfPools; i++) {
+        governor.pools[i].lastReadIO = governor.pools[i].numberOfReadIO;
+    }
     return RC_OK;
 }
 
+RC rebalanceBufferPools(void) {
+    pthread_mutex_lock(&governor.lock);
+    RC rc = rebalanceBufferPoolsLocked();
+    pthread_mutex_unlock(&governor.lock);
+    return rc;
+}
+
 // Buffer Manager Interface Access Pages
 RC markDirty(BM_BufferPool *const bm, BM_PageHandle *const page) {
+    lockPool(bm);
     BM_FrameHandle *foundFrame = findFrameNumberN(bm, page->pageNum);
     if (foundFrame != NULL) {
         foundFrame->isDirty = TRUE;
+        /* odd version: a write is in progress until the page is unpinned */
+        if ((foundFrame->version & 1) == 0) {
+            __atomic_add_fetch(&foundFrame->version, 1, __ATOMIC_RELEASE);
+        }
+        unlockPool(bm);
         return RC_OK;
     }
 
+    unlockPool(bm);
     // CHANGE RETURNED CODE
     return RC_WRITE_FAILED;
 }
 
 RC unpinPage(BM_BufferPool *const bm, BM_PageHandle *const page) {
+    lockPool(bm);
     BM_FrameHandle *foundFrame = findFrameNumberN(bm, page->pageNum);
     if (foundFrame != NULL) {
         foundFrame->fixCount--;
+        /* the last writer ends the write, with several pins the page stays odd until they are all gone */
+        if ((foundFrame->version & 1) == 1 && foundFrame->fixCount == 0) {
+            __atomic_add_fetch(&foundFrame->version, 1, __ATOMIC_RELEASE);
+        }
+        unlockPool(bm);
         return RC_OK;
     }
 
+    unlockPool(bm);
     // CHANGE RETURNED CODE
     return RC_WRITE_FAILED;
 }
 
-RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page) {
+RC forcePageLocked(BM_BufferPool *const bm, BM_PageHandle *const page) {
     BM_FrameHandle *foundFrame = findFrameNumberN(bm, page->pageNum);
     if (foundFrame != NULL) {
 
@@ -218,7 +1656,7 @@ RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page) {
             return RC_FILE_NOT_FOUND;
         }
 
-        if (writeBlock(page->pageNum, &fh, foundFrame->page->data) != RC_OK) {
+        if (writePoolPage(bm, &fh, page->pageNum, foundFrame->page->data) != RC_OK) {
             return RC_WRITE_FAILED;
         }
         bm->numberOfWriteIO++;
@@ -231,8 +1669,20 @@ RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page) {
     return RC_WRITE_FAILED;
 }
 
+RC forcePage(BM_BufferPool *const bm, BM_PageHandle *const page) {
+    lockPool(bm);
+    RC rc = forcePageLocked(bm, page);
+    unlockPool(bm);
+    return rc;
+}
+
 RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page,
            const PageNumber pageNum) {
+    return pinPageWithStrategy(bm, page, pageNum, NULL);
+}
+
+RC pinPageLocked(BM_BufferPool *const bm, BM_PageHandle *const page,
+                 const PageNumber pageNum, BM_AccessStrategy *strategy) {
 
     BM_FramesHandle *framesHandle = (BM_FramesHandle *) bm->mgmtData;
     BM_FrameHandle *foundFrame = findFrameNumberN(bm, pageNum);
@@ -246,6 +1696,7 @@ RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page,
         gettimeofday(&tv, NULL);
         foundFrame->lastAccess = tv.tv_usec;
         framesHandle->lastPinnedPosition = foundFrame->positionInFramesArray;
+        bm->numberOfHits++;
         return RC_OK;
     }
 
@@ -255,67 +1706,186 @@ RC pinPage(BM_BufferPool *const bm, BM_PageHandle *const page,
     if (openPageFile(filename, &fh) != RC_OK) {
         return RC_FILE_NOT_FOUND;
     }
-    ensureCapacity(pageNum + 1, &fh); // +1 because pages are numbered started from 0
-
     page->data = malloc(PAGE_SIZE);
 
 
-    RC read = readBlock(pageNum, &fh, page->data);
+    RC read = readPoolPage(bm, &fh, pageNum, page->data);
     if (read != RC_OK) {
         free(page->data);
         closePageFile(&fh);
         return read;
     }
     bm->numberOfReadIO++;
+    __atomic_add_fetch(&governor.readIOSinceRebalance, 1, __ATOMIC_RELAXED);
 
     page->pageNum = pageNum;
 
+    /* A bulk read strategy recycles the frames of its own ring before touching the rest of the pool */
+    if (strategy != NULL && ringReplacement(bm, page, fh, strategy) == RC_OK) {
+        return RC_OK;
+    }
+
+    RC placed = RC_WRITE_FAILED;
+
     /* Looking if we still have place in the frames */
     if (framesHandle->actualUsedFrames < bm->numPages) {
-        int availablePosition = framesHandle->lastPinnedPosition + 1;
+        int availablePosition = findFreePosition(bm);
 
+        BM_FrameMemory *memory = (BM_FrameMemory *) framesHandle->memory;
         BM_FrameHandle *frame = malloc(sizeof(BM_FrameHandle));
         frame->page = malloc(sizeof(BM_PageHandle));
 
-        frame->page->data = page->data;
+        /* the frame gets its own page memory, the page read from disk is copied in it */
+        frame->page->data = takeFramePage(memory, &frame->numaNode);
+        memcpy(frame->page->data, page->data, PAGE_SIZE);
+        free(page->data);
+        page->data = frame->page->data;
         frame->fixCount = 1;
         frame->isDirty = FALSE;
         frame->positionInFramesArray = availablePosition;
         frame->page->pageNum = pageNum;
+        frame->version = memory->nextFrameVersion;
+        memory->nextFrameVersion += 2;
         gettimeofday(&tv, NULL);
         frame->lastAccess = tv.tv_usec;
         framesHandle->frames[availablePosition] = frame;
         framesHandle->actualUsedFrames++;
         framesHandle->lastPinnedPosition = availablePosition;
         closePageFile(&fh);
-        return RC_OK;
+        placed = RC_OK;
+    } else {
+        /* If we don't have any place */
+        switch (bm->strategy) {
+            case RS_FIFO:
+                placed = fifoReplacement(bm, page, fh);
+                break;
+            case RS_CLOCK:
+                break;
+            case RS_LRU:
+                placed = lruReplacement(bm, page, fh);
+                break;
+            case RS_LFU:
+                break;
+            case RS_LRU_K:
+                break;
+            default:
+                break;
+        }
     }
 
-    /* If we don't have any place */
-
-    switch (bm->strategy) {
-        case RS_FIFO:
-            return fifoReplacement(bm, page, fh);
-        case RS_CLOCK:
-            break;
-        case RS_LRU:
-            return lruReplacement(bm, page, fh);
-        case RS_LFU:
-            break;
-        case RS_LRU_K:
-            break;
-        default:
-            // CHANGE RETURN CODE
-            return RC_WRITE_FAILED;
+    if (placed == RC_OK) {
+        if (strategy != NULL) {
+            addPageToRing(strategy, pageNum);
+        }
+        return RC_OK;
     }
 
-
     /*We didn't find any evicable page */
     // CHANGE RETURN CODE
+    free(page->data);
     closePageFile(&fh);
     return RC_WRITE_FAILED;
 }
 
+/*
+ * The automatic rebalancing of the governor is done once the lock of the pool is released, as the governor may resize
+ * this pool.
+ */
+RC pinPageWithStrategy(BM_BufferPool *const bm, BM_PageHandle *const page,
+                       const PageNumber pageNum, BM_AccessStrategy *strategy) {
+    lockPool(bm);
+    RC rc = pinPageLocked(bm, page, pageNum, strategy);
+    unlockPool(bm);
+    if (rc == RC_OK && governor.budget != 0 &&
+        __atomic_load_n(&governor.readIOSinceRebalance, __ATOMIC_RELAXED) >= GOVERNOR_REBALANCE_INTERVAL) {
+        rebalanceBufferPools();
+    }
+    return rc;
+}
+
+// Buffer Manager Interface Access Strategies
+
+/*
+ * Create a bulk read strategy owning a ring of ringSize frames
+ * The result need to be freed with freeAccessStrategy
+ */
+BM_AccessStrategy *createAccessStrategy(int ringSize) {
+    BM_AccessStrategy *strategy = malloc(sizeof(BM_AccessStrategy));
+    if (ringSize < 1) {
+        ringSize = 1;
+    }
+    strategy->ring = malloc(sizeof(PageNumber) * ringSize);
+    for (int i = 0; i < ringSize; i++) {
+        strategy->ring[i] = NO_PAGE;
+    }
+    strategy->ringSize = ringSize;
+    strategy->nextVictim = 0;
+    return strategy;
+}
+
+void freeAccessStrategy(BM_AccessStrategy *strategy) {
+    if (strategy == NULL) {
+        return;
+    }
+    free(strategy->ring);
+    free(strategy);
+}
+
+
+// Buffer Manager Interface Optimistic Reads
+
+/*
+ * Give in page the content of page pageNum without pinning it, and in version the version of its frame.
+ * If the page is not in the pool it is loaded (pinned and directly unpinned).
+ * Returns RC_BM_PAGE_BEING_WRITTEN if a writer marked the page dirty and did not unpin it yet, or if the page was
+ * evicted right after being loaded OPTIMISTIC_READ_RETRIES times. The caller should then read it with pinPage.
+ * Only the lookup of the frame holds the lock of the pool, the caller reads the page without it.
+ */
+RC readPageOptimistic(BM_BufferPool *const bm, BM_PageHandle *const page,
+                      const PageNumber pageNum, unsigned long *version) {
+    for (int attempt = 0; attempt < OPTIMISTIC_READ_RETRIES; attempt++) {
+        /* the frames array is reallocated by resizeBufferPool and frames change page under the lock */
+        lockPool(bm);
+        BM_FrameHandle *frame = findFrameNumberN(bm, pageNum);
+        if (frame == NULL) {
+            unlockPool(bm);
+            RC rc = pinPage(bm, page, pageNum);
+            if (rc != RC_OK) {
+                return rc;
+            }
+            unpinPage(bm, page);
+            /* looked up again, another thread can evict it right away */
+            continue;
+        }
+        unsigned long frameVersion = __atomic_load_n(&frame->version, __ATOMIC_ACQUIRE);
+        page->pageNum = pageNum;
+        page->data = frame->page->data;
+        unlockPool(bm);
+
+        if ((frameVersion & 1) == 1) {
+            return RC_BM_PAGE_BEING_WRITTEN;
+        }
+        *version = frameVersion;
+        return RC_OK;
+    }
+    return RC_BM_PAGE_BEING_WRITTEN;
+}
+
+/*
+ * Returns TRUE if what was read in page since readPageOptimistic returned version is consistent, i.e the frame still
+ * holds the same page and nothing was written in it.
+ */
+bool validatePageRead(BM_BufferPool *const bm, BM_PageHandle *const page, const unsigned long version) {
+    /* the reads of the page happen before the version is read again */
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    lockPool(bm);
+    BM_FrameHandle *frame = findFrameNumberN(bm, page->pageNum);
+    bool valid = frame != NULL && frame->page->data == page->data
+                 && __atomic_load_n(&frame->version, __ATOMIC_ACQUIRE) == version;
+    unlockPool(bm);
+    return valid;
+}
+
 
 // Statistics Interface
 
@@ -365,4 +1935,8 @@ int getNumReadIO(BM_BufferPool *const bm) {
 
 int getNumWriteIO(BM_BufferPool *const bm) {
     return bm->numberOfWriteIO;
+}
+
+long getNumReadBytes(BM_BufferPool *const bm) {
+    return bm->numberOfReadBytes;
 }
\ No newline at end of file
@@ -8,10 +8,15 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <sys/wait.h>
 
 // var to store the current test's name
 char *testName;
 
+// set to 0 to stop the thread of churnPool
+static volatile int churning;
+
 // check whether two the content of a buffer pool is the same as an expected content 
 // (given in the format produced by sprintPoolContent)
 #define ASSERT_EQUALS_POOL(expected,bm,message)			        \
@@ -39,6 +44,14 @@ static void testReadPage (void);
 static void testFIFO (void);
 static void testLRU (void);
 
+static void testAccessStrategyRing (void);
+static void testResizeBufferPool (void);
+static void testOptimisticRead (void);
+static void *churnPool (void *pool);
+static void testMemoryOptions (void);
+static void testGovernorHeldPool (void);
+static void testCompressedPageFile (void);
+
 // main method
 int
 main (void)
@@ -50,6 +63,12 @@ main (void)
     testReadPage();
     testFIFO();
     testLRU();
+    testAccessStrategyRing();
+    testResizeBufferPool();
+    testOptimisticRead();
+    testMemoryOptions();
+    testGovernorHeldPool();
+    testCompressedPageFile();
 }
 
 // create n pages with content "Page X" and read them back to check whether the content is right
@@ -302,4 +321,415 @@ testLRU (void)
     free(bm);
     free(h);
     TEST_DONE();
-}
\ No newline at end of file
+}
+
+// test that pages read through an access strategy recycle the frames of its ring instead of evicting the pool
+void
+testAccessStrategyRing (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_AccessStrategy *strategy;
+    int i;
+    testName = "Testing the ring of an access strategy";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 30);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 5, RS_LRU, NULL));
+
+    // pages used by others before the scan
+    for (i = 0; i < 2; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        CHECK(unpinPage(bm, h));
+    }
+
+    // sequential scan with a ring of two frames
+    strategy = createAccessStrategy(2);
+    for (i = 2; i < 30; i++)
+    {
+        CHECK(pinPageWithStrategy(bm, h, i, strategy));
+        ASSERT_EQUALS_INT(i, atoi(h->data + strlen("Page-")), "page read through the ring");
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[0 0],[1 0],[28 0],[29 0],[-1 0]", bm, "the scan only used the two frames of its ring");
+    ASSERT_EQUALS_INT(30, getNumReadIO(bm), "check number of read I/Os");
+
+    // the pages of the pool are still there
+    CHECK(pinPage(bm, h, 0));
+    CHECK(unpinPage(bm, h));
+    ASSERT_EQUALS_INT(30, getNumReadIO(bm), "page 0 was not evicted");
+
+    freeAccessStrategy(strategy);
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// test growing and shrinking a pool: pinned pages stay, dirty pages evicted on shrink are written
+void
+testResizeBufferPool (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PageHandle *pinned = MAKE_PAGE_HANDLE();
+    char *expected = malloc(sizeof(char) * 512);
+    int i;
+    testName = "Testing resizing a buffer pool";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_LRU, NULL));
+
+    for (i = 0; i < 3; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(h->data, "%s-%i", "Page", h->pageNum);
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(pinPage(bm, pinned, 2));
+
+    // growing keeps the frames and adds empty ones
+    CHECK(resizeBufferPool(bm, 6));
+    ASSERT_EQUALS_INT(6, bm->numPages, "pool grown");
+    for (i = 3; i < 6; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(h->data, "%s-%i", "Page", h->pageNum);
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_POOL("[0x0],[1x0],[2x1],[3x0],[4x0],[5x0]", bm, "pool content after growing");
+    ASSERT_EQUALS_INT(0, getNumWriteIO(bm), "nothing written while growing");
+
+    // shrinking evicts the least recently used unpinned pages
+    CHECK(resizeBufferPool(bm, 2));
+    ASSERT_EQUALS_POOL("[2x1],[5x0]", bm, "pool content after shrinking");
+    ASSERT_EQUALS_INT(4, getNumWriteIO(bm), "evicted dirty pages are written");
+    ASSERT_ERROR(resizeBufferPool(bm, 0), "a pool needs a frame");
+
+    // a pool cannot shrink under its number of pinned pages
+    CHECK(pinPage(bm, h, 5));
+    ASSERT_EQUALS_INT(RC_BM_PAGES_STILL_PINNED, resizeBufferPool(bm, 1), "two pages are pinned");
+    ASSERT_EQUALS_INT(2, bm->numPages, "pool left untouched");
+    CHECK(unpinPage(bm, h));
+
+    for (i = 0; i < 6; i++)
+    {
+        if (i == 2)
+            continue;
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", "Page", h->pageNum);
+        ASSERT_EQUALS_STRING(expected, h->data, "reading back page content after resizing");
+        CHECK(unpinPage(bm, h));
+    }
+
+    // a pool with a pinned page is not shut down, and its other pages stay usable
+    CHECK(unpinPage(bm, pinned));
+    CHECK(pinPage(bm, pinned, 5));
+    ASSERT_EQUALS_POOL("[2x0],[5 1]", bm, "pool content before shutting down");
+    ASSERT_EQUALS_INT(RC_WRITE_FAILED, shutdownBufferPool(bm), "page 5 is pinned");
+    CHECK(pinPage(bm, h, 2));
+    ASSERT_EQUALS_STRING("Page-2", h->data, "page kept by the failed shutdown");
+    CHECK(unpinPage(bm, h));
+    CHECK(unpinPage(bm, pinned));
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(expected);
+    free(bm);
+    free(h);
+    free(pinned);
+    TEST_DONE();
+}
+
+// test reading pages without pinning them: the version of the frame tells whether the read is consistent
+void
+testOptimisticRead (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    BM_PageHandle *writer = MAKE_PAGE_HANDLE();
+    unsigned long version, oldVersion;
+    pthread_t churner;
+    char copy[16], expected[16];
+    int i, validated = 0, inconsistent = 0;
+    testName = "Testing optimistic page reads";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 10);
+    CHECK(initBufferPool(bm, "testbuffer.bin", 2, RS_LRU, NULL));
+
+    // a page not in the pool is loaded, nothing stays pinned
+    CHECK(readPageOptimistic(bm, h, 3, &version));
+    ASSERT_EQUALS_STRING("Page-3", h->data, "page read without pinning it");
+    ASSERT_TRUE(validatePageRead(bm, h, version), "nothing changed since the read");
+    ASSERT_EQUALS_POOL("[3 0],[-1 0]", bm, "the page is not pinned");
+
+    // a writer marked the page dirty and did not unpin it yet
+    CHECK(pinPage(bm, writer, 3));
+    CHECK(markDirty(bm, writer));
+    ASSERT_EQUALS_INT(RC_BM_PAGE_BEING_WRITTEN, readPageOptimistic(bm, h, 3, &oldVersion), "page being written");
+    ASSERT_TRUE(!validatePageRead(bm, h, version), "the read before the write is no longer consistent");
+    sprintf(writer->data, "%s-%i", "Changed", 3);
+    CHECK(unpinPage(bm, writer));
+
+    oldVersion = version;
+    CHECK(readPageOptimistic(bm, h, 3, &version));
+    ASSERT_TRUE(version != oldVersion, "the write changed the version");
+    ASSERT_EQUALS_STRING("Changed-3", h->data, "page read after the write");
+
+    // the frame is given to other pages
+    for (i = 4; i < 6; i++)
+    {
+        CHECK(pinPage(bm, writer, i));
+        CHECK(unpinPage(bm, writer));
+    }
+    ASSERT_TRUE(!validatePageRead(bm, h, version), "the page was evicted since the read");
+
+    // a validated read is consistent while another thread evicts pages and resizes the pool
+    churning = 1;
+    ASSERT_TRUE(pthread_create(&churner, NULL, churnPool, bm) == 0, "the churning thread is started");
+    for (i = 0; i < 200000; i++)
+    {
+        if (readPageOptimistic(bm, h, 4 + i % 6, &version) != RC_OK)
+            continue;
+        memcpy(copy, h->data, sizeof(copy));
+        if (!validatePageRead(bm, h, version))
+            continue;
+        validated++;
+        sprintf(expected, "%s-%i", "Page", 4 + i % 6);
+        if (strncmp(expected, copy, sizeof(copy)) != 0)
+            inconsistent++;
+    }
+    churning = 0;
+    pthread_join(churner, NULL);
+    ASSERT_TRUE(validated > 0, "some reads were validated");
+    ASSERT_EQUALS_INT(0, inconsistent, "validated reads hold their page");
+
+    CHECK(shutdownBufferPool(bm));
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(bm);
+    free(h);
+    free(writer);
+    TEST_DONE();
+}
+
+// pin the pages 0 to 9 one after the other and resize the pool between 2 and 8 frames until churning is 0
+void *
+churnPool (void *pool)
+{
+    BM_BufferPool *bm = (BM_BufferPool *) pool;
+    BM_PageHandle h;
+    int i;
+    for (i = 0; churning; i++)
+    {
+        if (pinPage(bm, &h, i % 10) == RC_OK)
+            unpinPage(bm, &h);
+        if (i % 7 == 0)
+            resizeBufferPool(bm, 2 + (i / 7) % 7);
+    }
+    return NULL;
+}
+
+// test pools whose frames are backed by huge pages or placed on NUMA nodes, the pages must read back the same
+void
+testMemoryOptions (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    char *expected = malloc(sizeof(char) * 512);
+    BM_MemoryOptions options[] = {
+            {BM_HUGE_PAGES_TRANSPARENT, BM_NUMA_NONE, 0},
+            {BM_HUGE_PAGES_EXPLICIT, BM_NUMA_INTERLEAVE, 0},
+            {BM_HUGE_PAGES_NONE, BM_NUMA_BIND, 0}
+    };
+    int i, j;
+    testName = "Testing memory options of the frames";
+
+    for (j = 0; j < 3; j++)
+    {
+        CHECK(createPageFile("testbuffer.bin"));
+        CHECK(initBufferPoolWithMemoryOptions(bm, "testbuffer.bin", 20, RS_FIFO, NULL, &options[j]));
+        for (i = 0; i < 50; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            sprintf(h->data, "%s-%i", "Page", h->pageNum);
+            CHECK(markDirty(bm, h));
+            CHECK(unpinPage(bm, h));
+        }
+
+        // frames added when growing come from a new arena
+        CHECK(resizeBufferPool(bm, 3));
+        CHECK(resizeBufferPool(bm, 40));
+        for (i = 0; i < 50; i++)
+        {
+            CHECK(pinPage(bm, h, i));
+            sprintf(expected, "%s-%i", "Page", h->pageNum);
+            ASSERT_EQUALS_STRING(expected, h->data, "reading back page content");
+            CHECK(unpinPage(bm, h));
+        }
+
+        CHECK(shutdownBufferPool(bm));
+        CHECK(destroyPageFile("testbuffer.bin"));
+    }
+
+    free(expected);
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
+
+// test that the memory governor does not resize a held pool, shrinks it again once released, and keeps pool minimums
+void
+testGovernorHeldPool (void)
+{
+    BM_BufferPool *held = MAKE_POOL();
+    BM_BufferPool *other = MAKE_POOL();
+    testName = "Testing the memory governor with a held pool";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    CHECK(createPageFile("testbuffer2.bin"));
+    CHECK(initBufferPool(held, "testbuffer.bin", 10, RS_LRU, NULL));
+    CHECK(initBufferPool(other, "testbuffer2.bin", 10, RS_LRU, NULL));
+
+    // growing the held pool for a while, as a parallel scan does
+    holdBufferPoolSize(held);
+    CHECK(resizeBufferPool(held, 14));
+
+    // over budget: only the other pool can shrink, down to its minimum
+    CHECK(setBufferPoolBudget(12));
+    ASSERT_EQUALS_INT(14, held->numPages, "held pool keeps its frames");
+    ASSERT_EQUALS_INT(2, other->numPages, "other pool shrinks to the minimum");
+
+    releaseBufferPoolSize(held);
+    CHECK(rebalanceBufferPools());
+    ASSERT_EQUALS_INT(10, held->numPages, "released pool shrinks to fit the budget");
+    ASSERT_EQUALS_INT(2, other->numPages, "other pool unchanged");
+
+    // a pool with a minimum of its own is not shrunk under it
+    CHECK(setBufferPoolBudget(0));
+    CHECK(resizeBufferPool(other, 10));
+    CHECK(setBufferPoolMinimum(other, 5));
+    CHECK(setBufferPoolBudget(6));
+    ASSERT_EQUALS_INT(2, held->numPages, "pool shrinks to the default minimum");
+    ASSERT_EQUALS_INT(5, other->numPages, "pool shrinks to its own minimum");
+    ASSERT_ERROR(setBufferPoolMinimum(other, 0), "a pool needs a frame");
+
+    CHECK(setBufferPoolBudget(0));
+    CHECK(shutdownBufferPool(held));
+    CHECK(shutdownBufferPool(other));
+    CHECK(destroyPageFile("testbuffer.bin"));
+    CHECK(destroyPageFile("testbuffer2.bin"));
+
+    free(held);
+    free(other);
+    TEST_DONE();
+}
+
+// test a compressed page file: its pages read back the same for a fraction of the bytes, pages written are compressed too
+void
+testCompressedPageFile (void)
+{
+    BM_BufferPool *bm = MAKE_POOL();
+    BM_PageHandle *h = MAKE_PAGE_HANDLE();
+    SM_FileHandle fh;
+    char *expected = malloc(sizeof(char) * 512);
+    long plainSize;
+    int i, status;
+    pid_t pid;
+    testName = "Testing compressed page files";
+
+    CHECK(createPageFile("testbuffer.bin"));
+    createDummyPages(bm, 100);
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    plainSize = getFileSize(&fh);
+    CHECK(closePageFile(&fh));
+
+    CHECK(compressPageFile("testbuffer.bin", BM_CODEC_LZ));
+    CHECK(openPageFile("testbuffer.bin", &fh));
+    ASSERT_TRUE(getFileSize(&fh) < plainSize / 4, "the dummy pages compress well");
+    CHECK(closePageFile(&fh));
+    // a compressed page file is left as it is
+    CHECK(compressPageFile("testbuffer.bin", BM_CODEC_LZ));
+
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    for (i = 0; i < 100; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        ASSERT_EQUALS_INT(i, atoi(h->data + strlen("Page-")), "reading back page content");
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_EQUALS_INT(100, getNumReadIO(bm), "check number of read I/Os");
+    ASSERT_TRUE(getNumReadBytes(bm) < 100 * PAGE_SIZE / 4, "a page read takes a fraction of a block");
+
+    // pages changed, and pages added after the end of the file
+    for (i = 50; i < 150; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(h->data, "%s-%i", "Changed", h->pageNum);
+        CHECK(markDirty(bm, h));
+        CHECK(unpinPage(bm, h));
+    }
+    CHECK(shutdownBufferPool(bm));
+
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    for (i = 0; i < 150; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", i < 50 ? "Page" : "Changed", h->pageNum);
+        ASSERT_EQUALS_STRING(expected, h->data, "reading back page content after writing");
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_TRUE(getNumReadBytes(bm) < 150 * PAGE_SIZE / 4, "the pages written are compressed too");
+    CHECK(shutdownBufferPool(bm));
+
+    /*
+     * the child flushes the pool twice (the pages replaced are then compacted away), then evicts pages and stops
+     * without shutting it down: they are lost, not the file
+     */
+    fflush(stdout);
+    pid = fork();
+    if (pid == 0)
+    {
+        bool failed = initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL) != RC_OK;
+        // pages 0 to 99 twice, flushed after each time, then pages 100 to 149
+        for (i = 0; i < 250 && !failed; i++)
+        {
+            failed = pinPage(bm, h, i < 200 ? i % 100 : i - 100) != RC_OK;
+            if (!failed)
+            {
+                sprintf(h->data, "%s-%i", i < 200 ? "Flushed" : "Lost", h->pageNum);
+                failed = markDirty(bm, h) != RC_OK || unpinPage(bm, h) != RC_OK;
+            }
+            if (i == 99 || i == 199)
+                failed = failed || forceFlushPool(bm) != RC_OK;
+        }
+        _exit(failed ? 1 : 0);
+    }
+    ASSERT_TRUE(pid > 0, "the process is forked");
+    ASSERT_TRUE(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0,
+                "the pages are written");
+
+    CHECK(initBufferPool(bm, "testbuffer.bin", 3, RS_FIFO, NULL));
+    for (i = 0; i < 150; i++)
+    {
+        CHECK(pinPage(bm, h, i));
+        sprintf(expected, "%s-%i", i < 100 ? "Flushed" : "Changed", h->pageNum);
+        ASSERT_EQUALS_STRING(expected, h->data, "reading back page content after a crash");
+        CHECK(unpinPage(bm, h));
+    }
+    ASSERT_TRUE(getNumReadBytes(bm) < 150 * PAGE_SIZE / 4, "the file is still compressed after a crash");
+    CHECK(shutdownBufferPool(bm));
+    ASSERT_TRUE(access("testbuffer.bin.new", F_OK) != 0, "no copy is left after compacting the file");
+    CHECK(destroyPageFile("testbuffer.bin"));
+
+    free(expected);
+    free(bm);
+    free(h);
+    TEST_DONE();
+}
@@ -1,37 +1,243 @@
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <math.h>
+#include <pthread.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "record_mgr.h"
 #include "storage_mgr.h"
 #include "buffer_mgr.h"
+#include "wal_mgr.h"
 
 #define ATTRIBUTE_NAME_LEN 5
 
-typedef struct RM_FreeRecord RM_FreeRecord; // prototype so it can be used inside the declaration
+/*
+ * Frames of the buffer pool of an open table, the memory governor never takes it under them: a record moving out of its
+ * page pins two data pages and a free space map page while a scan can keep its own page pinned.
+ */
+#define TABLE_POOL_FRAMES 5
+
+// Maximum number of frames a scan recycles for itself, so it does not evict the whole pool
+#define SCAN_RING_SIZE 4
+
+// Number of consecutive pages a thread of a parallel scan takes at once
+#define PARALLEL_SCAN_MORSEL_PAGES 16
+
+// Deepest nesting of boolean operators a compiled predicate can evaluate
+#define PREDICATE_MAX_DEPTH 32
+
+// Number of slots described by one word of the occupancy bitmap of a page
+#define SLOTS_PER_BITMAP_WORD 64
+
+/*
+ * Header at the beginning of every data page (page 1 and after). It is followed by the occupancy bitmap of the slots
+ * (a set bit means the slot holds a record) and by the slot directory. The records are stored from the end of the page
+ * towards the directory.
+ * Pages of a PAX table have no directory: after the bitmap comes one minipage per attribute holding the value of the
+ * attribute for every slot, with the full size of the attribute. A scan reading a few attributes then reads contiguous
+ * values.
+ */
+typedef struct RM_PageHeader {
+	int numberOfSlots; // entries of the slot directory
+	int numberOfRecords; // slots holding a record or a forward
+	int freeSpaceOffset; // first byte of the records, the free space is between the directory and this offset
+	int freeBytes; // free space plus the holes left between the records by deletes and updates
+	WAL_LSN pageLSN; // end of the log record of the last change of the page
+} RM_PageHeader;
+
+/*
+ * Entry of the slot directory: where the encoded record of the slot is in the page.
+ * A record growing out of its row page moves to another page but keeps its RID (see updateRecord): its slot becomes a
+ * forward, holding the RID of the slot the record moved to, and the moved record is followed by the RID of the forward.
+ * A forward is not set in the occupancy bitmap so scans only see the moved record, its entry keeps a length so the slot
+ * is not reused. Free slots have a length of 0.
+ */
+typedef struct RM_SlotEntry {
+	uint16_t offset : 15;
+	uint16_t movedIn : 1; // the record came from a forward, whose RID follows it
+	uint16_t length;
+} RM_SlotEntry;
+
+typedef enum RM_SlotState {
+	SLOT_FREE,
+	SLOT_RECORD,
+	SLOT_FORWARD,
+	SLOT_MOVED_IN
+} RM_SlotState;
+
+/*
+ * Free space map: page 1 and then one page every FSM_DATA_PAGES_PER_MAP_PAGE + 1 pages is a map page giving, with 4 bits
+ * per data page, how much free space the FSM_DATA_PAGES_PER_MAP_PAGE data pages following it have. The free space of a
+ * page is rounded down to a multiple of FSM_BYTES_PER_CATEGORY.
+ */
+#define FSM_CATEGORIES 16
+#define FSM_BYTES_PER_CATEGORY (PAGE_SIZE / FSM_CATEGORIES)
+#define FSM_DATA_PAGES_PER_MAP_PAGE (PAGE_SIZE * 2)
+
+// Statistics built by analyzeTable
+#define STATISTICS_BUCKETS 16
+#define HLL_REGISTER_BITS 6
+#define HLL_REGISTERS (1 << HLL_REGISTER_BITS)
+// seed of the choice of the sampled pages, analyzing the same table twice gives the same statistics
+#define ANALYZE_SEED 0x9E3779B97F4A7C15ULL
+// a sampled attribute with more distinct values than this fraction of the sampled records is taken as unique
+#define ANALYZE_UNIQUE_FRACTION 0.9
+// selectivities used when the table was not analyzed or the condition is not a comparison with a constant
+#define DEFAULT_EQUALITY_SELECTIVITY 0.005
+#define DEFAULT_RANGE_SELECTIVITY (1.0 / 3)
+
+// codes of a dictionary encoded attribute are stored on a uint16_t, the last one is never given to a value
+#define DICTIONARY_MAX_VALUES 65535
+// code read when a record is cut short, it decodes as an empty string and matches no constant
+#define DICTIONARY_MISSING_CODE 0xFFFF
+
+// the bitmap starts on the first word boundary after the header
+#define PAGE_BITMAP_OFFSET ((sizeof(RM_PageHeader) + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t))
+
+/*
+ * Zone map: for every data page, its number of records and the smallest and largest value of each int and float
+ * attribute, so scans can skip the pages where their condition cannot be true without pinning them.
+ * It is only kept in memory: a page gets its zone when it is created or the first time a scan reads it after the table
+ * is opened. Inserts and updates widen the ranges and deletes only decrement the count, the ranges stay a superset of
+ * the values of the page.
+ */
+typedef struct RM_ZoneMap {
+	int numberOfPages; // pages having an entry, page 0 included
+	int numberOfAttrs; // int and float attributes
+	int* zoneOfAttr; // index of each attribute in the ranges of a page, -1 for strings and bools
+	bool* known; // the page has a zone
+	int* numberOfRecords;
+	double* min; // numberOfAttrs values per page
+	double* max;
+} RM_ZoneMap;
 
-typedef struct RM_FreeRecord {
-	RID* rid;
-	RM_FreeRecord* next;
-} RM_FreeRecord;
+/*
+ * Statistics of an attribute, from the records of the pages sampled by analyzeTable. The bounds of an int or float
+ * attribute cut the sampled values in STATISTICS_BUCKETS buckets holding as many values each (equi-depth histogram),
+ * bounds[0] is the smallest value and bounds[STATISTICS_BUCKETS] the largest. registers is a HyperLogLog sketch of the
+ * sampled values.
+ */
+typedef struct RM_AttrStatistics {
+	double distinctValues; // estimated for the whole table
+	bool hasHistogram;
+	double bounds[STATISTICS_BUCKETS + 1];
+	uint8_t registers[HLL_REGISTERS];
+} RM_AttrStatistics;
+
+typedef struct RM_Statistics {
+	int numberOfTuples; // when the table was analyzed
+	int sampledTuples;
+	RM_AttrStatistics* attrs;
+} RM_Statistics;
 
-typedef struct RM_FreeRecordsQueue {
-	RM_FreeRecord* first;
-	RM_FreeRecord* last;
-	int numberOfFreeRecords;
-} RM_FreeRecordsQueue;
+/*
+ * Dictionary of a dictionary encoded string attribute: records store the code of their string (its index in values) on a
+ * uint16_t instead of the string. The codes of the strings are found with an open addressing hash table.
+ */
+typedef struct RM_Dictionary {
+	int numberOfValues;
+	int capacity;
+	char** values; // '\0' terminated
+	int* lengths;
+	int* buckets; // code of the value hashed to each bucket, -1 for an empty bucket
+	int numberOfBuckets; // power of 2, at least twice the capacity
+} RM_Dictionary;
 
 typedef struct RM_RecordMgr {
 	BM_PageHandle* pageHandle;
 	BM_BufferPool* bufferPool;
+	Schema* schema;
 	int tuplesCount;
-	RM_FreeRecordsQueue* freeRecordsQueue;
-	int recordSize;
+	int recordSize; // size of a record in memory, strings take their full typeLength
+	int slotsPerPage; // most slots a page can have, when all its records have the smallest encoded size
+	RM_TableFormat format;
+	int numberOfPages; // last page of the table, page 0 holds the metadata
+	int firstFreePage; // the search of the free space map for a page with room starts from this page
+	RM_ZoneMap zones;
+	RM_Statistics* statistics; // NULL if the table was never analyzed
+	RM_Dictionary** dictionaries; // of each attribute, NULL for the attributes not dictionary encoded
+	bool dictionariesChanged; // values were added since the table was opened
+	int* storedOffsets; // of the attributes in a PAX record (codes instead of strings), the last one is its size
+	WAL_Log log;
+	WAL_LSN checkpointLSN; // the changes logged before are in the pages of the file
 } RM_RecordMgr;
 
+/*
+ * Scan condition compiled to a flat list of steps in postfix order: a AND (NOT b) gives [a, b, NOT, AND].
+ * The condition is evaluated on all the records of a page at once: the attributes it uses are first loaded in columns
+ * (one array per attribute, one value per slot), then each step computes a bitmap of the slots, on a stack of bitmaps.
+ */
+typedef enum RM_PredicateOp {
+	PRED_VALUE, // a boolean attribute or constant
+	PRED_COMPARE,
+	PRED_NOT,
+	PRED_AND,
+	PRED_OR
+} RM_PredicateOp;
+
+typedef struct RM_Operand {
+	bool isAttribute;
+	int column; // column holding the values of the attribute
+	int length; // of the string for a string constant
+	Value* constant;
+	int code; // of a string constant compared with a dictionary encoded attribute, -1 if not in the dictionary
+} RM_Operand;
+
+typedef struct RM_PredicateStep {
+	RM_PredicateOp op;
+	OpType comparison; // OP_COMP_EQUAL or OP_COMP_SMALLER
+	DataType dataType;
+	bool compareCodes; // equality of a dictionary encoded attribute with a constant, done on the codes
+	RM_Operand left;
+	RM_Operand right;
+} RM_PredicateStep;
+
+// Values of an attribute for every slot of a page, only the array of the type of the attribute is allocated
+typedef struct RM_Column {
+	int attrNum;
+	DataType dataType;
+	int* ints;
+	float* floats;
+	bool* bools;
+	char** strings; // in the page (or the dictionary), not '\0' terminated
+	int* lengths;
+	int* codes; // of a dictionary encoded attribute
+} RM_Column;
+
+typedef struct RM_Predicate {
+	RM_Dictionary** dictionaries; // of the table
+	RM_PredicateStep* steps;
+	int numberOfSteps;
+	RM_Column* columns;
+	int numberOfColumns;
+	int* columnOfAttr; // column of each attribute of the schema, -1 if the condition does not use it
+	int lastAttr; // last attribute used by the condition, loading the columns stops there
+	int numberOfSlots; // size of the columns and bitmaps
+	uint64_t* stack; // PREDICATE_MAX_DEPTH bitmaps
+	uint64_t* selection; // slots of the page satisfying the condition
+} RM_Predicate;
+
+// Pin held by a record borrowed with borrowRecord
+typedef struct RM_BorrowedPin {
+	BM_BufferPool* bufferPool;
+	BM_PageHandle* pageHandle;
+} RM_BorrowedPin;
+
 typedef struct RM_ScanMgr {
-	RID lastRid;
+	RID nextRid; // first slot the scan did not look at yet
 	Expr* condition;
 	int scanCount;
+	BM_AccessStrategy* strategy;
+	BM_PageHandle* pageHandle; // page of nextRid, kept pinned while the scan reads it
+	bool pagePinned;
+	Record* conditionRecord; // borrowed scans decode their records here to evaluate a condition that is not compiled
+	RM_Predicate* predicate; // compiled condition, NULL if it could not be compiled
+	bool* projection; // attributes copied in the records returned by next, NULL for all of them
+	double pageFraction; // probability of a page to be read by a sample scan, 1 for the other scans
+	double recordFraction; // probability of a record of a read page to be returned
+	unsigned int seed; // of the sample
 } RM_ScanMgr;
 
 void printMetaData(char* metapage) {
@@ -70,264 +276,1664 @@ void printMetaData(char* metapage) {
 	printf("%d ", recordSize);
 	metapage += sizeof(int);
 
-	int page;
-	int slot;
-	while (*metapage != '\0') {
-		page = *(int*)metapage;
-		metapage += sizeof(int);
+	int numberOfPages = *(int*)metapage;
+	printf("%d ", numberOfPages);
+	metapage += sizeof(int);
 
-		slot = *(int*)metapage;
-		metapage += sizeof(int);
+	int format = *(int*)metapage;
+	printf("%d ", format);
+	metapage += sizeof(int);
 
-		printf("%d %d ", page, slot);
+	for (int i = 0; i < numAttr; i++) {
+		printf("%d ", *(int*)metapage);
+		metapage += sizeof(int);
 	}
+
+	WAL_LSN checkpointLSN;
+	memcpy(&checkpointLSN, metapage, sizeof(WAL_LSN));
+	printf("%ld ", checkpointLSN);
+	metapage += sizeof(WAL_LSN);
+
+	int analyzed = *(int*)metapage;
+	printf("%d ", analyzed);
 	printf("\n");
 }
 
-RM_FreeRecordsQueue* initFreeRecordsQueue() {
-	RM_FreeRecordsQueue* queue = malloc(sizeof(RM_FreeRecordsQueue));
-	queue->first = NULL;
-	queue->last = NULL;
-	queue->numberOfFreeRecords = 0;
-	return queue;
+int attributeSize(Schema* schema, int attrNum) {
+	switch (schema->dataTypes[attrNum]) {
+	case DT_INT:
+		return sizeof(int);
+	case DT_STRING:
+		return schema->typeLength[attrNum];
+	case DT_FLOAT:
+		return sizeof(float);
+	case DT_BOOL:
+		return sizeof(bool);
+	}
+	return 0;
 }
 
-void freeRecordsQueue(RM_FreeRecordsQueue* queue) {
-	if (queue->numberOfFreeRecords != 0) {
-		while (queue->first->next != NULL) {
-			RM_FreeRecord* next = queue->first->next;
-			free(queue->first->rid);
-			free(queue->first);
-			queue->first = next;
-			queue->numberOfFreeRecords--;
-		}
+/*
+ * Offset of every attribute in a record, computed once per schema so getAttr and setAttr do a single addition.
+ */
+void computeAttrOffsets(Schema* schema) {
+	schema->attrOffsets = (int*)malloc(sizeof(int) * (schema->numAttr + 1));
+	schema->attrOffsets[0] = 0;
+	for (int i = 0; i < schema->numAttr; i++) {
+		schema->attrOffsets[i + 1] = schema->attrOffsets[i] + attributeSize(schema, i);
 	}
-	if (queue->numberOfFreeRecords == 1) {
-		free(queue->first->rid);
-		free(queue->first);
+}
 
+// 64 bits hash of length bytes (FNV-1a followed by the finalizer of MurmurHash3)
+uint64_t hashValue(char* data, int length) {
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	for (int i = 0; i < length; i++) {
+		hash = (hash ^ (uint8_t)data[i]) * 0x100000001b3ULL;
 	}
-	free(queue);
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ULL;
+	hash ^= hash >> 33;
+	return hash;
 }
 
-void insertInFreeQueue(RM_FreeRecordsQueue* queue, RID rid) {
-	RM_FreeRecord* freeRecord = malloc(sizeof(RM_FreeRecord));
-	freeRecord->rid = malloc(sizeof(RID));
-	freeRecord->rid->slot = rid.slot;
-	freeRecord->rid->page = rid.page;
-	freeRecord->next = (RM_FreeRecord*)NULL;
-	if (queue->last != NULL) {
-		queue->last->next = freeRecord;
-	}
-	if (queue->first == NULL) {
-		queue->first = freeRecord;
-	}
-	queue->last = freeRecord;
-	queue->numberOfFreeRecords++;
+RM_Dictionary* createDictionary() {
+	RM_Dictionary* dictionary = (RM_Dictionary*)malloc(sizeof(RM_Dictionary));
+	dictionary->numberOfValues = 0;
+	dictionary->capacity = 0;
+	dictionary->values = NULL;
+	dictionary->lengths = NULL;
+	dictionary->numberOfBuckets = 0;
+	dictionary->buckets = NULL;
+	return dictionary;
 }
 
-RID* getFirstFreeRecordRid(RM_FreeRecordsQueue* queue) {
-	RM_FreeRecord* freeRecord;
-	if (queue->numberOfFreeRecords == 0) {
-		return NULL;
+void freeDictionary(RM_Dictionary* dictionary) {
+	for (int i = 0; i < dictionary->numberOfValues; i++) {
+		free(dictionary->values[i]);
 	}
+	free(dictionary->values);
+	free(dictionary->lengths);
+	free(dictionary->buckets);
+	free(dictionary);
+}
 
-	RID* rid = queue->first->rid;
-	freeRecord = queue->first;
-	queue->first = queue->first->next;
-	free(freeRecord);
-	queue->numberOfFreeRecords--;
-	return rid;
+// code of the string of length characters, -1 if it is not in the dictionary
+int dictionaryCode(RM_Dictionary* dictionary, char* string, int length) {
+	if (dictionary->numberOfBuckets == 0) {
+		return -1;
+	}
+	int mask = dictionary->numberOfBuckets - 1;
+	for (int bucket = hashValue(string, length) & mask;; bucket = (bucket + 1) & mask) {
+		int code = dictionary->buckets[bucket];
+		if (code == -1) {
+			return -1;
+		}
+		if (dictionary->lengths[code] == length && memcmp(dictionary->values[code], string, length) == 0) {
+			return code;
+		}
+	}
 }
 
-// global var record manager to store useful info
-RM_RecordMgr* recordMgr;
+void insertInBuckets(RM_Dictionary* dictionary, int code) {
+	int mask = dictionary->numberOfBuckets - 1;
+	int bucket = hashValue(dictionary->values[code], dictionary->lengths[code]) & mask;
+	while (dictionary->buckets[bucket] != -1) {
+		bucket = (bucket + 1) & mask;
+	}
+	dictionary->buckets[bucket] = code;
+}
 
-/*
- * Fill a pageHandle with initial values
- * content is [numberOfTuples numberOfAttributes keySize keyAttr1 keyAttr2 ... attr1Name attr1DataType attr1TypeLen attr2Name attr2DataType attr2TypeLen ... recordSize freeRid1 freeRid2 ...]
-*/
-void initialFillPageHandle(BM_PageHandle* pageHandle, Schema* schema) {
-	//Number of Tuples: 0 in the first 4 bytes
-	*(int*)pageHandle->data = 0;
-	pageHandle->data = pageHandle->data + sizeof(int);
+// add a string not in the dictionary yet, returns its code or -1 if the dictionary is full
+int addToDictionary(RM_Dictionary* dictionary, char* string, int length) {
+	if (dictionary->numberOfValues == DICTIONARY_MAX_VALUES) {
+		return -1;
+	}
+	if (dictionary->numberOfValues == dictionary->capacity) {
+		dictionary->capacity = dictionary->capacity == 0 ? 16 : dictionary->capacity * 2;
+		dictionary->values = (char**)realloc(dictionary->values, sizeof(char*) * dictionary->capacity);
+		dictionary->lengths = (int*)realloc(dictionary->lengths, sizeof(int) * dictionary->capacity);
+		free(dictionary->buckets);
+		dictionary->numberOfBuckets = dictionary->capacity * 2;
+		dictionary->buckets = (int*)malloc(sizeof(int) * dictionary->numberOfBuckets);
+		memset(dictionary->buckets, -1, sizeof(int) * dictionary->numberOfBuckets);
+		for (int code = 0; code < dictionary->numberOfValues; code++) {
+			insertInBuckets(dictionary, code);
+		}
+	}
+	int code = dictionary->numberOfValues++;
+	dictionary->values[code] = (char*)malloc(length + 1);
+	memcpy(dictionary->values[code], string, length);
+	dictionary->values[code][length] = '\0';
+	dictionary->lengths[code] = length;
+	insertInBuckets(dictionary, code);
+	return code;
+}
 
-	// Setting the number of attributes
-	*(int*)pageHandle->data = schema->numAttr;
-	pageHandle->data = pageHandle->data + sizeof(int);
+bool isDictionaryEncoded(RM_RecordMgr* tableMgr, int attrNum) {
+	return tableMgr->dictionaries[attrNum] != NULL;
+}
 
-	// Setting the Key Size of the attributes
-	*(int*)pageHandle->data = schema->keySize;
-	pageHandle->data = pageHandle->data + sizeof(int);
+// bytes an attribute takes in a PAX page, the code for a dictionary encoded string
+int storedAttributeSize(RM_RecordMgr* tableMgr, int attrNum) {
+	return isDictionaryEncoded(tableMgr, attrNum) ? (int)sizeof(uint16_t) : attributeSize(tableMgr->schema, attrNum);
+}
 
-	// storing key attr
-	for (int i = 0; i < schema->keySize; i++) {
-		*(int*)pageHandle->data = (int)schema->keyAttrs[i];
-		pageHandle->data += sizeof(int);
+void computeStoredOffsets(RM_RecordMgr* tableMgr) {
+	int numAttr = tableMgr->schema->numAttr;
+	tableMgr->storedOffsets = (int*)malloc(sizeof(int) * (numAttr + 1));
+	tableMgr->storedOffsets[0] = 0;
+	for (int i = 0; i < numAttr; i++) {
+		tableMgr->storedOffsets[i + 1] = tableMgr->storedOffsets[i] + storedAttributeSize(tableMgr, i);
 	}
+}
 
+/*
+ * Give a code to the strings of the dictionary encoded attributes of the record not in their dictionary yet, before the
+ * record is written. Returns RC_RM_DICTIONARY_FULL if a dictionary has no code left.
+ */
+RC addDictionaryValues(RM_RecordMgr* tableMgr, char* data) {
+	Schema* schema = tableMgr->schema;
 	for (int i = 0; i < schema->numAttr; i++) {
-		strncpy(pageHandle->data, schema->attrNames[i], ATTRIBUTE_NAME_LEN);
-		pageHandle->data = pageHandle->data + ATTRIBUTE_NAME_LEN;
-
-		*(int*)pageHandle->data = (int)schema->dataTypes[i];
-		pageHandle->data += sizeof(int);
-
-		*(int*)pageHandle->data = (int)schema->typeLength[i];
-		pageHandle->data += sizeof(int);
+		if (!isDictionaryEncoded(tableMgr, i)) {
+			continue;
+		}
+		char* string = data + schema->attrOffsets[i];
+		int length = strnlen(string, schema->typeLength[i]);
+		if (dictionaryCode(tableMgr->dictionaries[i], string, length) == -1) {
+			if (addToDictionary(tableMgr->dictionaries[i], string, length) == -1) {
+				return RC_RM_DICTIONARY_FULL;
+			}
+			tableMgr->dictionariesChanged = true;
+		}
 	}
-
-	*(int*)pageHandle->data = getRecordSize(schema);
-	pageHandle->data = pageHandle->data + sizeof(int);
+	return RC_OK;
 }
 
-void finalFillPageHandle(BM_PageHandle* pageHandle, RM_TableData* table) {
-	Schema* schema = table->schema;
-	RM_RecordMgr* recordMgr = (RM_RecordMgr*)table->mgmtData;
-
-	//Number of Tuples: 0 in the first 4 bytes
-	*(int*)pageHandle->data = recordMgr->tuplesCount;
-	pageHandle->data = pageHandle->data + sizeof(int);
-
-	// Setting the number of attributes
-	*(int*)pageHandle->data = schema->numAttr;
-	pageHandle->data = pageHandle->data + sizeof(int);
+// code of the string of a dictionary encoded attribute, in the in memory layout, added by addDictionaryValues
+uint16_t encodeString(RM_RecordMgr* tableMgr, char* string, int attrNum) {
+	return dictionaryCode(tableMgr->dictionaries[attrNum], string, strnlen(string, tableMgr->schema->typeLength[attrNum]));
+}
 
-	// Setting the Key Size of the attributes
-	*(int*)pageHandle->data = schema->keySize;
-	pageHandle->data = pageHandle->data + sizeof(int);
+/*
+ * Write the string of code in data, padded with '\0' to size bytes. A code not in the dictionary (read from a page being
+ * changed) gives an empty string.
+ */
+void decodeString(RM_Dictionary* dictionary, uint16_t code, char* data, int size) {
+	int length = 0;
+	if (code < dictionary->numberOfValues) {
+		length = dictionary->lengths[code] < size ? dictionary->lengths[code] : size;
+		memcpy(data, dictionary->values[code], length);
+	}
+	memset(data + length, 0, size - length);
+}
 
-	// storing key attr
-	for (int i = 0; i < schema->keySize; i++) {
-		*(int*)pageHandle->data = (int)schema->keyAttrs[i];
-		pageHandle->data += sizeof(int);
+// the string of a code read in a page, empty for a code not in the dictionary
+char* dictionaryString(RM_Dictionary* dictionary, uint16_t code, int* length) {
+	if (code >= dictionary->numberOfValues) {
+		*length = 0;
+		return "";
 	}
+	*length = dictionary->lengths[code];
+	return dictionary->values[code];
+}
 
+/*
+ * Records are stored encoded in the pages: int, float and bool attributes keep their size, a string is stored as its
+ * length (uint16_t) followed by its characters up to the first '\0'. A VARCHAR(255) holding 10 characters takes 12 bytes.
+ * A dictionary encoded string is stored as its code (uint16_t).
+ */
+int encodedRecordSize(RM_RecordMgr* tableMgr, char* data) {
+	Schema* schema = tableMgr->schema;
+	int size = 0;
 	for (int i = 0; i < schema->numAttr; i++) {
-		strncpy(pageHandle->data, schema->attrNames[i], ATTRIBUTE_NAME_LEN);
-		pageHandle->data = pageHandle->data + ATTRIBUTE_NAME_LEN;
+		if (isDictionaryEncoded(tableMgr, i)) {
+			size += sizeof(uint16_t);
+		}
+		else if (schema->dataTypes[i] == DT_STRING) {
+			size += sizeof(uint16_t) + strnlen(data, schema->typeLength[i]);
+		}
+		else {
+			size += attributeSize(schema, i);
+		}
+		data += attributeSize(schema, i);
+	}
+	return size;
+}
 
-		*(int*)pageHandle->data = (int)schema->dataTypes[i];
-		pageHandle->data += sizeof(int);
+// smallest encoded size of a record: every string is empty
+int minimumEncodedRecordSize(RM_RecordMgr* tableMgr) {
+	Schema* schema = tableMgr->schema;
+	int size = 0;
+	for (int i = 0; i < schema->numAttr; i++) {
+		size += schema->dataTypes[i] == DT_STRING ? (int)sizeof(uint16_t) : attributeSize(schema, i);
+	}
+	return size;
+}
 
-		*(int*)pageHandle->data = (int)schema->typeLength[i];
-		pageHandle->data += sizeof(int);
+void encodeRecord(RM_RecordMgr* tableMgr, char* data, char* encoded) {
+	Schema* schema = tableMgr->schema;
+	for (int i = 0; i < schema->numAttr; i++) {
+		if (isDictionaryEncoded(tableMgr, i)) {
+			uint16_t code = encodeString(tableMgr, data, i);
+			memcpy(encoded, &code, sizeof(uint16_t));
+			encoded += sizeof(uint16_t);
+		}
+		else if (schema->dataTypes[i] == DT_STRING) {
+			uint16_t length = strnlen(data, schema->typeLength[i]);
+			memcpy(encoded, &length, sizeof(uint16_t));
+			encoded += sizeof(uint16_t);
+			memcpy(encoded, data, length);
+			encoded += length;
+		}
+		else {
+			memcpy(encoded, data, attributeSize(schema, i));
+			encoded += attributeSize(schema, i);
+		}
+		data += attributeSize(schema, i);
 	}
+}
 
-	*(int*)pageHandle->data = recordMgr->recordSize;
-	pageHandle->data = pageHandle->data + sizeof(int);
+/*
+ * Decode the length bytes of encoded into the in memory layout of the record, strings are padded with '\0'.
+ * Nothing is read after length bytes so a record read optimistically from a page being changed stays in the page.
+ * Only the attributes set in projection are written in data, all of them if projection is NULL.
+ */
+void decodeRecord(RM_RecordMgr* tableMgr, char* encoded, int length, char* data, bool* projection) {
+	Schema* schema = tableMgr->schema;
+	char* end = encoded + length;
+	for (int i = 0; i < schema->numAttr; i++) {
+		int size = attributeSize(schema, i);
+		bool wanted = projection == NULL || projection[i];
+		if (isDictionaryEncoded(tableMgr, i)) {
+			uint16_t code = DICTIONARY_MISSING_CODE;
+			if (encoded + sizeof(uint16_t) <= end) {
+				memcpy(&code, encoded, sizeof(uint16_t));
+			}
+			if (wanted) {
+				decodeString(tableMgr->dictionaries[i], code, data, size);
+			}
+			encoded += sizeof(uint16_t);
+		}
+		else if (schema->dataTypes[i] == DT_STRING) {
+			uint16_t stringLength = 0;
+			if (encoded + sizeof(uint16_t) <= end) {
+				memcpy(&stringLength, encoded, sizeof(uint16_t));
+			}
+			encoded += sizeof(uint16_t);
+			if (stringLength > size) {
+				stringLength = size;
+			}
+			if (encoded + stringLength > end) {
+				stringLength = end > encoded ? end - encoded : 0;
+			}
+			if (wanted) {
+				memcpy(data, encoded, stringLength);
+				memset(data + stringLength, 0, size - stringLength);
+			}
+			encoded += stringLength;
+		}
+		else {
+			if (wanted && encoded + size <= end) {
+				memcpy(data, encoded, size);
+			}
+			else if (wanted) {
+				memset(data, 0, size);
+			}
+			encoded += size;
+		}
+		data += size;
+	}
+}
 
-	RM_FreeRecordsQueue* queue = recordMgr->freeRecordsQueue;
-	RM_FreeRecord* freeRecord = queue->first;
-	while (freeRecord != NULL) {
-		printf("putting free in page. rid %d %d\n", freeRecord->rid->page, freeRecord->rid->slot);
-		*(int*)pageHandle->data = freeRecord->rid->page;
-		pageHandle->data = pageHandle->data + sizeof(int);
+int bitmapWords(int numberOfSlots) {
+	return (numberOfSlots + SLOTS_PER_BITMAP_WORD - 1) / SLOTS_PER_BITMAP_WORD;
+}
 
-		*(int*)pageHandle->data = freeRecord->rid->slot;
-		pageHandle->data = pageHandle->data + sizeof(int);
+// offset of the slot directory in a page having a bitmap of numberOfSlots slots
+int directoryOffset(int numberOfSlots) {
+	return PAGE_BITMAP_OFFSET + bitmapWords(numberOfSlots) * sizeof(uint64_t);
+}
 
-		freeRecord = freeRecord->next;
+// the most records of recordSize bytes fitting in a page together with the header, the bitmap and the directory
+int computeSlotsPerPage(int recordSize) {
+	int slots = (PAGE_SIZE - PAGE_BITMAP_OFFSET) / (recordSize + sizeof(RM_SlotEntry));
+	while (directoryOffset(slots) + slots * (recordSize + (int)sizeof(RM_SlotEntry)) > PAGE_SIZE) {
+		slots--;
 	}
+	return slots;
+}
 
+// PAX pages: the most records of recordSize bytes fitting in the minipages after the header and the bitmap
+int computePaxSlotsPerPage(int recordSize) {
+	int slots = (PAGE_SIZE - PAGE_BITMAP_OFFSET) / recordSize;
+	while (directoryOffset(slots) + slots * recordSize > PAGE_SIZE) {
+		slots--;
+	}
+	return slots;
 }
 
-void fillSchemaFromLoadedPage(BM_PageHandle* pageHandle, Schema* schema) {
-	int numAttr = *(int*)pageHandle->data;
-	schema->numAttr = numAttr;
-	pageHandle->data += sizeof(int);
+/*
+ * Free bytes a free slot of a PAX page counts for: a record and a directory entry, so the free space map finds PAX pages
+ * with room the same way it finds row pages.
+ */
+int paxSlotBytes(RM_RecordMgr* tableMgr) {
+	return tableMgr->storedOffsets[tableMgr->schema->numAttr] + sizeof(RM_SlotEntry);
+}
 
-	schema->keySize = *(int*)pageHandle->data;
-	pageHandle->data += sizeof(int);
+uint64_t* pageBitmap(char* page) {
+	return (uint64_t*)(page + PAGE_BITMAP_OFFSET);
+}
 
-	schema->keyAttrs = malloc(sizeof(int) * schema->keySize);
+RM_SlotEntry* slotDirectory(RM_RecordMgr* tableMgr, char* page) {
+	return (RM_SlotEntry*)(page + directoryOffset(tableMgr->slotsPerPage));
+}
 
-	// get key attr
-	for (int i = 0; i < schema->keySize; i++) {
-		schema->keyAttrs[i] = *(int*)pageHandle->data;
-		pageHandle->data += sizeof(int);
-	}
+char* slotData(RM_RecordMgr* tableMgr, char* page, int slot) {
+	return page + slotDirectory(tableMgr, page)[slot].offset;
+}
 
-	// allocating memory to store the values
+// value of attribute attrNum of a slot of a PAX page, the minipages start where the slot directory of a row page would
+char* paxValue(RM_RecordMgr* tableMgr, char* page, int attrNum, int slot) {
+	return page + directoryOffset(tableMgr->slotsPerPage) + tableMgr->storedOffsets[attrNum] * tableMgr->slotsPerPage
+	       + slot * storedAttributeSize(tableMgr, attrNum);
+}
 
-	schema->attrNames = (char**)malloc(sizeof(char*) * numAttr);
-	schema->dataTypes = (DataType*)malloc(sizeof(DataType) * numAttr);
-	schema->typeLength = (int*)malloc(sizeof(int) * numAttr);
+// bytes a record takes in a page
+int storedRecordSize(RM_RecordMgr* tableMgr, char* data) {
+	if (tableMgr->format == RM_FORMAT_PAX) {
+		return tableMgr->storedOffsets[tableMgr->schema->numAttr];
+	}
+	return encodedRecordSize(tableMgr, data);
+}
 
+// store the record in a slot given by reserveSlot
+void writeSlot(RM_RecordMgr* tableMgr, char* page, int slot, char* data) {
+	Schema* schema = tableMgr->schema;
+	if (tableMgr->format == RM_FORMAT_PAX) {
+		for (int i = 0; i < schema->numAttr; i++) {
+			if (isDictionaryEncoded(tableMgr, i)) {
+				uint16_t code = encodeString(tableMgr, data + schema->attrOffsets[i], i);
+				memcpy(paxValue(tableMgr, page, i, slot), &code, sizeof(uint16_t));
+				continue;
+			}
+			memcpy(paxValue(tableMgr, page, i, slot), data + schema->attrOffsets[i], attributeSize(schema, i));
+		}
+		return;
+	}
+	encodeRecord(tableMgr, data, slotData(tableMgr, page, slot));
+}
 
-	for (int i = 0; i < numAttr; i++) {
-		schema->attrNames[i] = (char*)malloc(ATTRIBUTE_NAME_LEN);
-		memcpy(schema->attrNames[i], pageHandle->data, ATTRIBUTE_NAME_LEN);
-		pageHandle->data += ATTRIBUTE_NAME_LEN;
+/*
+ * Copy the record of a slot in the in memory layout, only the attributes of projection if it is not NULL. The page may be
+ * read optimistically: an entry of the directory being changed can point out of the page, the record is then read as
+ * empty and the caller's validation fails.
+ */
+void readSlot(RM_RecordMgr* tableMgr, char* page, int slot, char* data, bool* projection) {
+	Schema* schema = tableMgr->schema;
+	if (tableMgr->format == RM_FORMAT_PAX) {
+		for (int i = 0; i < schema->numAttr; i++) {
+			if (projection != NULL && !projection[i]) {
+				continue;
+			}
+			if (isDictionaryEncoded(tableMgr, i)) {
+				uint16_t code;
+				memcpy(&code, paxValue(tableMgr, page, i, slot), sizeof(uint16_t));
+				decodeString(tableMgr->dictionaries[i], code, data + schema->attrOffsets[i], attributeSize(schema, i));
+				continue;
+			}
+			memcpy(data + schema->attrOffsets[i], paxValue(tableMgr, page, i, slot), attributeSize(schema, i));
+		}
+		return;
+	}
+	RM_SlotEntry entry = slotDirectory(tableMgr, page)[slot];
+	if (entry.offset + entry.length > PAGE_SIZE) {
+		entry.length = 0;
+	}
+	decodeRecord(tableMgr, page + entry.offset, entry.length, data, projection);
+}
 
-		schema->dataTypes[i] = *(int*)pageHandle->data;
-		pageHandle->data = pageHandle->data + sizeof(int);
+void initDataPage(RM_RecordMgr* tableMgr, char* page) {
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	header->numberOfSlots = 0;
+	header->numberOfRecords = 0;
+	header->freeSpaceOffset = PAGE_SIZE;
+	if (tableMgr->format == RM_FORMAT_PAX) {
+		header->freeBytes = tableMgr->slotsPerPage * paxSlotBytes(tableMgr);
+	}
+	else {
+		header->freeBytes = PAGE_SIZE - directoryOffset(tableMgr->slotsPerPage);
+	}
+	memset(pageBitmap(page), 0, bitmapWords(tableMgr->slotsPerPage) * sizeof(uint64_t));
+}
 
-		schema->typeLength[i] = *(int*)pageHandle->data;
-		pageHandle->data = pageHandle->data + sizeof(int);
+bool isSlotUsed(char* page, int slot) {
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	if (slot < 0 || slot >= header->numberOfSlots) {
+		return false;
 	}
+	return (pageBitmap(page)[slot / SLOTS_PER_BITMAP_WORD] >> (slot % SLOTS_PER_BITMAP_WORD)) & 1;
 }
 
-RC initRecordManager(void* mgmtData) {
-	initStorageManager();
-	recordMgr = (RM_RecordMgr*)malloc(sizeof(RM_RecordMgr));
-	return RC_OK;
+RM_SlotState slotState(RM_RecordMgr* tableMgr, char* page, int slot) {
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	if (slot < 0 || slot >= header->numberOfSlots) {
+		return SLOT_FREE;
+	}
+	bool used = isSlotUsed(page, slot);
+	if (tableMgr->format == RM_FORMAT_PAX) {
+		return used ? SLOT_RECORD : SLOT_FREE;
+	}
+	RM_SlotEntry entry = slotDirectory(tableMgr, page)[slot];
+	if (!used) {
+		return entry.length != 0 ? SLOT_FORWARD : SLOT_FREE;
+	}
+	return entry.movedIn ? SLOT_MOVED_IN : SLOT_RECORD;
 }
 
-RC shutdownRecordManager() {
-	free(recordMgr);
-	return RC_OK;
+// RID kept by a forward
+RID forwardTarget(RM_RecordMgr* tableMgr, char* page, int slot) {
+	RID target;
+	memcpy(&target, slotData(tableMgr, page, slot), sizeof(RID));
+	return target;
 }
 
-RC createTable(char* name, Schema* schema) {
-	if (createPageFile(name) != RC_OK) {
-		return RC_FILE_NOT_FOUND;
+// RID of the record of a used slot of page pageNum, the one of its forward if it moved
+RID recordId(RM_RecordMgr* tableMgr, char* page, int pageNum, int slot) {
+	RID id = {pageNum, slot};
+	if (slotState(tableMgr, page, slot) == SLOT_MOVED_IN) {
+		RM_SlotEntry entry = slotDirectory(tableMgr, page)[slot];
+		memcpy(&id, page + entry.offset + entry.length - sizeof(RID), sizeof(RID));
 	}
+	return id;
+}
 
-	BM_BufferPool* bufferPool = MAKE_POOL();
-	BM_PageHandle* pageHandle = MAKE_PAGE_HANDLE();
+/*
+ * First free slot of the directory or -1 if every slot holds a record or a forward.
+ * Whole words of the bitmap are checked at once, the free slot is then found with a bit scan.
+ */
+int findFreeSlot(RM_RecordMgr* tableMgr, char* page) {
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	uint64_t* bitmap = pageBitmap(page);
+	for (int word = 0; word < bitmapWords(header->numberOfSlots); word++) {
+		uint64_t freeSlots = ~bitmap[word];
+		while (freeSlots != 0) {
+			int slot = word * SLOTS_PER_BITMAP_WORD + __builtin_ctzll(freeSlots);
+			// bits after the last slot of the directory are never set, they are not free slots
+			if (slot >= header->numberOfSlots) {
+				return -1;
+			}
+			if (slotState(tableMgr, page, slot) == SLOT_FREE) {
+				return slot;
+			}
+			freeSlots &= freeSlots - 1;
+		}
+	}
+	return -1;
+}
 
-	//We decided 5 pages for the buffer and LRU strategy
-	if (initBufferPool(bufferPool, name, 5, RS_LRU, NULL) != RC_OK) {
-		return RC_FILE_NOT_FOUND;
+/*
+ * First set bit of a bitmap of numberOfBits bits starting from bit from, or -1 if there is none. Empty words of the bitmap
+ * are skipped at once.
+ */
+int findSetBit(uint64_t* bitmap, int numberOfBits, int from) {
+	if (from >= numberOfBits) {
+		return -1;
+	}
+	int word = from / SLOTS_PER_BITMAP_WORD;
+	// ignoring the bits before from in the first word
+	uint64_t bits = bitmap[word] & (~(uint64_t)0 << (from % SLOTS_PER_BITMAP_WORD));
+	while (bits == 0) {
+		word++;
+		if (word >= bitmapWords(numberOfBits)) {
+			return -1;
+		}
+		bits = bitmap[word];
 	}
+	return word * SLOTS_PER_BITMAP_WORD + __builtin_ctzll(bits);
+}
 
-	if (pinPage(bufferPool, pageHandle, 0) != RC_OK) {
-		return RC_WRITE_FAILED;
+// First slot holding a record starting from slot from, or -1 if there is none
+int findUsedSlot(char* page, int from) {
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	return findSetBit(pageBitmap(page), header->numberOfSlots, from);
+}
+
+// true if a record of length bytes can be added to the page, possibly after compacting it
+bool hasRoomFor(RM_RecordMgr* tableMgr, char* page, int length) {
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	if (tableMgr->format == RM_FORMAT_PAX) {
+		return findFreeSlot(tableMgr, page) != -1 || header->numberOfSlots < tableMgr->slotsPerPage;
 	}
+	if (findFreeSlot(tableMgr, page) != -1) {
+		return header->freeBytes >= length;
+	}
+	return header->numberOfSlots < tableMgr->slotsPerPage && header->freeBytes >= length + (int)sizeof(RM_SlotEntry);
+}
 
-	initialFillPageHandle(pageHandle, schema);
+/*
+ * Move all the records to the end of the page so the holes left by deletes and updates become free space again.
+ */
+void compactPage(RM_RecordMgr* tableMgr, char* page) {
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	RM_SlotEntry* directory = slotDirectory(tableMgr, page);
+	char buffer[PAGE_SIZE];
+	int end = PAGE_SIZE;
+	// the forwards keep their bytes too
+	for (int slot = 0; slot < header->numberOfSlots; slot++) {
+		if (directory[slot].length == 0) {
+			continue;
+		}
+		end -= directory[slot].length;
+		memcpy(buffer + end, page + directory[slot].offset, directory[slot].length);
+		directory[slot].offset = end;
+	}
+	memcpy(page + end, buffer + end, PAGE_SIZE - end);
+	header->freeSpaceOffset = end;
+}
 
-	if (unpinPage(bufferPool, pageHandle) != RC_OK) {
-		return RC_READ_NON_EXISTING_PAGE;
+/*
+ * Take length bytes of free space of the page, compacting the page when the free space is cut in holes.
+ * extra bytes are kept free for a new entry of the directory. Returns the offset of the space or -1 if it does not fit.
+ */
+int allocateRecordSpace(RM_RecordMgr* tableMgr, char* page, int length, int extra) {
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	if (header->freeBytes < length + extra) {
+		return -1;
+	}
+	int directoryEnd = directoryOffset(tableMgr->slotsPerPage) + header->numberOfSlots * sizeof(RM_SlotEntry);
+	if (header->freeSpaceOffset - directoryEnd < length + extra) {
+		compactPage(tableMgr, page);
 	}
+	header->freeSpaceOffset -= length;
+	header->freeBytes -= length;
+	return header->freeSpaceOffset;
+}
 
-	if (forcePage(bufferPool, pageHandle) != RC_OK) {
-		return RC_WRITE_FAILED;
+/*
+ * Give a slot and length bytes to a new record of the page, -1 if it does not fit.
+ * A free slot of the directory is reused before adding an entry to the directory.
+ */
+int reserveSlot(RM_RecordMgr* tableMgr, char* page, int length) {
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	int slot = findFreeSlot(tableMgr, page);
+	int extra = 0;
+	if (slot == -1) {
+		if (header->numberOfSlots == tableMgr->slotsPerPage) {
+			return -1;
+		}
+		slot = header->numberOfSlots;
+		extra = sizeof(RM_SlotEntry);
 	}
 
-	if (shutdownBufferPool(bufferPool) != RC_OK) {
-		return RC_READ_NON_EXISTING_PAGE;
+	if (tableMgr->format == RM_FORMAT_PAX) {
+		// the slot has its place in every minipage
+		if (extra != 0) {
+			header->numberOfSlots++;
+		}
+		header->freeBytes -= paxSlotBytes(tableMgr);
+		pageBitmap(page)[slot / SLOTS_PER_BITMAP_WORD] |= (uint64_t)1 << (slot % SLOTS_PER_BITMAP_WORD);
+		header->numberOfRecords++;
+		return slot;
 	}
 
-	free(pageHandle);
-	free(bufferPool);
+	int offset = allocateRecordSpace(tableMgr, page, length, extra);
+	if (offset == -1) {
+		return -1;
+	}
+	if (extra != 0) {
+		header->numberOfSlots++;
+		header->freeBytes -= extra;
+	}
 
-	return RC_OK;
+	RM_SlotEntry* entry = &slotDirectory(tableMgr, page)[slot];
+	entry->offset = offset;
+	entry->movedIn = 0;
+	entry->length = length;
+	pageBitmap(page)[slot / SLOTS_PER_BITMAP_WORD] |= (uint64_t)1 << (slot % SLOTS_PER_BITMAP_WORD);
+	header->numberOfRecords++;
+	return slot;
 }
 
-RC openTable(RM_TableData* rel, char* name) {
+void setSlotFree(RM_RecordMgr* tableMgr, char* page, int slot) {
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	pageBitmap(page)[slot / SLOTS_PER_BITMAP_WORD] &= ~((uint64_t)1 << (slot % SLOTS_PER_BITMAP_WORD));
+	header->numberOfRecords--;
+	if (tableMgr->format == RM_FORMAT_PAX) {
+		header->freeBytes += paxSlotBytes(tableMgr);
+		return;
+	}
+	RM_SlotEntry* entry = &slotDirectory(tableMgr, page)[slot];
+	header->freeBytes += entry->length;
+	entry->length = 0;
+	entry->movedIn = 0;
+}
 
-	recordMgr->bufferPool = MAKE_POOL();
-	recordMgr->pageHandle = MAKE_PAGE_HANDLE();
-	recordMgr->freeRecordsQueue = initFreeRecordsQueue();
+// slot reserveSlot gives to the next record of a page having room for it
+int nextSlot(RM_RecordMgr* tableMgr, char* page) {
+	int slot = findFreeSlot(tableMgr, page);
+	return slot != -1 ? slot : ((RM_PageHeader*)page)->numberOfSlots;
+}
 
-	if (initBufferPool(recordMgr->bufferPool, name, 5, RS_LRU, NULL) != RC_OK) {
-		return RC_FILE_NOT_FOUND;
+// true if data can replace the record of a used slot or of a forward of the page, possibly after compacting the page
+bool fitsInSlot(RM_RecordMgr* tableMgr, char* page, int slot, char* data) {
+	if (tableMgr->format == RM_FORMAT_PAX) {
+		return true;
 	}
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	RM_SlotEntry entry = slotDirectory(tableMgr, page)[slot];
+	int length = encodedRecordSize(tableMgr, data) + (entry.movedIn ? (int)sizeof(RID) : 0);
+	return header->freeBytes + entry.length >= length;
+}
 
-	if (pinPage(recordMgr->bufferPool, recordMgr->pageHandle, 0) != RC_OK) {
-		return RC_WRITE_FAILED;
+// Give length bytes to a slot holding a record or a forward, its old bytes are lost. The page must have room for them.
+char* resizeSlot(RM_RecordMgr* tableMgr, char* page, int slot, int length) {
+	RM_SlotEntry* entry = &slotDirectory(tableMgr, page)[slot];
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	if (length > entry->length) {
+		// the old record becomes a hole, compacting the page may give back enough space for the new one
+		header->freeBytes += entry->length;
+		entry->length = 0;
+		entry->offset = allocateRecordSpace(tableMgr, page, length, 0);
+	}
+	else {
+		header->freeBytes += entry->length - length;
+	}
+	entry->length = length;
+	return page + entry->offset;
+}
+
+/*
+ * Replace the record of a used slot or of a forward by data, fitsInSlot must be true. A forward holds the record again
+ * afterwards, a moved record keeps the RID of its forward.
+ */
+void updateSlot(RM_RecordMgr* tableMgr, char* page, int slot, char* data) {
+	// records of a PAX table have a fixed size, they are always updated in place
+	if (tableMgr->format == RM_FORMAT_PAX) {
+		writeSlot(tableMgr, page, slot, data);
+		return;
+	}
+	RM_SlotEntry* entry = &slotDirectory(tableMgr, page)[slot];
+	int length = encodedRecordSize(tableMgr, data);
+	if (!entry->movedIn) {
+		encodeRecord(tableMgr, data, resizeSlot(tableMgr, page, slot, length));
+		pageBitmap(page)[slot / SLOTS_PER_BITMAP_WORD] |= (uint64_t)1 << (slot % SLOTS_PER_BITMAP_WORD);
+		return;
+	}
+	RID home;
+	memcpy(&home, page + entry->offset + entry->length - sizeof(RID), sizeof(RID));
+	char* bytes = resizeSlot(tableMgr, page, slot, length + sizeof(RID));
+	encodeRecord(tableMgr, data, bytes);
+	memcpy(bytes + length, &home, sizeof(RID));
+}
+
+// store a record moved from the forward home in a slot given by reserveSlot for encodedRecordSize + sizeof(RID) bytes
+void writeMovedSlot(RM_RecordMgr* tableMgr, char* page, int slot, char* data, RID home) {
+	RM_SlotEntry* entry = &slotDirectory(tableMgr, page)[slot];
+	encodeRecord(tableMgr, data, page + entry->offset);
+	memcpy(page + entry->offset + entry->length - sizeof(RID), &home, sizeof(RID));
+	entry->movedIn = 1;
+}
+
+/*
+ * Make a slot holding a record or a forward a forward to target, the page must have room for the RID. The slot is still
+ * counted in the page header but leaves the occupancy bitmap.
+ */
+void forwardSlot(RM_RecordMgr* tableMgr, char* page, int slot, RID target) {
+	memcpy(resizeSlot(tableMgr, page, slot, sizeof(RID)), &target, sizeof(RID));
+	pageBitmap(page)[slot / SLOTS_PER_BITMAP_WORD] &= ~((uint64_t)1 << (slot % SLOTS_PER_BITMAP_WORD));
+}
+
+bool isFreeSpaceMapPage(int page) {
+	return page >= 1 && (page - 1) % (FSM_DATA_PAGES_PER_MAP_PAGE + 1) == 0;
+}
+
+// the map page describing a data page
+int freeSpaceMapPage(int page) {
+	return 1 + (page - 1) / (FSM_DATA_PAGES_PER_MAP_PAGE + 1) * (FSM_DATA_PAGES_PER_MAP_PAGE + 1);
+}
+
+bool isDataPage(RM_RecordMgr* tableMgr, int page) {
+	return page >= 1 && page <= tableMgr->numberOfPages && !isFreeSpaceMapPage(page);
+}
+
+// free space of a data page as stored in the map, 0 when no record can be added
+int freeSpaceCategory(RM_RecordMgr* tableMgr, char* page) {
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	if (findFreeSlot(tableMgr, page) == -1 && header->numberOfSlots == tableMgr->slotsPerPage) {
+		return 0;
+	}
+	int category = header->freeBytes / FSM_BYTES_PER_CATEGORY;
+	return category < FSM_CATEGORIES ? category : FSM_CATEGORIES - 1;
+}
+
+// the smallest category sure to have room for a record of length bytes and a new directory entry
+int requiredCategory(int length) {
+	return (length + sizeof(RM_SlotEntry) + FSM_BYTES_PER_CATEGORY - 1) / FSM_BYTES_PER_CATEGORY;
+}
+
+int getFreeSpaceEntry(char* mapPage, int index) {
+	return (mapPage[index / 2] >> (index % 2 * 4)) & 0xF;
+}
+
+/*
+ * Store the free space category of a data page in its map page. The map page is only written if the category changed.
+ */
+RC setFreeSpace(RM_RecordMgr* tableMgr, int page, int category) {
+	BM_PageHandle mapHandle;
+	int mapPage = freeSpaceMapPage(page);
+	int index = page - mapPage - 1;
+
+	if (pinPage(tableMgr->bufferPool, &mapHandle, mapPage) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	if (getFreeSpaceEntry(mapHandle.data, index) != category) {
+		if (markDirty(tableMgr->bufferPool, &mapHandle) != RC_OK) {
+			unpinPage(tableMgr->bufferPool, &mapHandle);
+			return RC_WRITE_FAILED;
+		}
+		int shift = index % 2 * 4;
+		mapHandle.data[index / 2] = (mapHandle.data[index / 2] & ~(0xF << shift)) | (category << shift);
+	}
+	return unpinPage(tableMgr->bufferPool, &mapHandle);
+}
+
+RC initFreeSpaceMapPage(RM_RecordMgr* tableMgr, int mapPage) {
+	BM_PageHandle mapHandle;
+	if (pinPage(tableMgr->bufferPool, &mapHandle, mapPage) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	if (markDirty(tableMgr->bufferPool, &mapHandle) != RC_OK) {
+		unpinPage(tableMgr->bufferPool, &mapHandle);
+		return RC_WRITE_FAILED;
+	}
+	// pages not created yet have no room
+	memset(mapHandle.data, 0, PAGE_SIZE);
+	return unpinPage(tableMgr->bufferPool, &mapHandle);
+}
+
+/*
+ * First data page from page on that the map says has room for a record of length bytes, -1 if there is none.
+ * A byte of the map describing two full pages is skipped at once.
+ */
+int findPageWithRoom(RM_RecordMgr* tableMgr, int page, int length) {
+	int category = requiredCategory(length);
+	if (category >= FSM_CATEGORIES) {
+		return -1;
+	}
+	if (isFreeSpaceMapPage(page)) {
+		page++;
+	}
+	while (page <= tableMgr->numberOfPages) {
+		BM_PageHandle mapHandle;
+		int mapPage = freeSpaceMapPage(page);
+		int lastPage = mapPage + FSM_DATA_PAGES_PER_MAP_PAGE;
+		if (lastPage > tableMgr->numberOfPages) {
+			lastPage = tableMgr->numberOfPages;
+		}
+		if (pinPage(tableMgr->bufferPool, &mapHandle, mapPage) != RC_OK) {
+			return -1;
+		}
+		int found = -1;
+		for (; page <= lastPage; page++) {
+			int index = page - mapPage - 1;
+			if (index % 2 == 0 && mapHandle.data[index / 2] == 0 && page + 1 <= lastPage) {
+				page++;
+				continue;
+			}
+			if (getFreeSpaceEntry(mapHandle.data, index) >= category) {
+				found = page;
+				break;
+			}
+		}
+		unpinPage(tableMgr->bufferPool, &mapHandle);
+		if (found != -1) {
+			return found;
+		}
+		// the next page is the map page of the next group
+		page = lastPage + 2;
+	}
+	return -1;
+}
+
+void initZoneMap(RM_RecordMgr* tableMgr) {
+	RM_ZoneMap* zones = &tableMgr->zones;
+	Schema* schema = tableMgr->schema;
+	zones->numberOfPages = 0;
+	zones->numberOfAttrs = 0;
+	zones->zoneOfAttr = (int*)malloc(sizeof(int) * schema->numAttr);
+	for (int i = 0; i < schema->numAttr; i++) {
+		bool numeric = schema->dataTypes[i] == DT_INT || schema->dataTypes[i] == DT_FLOAT;
+		zones->zoneOfAttr[i] = numeric ? zones->numberOfAttrs++ : -1;
+	}
+	zones->known = NULL;
+	zones->numberOfRecords = NULL;
+	zones->min = NULL;
+	zones->max = NULL;
+}
+
+void freeZoneMap(RM_RecordMgr* tableMgr) {
+	RM_ZoneMap* zones = &tableMgr->zones;
+	free(zones->zoneOfAttr);
+	free(zones->known);
+	free(zones->numberOfRecords);
+	free(zones->min);
+	free(zones->max);
+}
+
+// give page an entry, the pages added have no zone
+void growZoneMap(RM_ZoneMap* zones, int page) {
+	if (page < zones->numberOfPages) {
+		return;
+	}
+	int numberOfPages = zones->numberOfPages == 0 ? 64 : zones->numberOfPages;
+	while (numberOfPages <= page) {
+		numberOfPages *= 2;
+	}
+	zones->known = (bool*)realloc(zones->known, sizeof(bool) * numberOfPages);
+	zones->numberOfRecords = (int*)realloc(zones->numberOfRecords, sizeof(int) * numberOfPages);
+	zones->min = (double*)realloc(zones->min, sizeof(double) * numberOfPages * zones->numberOfAttrs);
+	zones->max = (double*)realloc(zones->max, sizeof(double) * numberOfPages * zones->numberOfAttrs);
+	memset(zones->known + zones->numberOfPages, 0, sizeof(bool) * (numberOfPages - zones->numberOfPages));
+	zones->numberOfPages = numberOfPages;
+}
+
+bool hasZone(RM_ZoneMap* zones, int page) {
+	return page < zones->numberOfPages && zones->known[page];
+}
+
+// a page without records and with empty ranges
+void startZone(RM_RecordMgr* tableMgr, int page) {
+	RM_ZoneMap* zones = &tableMgr->zones;
+	growZoneMap(zones, page);
+	zones->known[page] = true;
+	zones->numberOfRecords[page] = 0;
+	for (int i = 0; i < zones->numberOfAttrs; i++) {
+		zones->min[page * zones->numberOfAttrs + i] = INFINITY;
+		zones->max[page * zones->numberOfAttrs + i] = -INFINITY;
+	}
+}
+
+// widen the ranges of the zone of page with the value of an attribute, stored at value
+void widenZone(RM_ZoneMap* zones, int page, Schema* schema, int attrNum, char* value) {
+	int index = page * zones->numberOfAttrs + zones->zoneOfAttr[attrNum];
+	double number;
+	if (schema->dataTypes[attrNum] == DT_INT) {
+		int intValue;
+		memcpy(&intValue, value, sizeof(int));
+		number = intValue;
+	}
+	else {
+		float floatValue;
+		memcpy(&floatValue, value, sizeof(float));
+		number = floatValue;
+	}
+	if (number < zones->min[index]) {
+		zones->min[index] = number;
+	}
+	if (number > zones->max[index]) {
+		zones->max[index] = number;
+	}
+}
+
+// widen the zone of page with a record in the in memory layout, counting it as a new record of the page if added is true
+void addToZone(RM_RecordMgr* tableMgr, int page, char* data, bool added) {
+	RM_ZoneMap* zones = &tableMgr->zones;
+	Schema* schema = tableMgr->schema;
+	if (!hasZone(zones, page)) {
+		return;
+	}
+	if (added) {
+		zones->numberOfRecords[page]++;
+	}
+	for (int i = 0; i < schema->numAttr; i++) {
+		if (zones->zoneOfAttr[i] != -1) {
+			widenZone(zones, page, schema, i, data + schema->attrOffsets[i]);
+		}
+	}
+}
+
+void removeFromZone(RM_RecordMgr* tableMgr, int page) {
+	if (hasZone(&tableMgr->zones, page)) {
+		tableMgr->zones.numberOfRecords[page]--;
+	}
+}
+
+// compute the zone of a pinned data page that has none yet
+void summarizePage(RM_RecordMgr* tableMgr, int pageNum, char* page) {
+	RM_ZoneMap* zones = &tableMgr->zones;
+	Schema* schema = tableMgr->schema;
+	if (hasZone(zones, pageNum)) {
+		return;
+	}
+	startZone(tableMgr, pageNum);
+	int numberOfSlots = ((RM_PageHeader*)page)->numberOfSlots;
+	for (int slot = findUsedSlot(page, 0); slot != -1 && slot < numberOfSlots; slot = findUsedSlot(page, slot + 1)) {
+		zones->numberOfRecords[pageNum]++;
+		char* attrData = tableMgr->format == RM_FORMAT_PAX ? NULL : slotData(tableMgr, page, slot);
+		for (int i = 0; i < schema->numAttr; i++) {
+			char* value = attrData != NULL ? attrData : paxValue(tableMgr, page, i, slot);
+			if (zones->zoneOfAttr[i] != -1) {
+				widenZone(zones, pageNum, schema, i, value);
+			}
+			if (attrData == NULL) {
+				continue;
+			}
+			if (isDictionaryEncoded(tableMgr, i)) {
+				attrData += sizeof(uint16_t);
+			}
+			else if (schema->dataTypes[i] == DT_STRING) {
+				uint16_t length;
+				memcpy(&length, attrData, sizeof(uint16_t));
+				attrData += sizeof(uint16_t) + length;
+			}
+			else {
+				attrData += attributeSize(schema, i);
+			}
+		}
+	}
+}
+
+/*
+ * Whether expr can be true (*mayBeTrue) and can be false (*mayBeFalse) for a record of a page with a zone. Comparisons of
+ * an int or float attribute with a constant of its type are decided with the range of the attribute, anything else can
+ * be both.
+ */
+void zoneTruth(RM_RecordMgr* tableMgr, int page, Expr* expr, bool* mayBeTrue, bool* mayBeFalse) {
+	RM_ZoneMap* zones = &tableMgr->zones;
+	Schema* schema = tableMgr->schema;
+	*mayBeTrue = true;
+	*mayBeFalse = true;
+	if (expr->type != EXPR_OP) {
+		return;
+	}
+	Operator* op = expr->expr.op;
+	bool leftTrue, leftFalse, rightTrue, rightFalse;
+	switch (op->type) {
+	case OP_BOOL_NOT:
+		zoneTruth(tableMgr, page, op->args[0], mayBeFalse, mayBeTrue);
+		return;
+	case OP_BOOL_AND:
+		zoneTruth(tableMgr, page, op->args[0], &leftTrue, &leftFalse);
+		zoneTruth(tableMgr, page, op->args[1], &rightTrue, &rightFalse);
+		*mayBeTrue = leftTrue && rightTrue;
+		*mayBeFalse = leftFalse || rightFalse;
+		return;
+	case OP_BOOL_OR:
+		zoneTruth(tableMgr, page, op->args[0], &leftTrue, &leftFalse);
+		zoneTruth(tableMgr, page, op->args[1], &rightTrue, &rightFalse);
+		*mayBeTrue = leftTrue || rightTrue;
+		*mayBeFalse = leftFalse && rightFalse;
+		return;
+	case OP_COMP_EQUAL:
+	case OP_COMP_SMALLER:
+		break;
+	}
+
+	// attribute on the left or on the right of the constant
+	Expr* attribute = op->args[0];
+	Expr* constant = op->args[1];
+	bool attributeFirst = true;
+	if (attribute->type != EXPR_ATTRREF) {
+		attribute = op->args[1];
+		constant = op->args[0];
+		attributeFirst = false;
+	}
+	if (attribute->type != EXPR_ATTRREF || constant->type != EXPR_CONST) {
+		return;
+	}
+	int attrNum = attribute->expr.attrRef;
+	if (attrNum < 0 || attrNum >= schema->numAttr || zones->zoneOfAttr[attrNum] == -1
+	    || constant->expr.cons->dt != schema->dataTypes[attrNum]) {
+		return;
+	}
+	int index = page * zones->numberOfAttrs + zones->zoneOfAttr[attrNum];
+	double min = zones->min[index];
+	double max = zones->max[index];
+	double value = constant->expr.cons->dt == DT_INT ? constant->expr.cons->v.intV : constant->expr.cons->v.floatV;
+
+	if (op->type == OP_COMP_EQUAL) {
+		*mayBeTrue = min <= value && value <= max;
+		*mayBeFalse = !(min == value && max == value);
+	}
+	else if (attributeFirst) {
+		*mayBeTrue = min < value;
+		*mayBeFalse = max >= value;
+	}
+	else {
+		*mayBeTrue = max > value;
+		*mayBeFalse = min <= value;
+	}
+}
+
+// false if the zone of page says no record of it satisfies cond (NULL for all records), the page can then be skipped
+bool pageMayMatch(RM_RecordMgr* tableMgr, int page, Expr* cond) {
+	if (!hasZone(&tableMgr->zones, page)) {
+		return true;
+	}
+	if (tableMgr->zones.numberOfRecords[page] == 0) {
+		return false;
+	}
+	if (cond == NULL) {
+		return true;
+	}
+	bool mayBeTrue, mayBeFalse;
+	zoneTruth(tableMgr, page, cond, &mayBeTrue, &mayBeFalse);
+	return mayBeTrue;
+}
+
+/*
+ * The statistics are stored in page 0 after the checkpoint LSN: [analyzed numberOfTuples sampledTuples] then for every
+ * attribute [distinctValues hasHistogram bounds registers]. analyzed is 0 (and nothing follows) for a table never analyzed.
+ */
+int statisticsSize(Schema* schema) {
+	int attrSize = sizeof(double) + sizeof(int) + sizeof(double) * (STATISTICS_BUCKETS + 1) + HLL_REGISTERS;
+	return 3 * sizeof(int) + schema->numAttr * attrSize;
+}
+
+// bytes of page 0 before the statistics
+int metadataSize(Schema* schema) {
+	return (3 + schema->keySize) * sizeof(int) + schema->numAttr * (ATTRIBUTE_NAME_LEN + 2 * sizeof(int)) + 3 * sizeof(int)
+	       + schema->numAttr * sizeof(int) + sizeof(WAL_LSN);
+}
+
+void writeStatistics(BM_PageHandle* pageHandle, RM_Statistics* statistics, Schema* schema) {
+	*(int*)pageHandle->data = statistics != NULL;
+	pageHandle->data += sizeof(int);
+	if (statistics == NULL) {
+		return;
+	}
+	*(int*)pageHandle->data = statistics->numberOfTuples;
+	pageHandle->data += sizeof(int);
+	*(int*)pageHandle->data = statistics->sampledTuples;
+	pageHandle->data += sizeof(int);
+
+	for (int i = 0; i < schema->numAttr; i++) {
+		RM_AttrStatistics* attr = &statistics->attrs[i];
+		memcpy(pageHandle->data, &attr->distinctValues, sizeof(double));
+		pageHandle->data += sizeof(double);
+		*(int*)pageHandle->data = attr->hasHistogram;
+		pageHandle->data += sizeof(int);
+		memcpy(pageHandle->data, attr->bounds, sizeof(attr->bounds));
+		pageHandle->data += sizeof(attr->bounds);
+		memcpy(pageHandle->data, attr->registers, HLL_REGISTERS);
+		pageHandle->data += HLL_REGISTERS;
+	}
+}
+
+RM_Statistics* readStatistics(BM_PageHandle* pageHandle, Schema* schema) {
+	int analyzed = *(int*)pageHandle->data;
+	pageHandle->data += sizeof(int);
+	if (!analyzed) {
+		return NULL;
+	}
+	RM_Statistics* statistics = (RM_Statistics*)malloc(sizeof(RM_Statistics));
+	statistics->numberOfTuples = *(int*)pageHandle->data;
+	pageHandle->data += sizeof(int);
+	statistics->sampledTuples = *(int*)pageHandle->data;
+	pageHandle->data += sizeof(int);
+
+	statistics->attrs = (RM_AttrStatistics*)malloc(sizeof(RM_AttrStatistics) * schema->numAttr);
+	for (int i = 0; i < schema->numAttr; i++) {
+		RM_AttrStatistics* attr = &statistics->attrs[i];
+		memcpy(&attr->distinctValues, pageHandle->data, sizeof(double));
+		pageHandle->data += sizeof(double);
+		attr->hasHistogram = *(int*)pageHandle->data;
+		pageHandle->data += sizeof(int);
+		memcpy(attr->bounds, pageHandle->data, sizeof(attr->bounds));
+		pageHandle->data += sizeof(attr->bounds);
+		memcpy(attr->registers, pageHandle->data, HLL_REGISTERS);
+		pageHandle->data += HLL_REGISTERS;
+	}
+	return statistics;
+}
+
+void freeStatistics(RM_Statistics* statistics) {
+	if (statistics != NULL) {
+		free(statistics->attrs);
+		free(statistics);
+	}
+}
+
+/*
+ * Fill a pageHandle with initial values
+ * content is [numberOfTuples numberOfAttributes keySize keyAttr1 keyAttr2 ... attr1Name attr1DataType attr1TypeLen attr2Name attr2DataType attr2TypeLen ... recordSize numberOfPages format attr1Encoded attr2Encoded ... checkpointLSN]
+*/
+void initialFillPageHandle(BM_PageHandle* pageHandle, Schema* schema, RM_TableFormat format, bool* dictionaryEncoded) {
+	//Number of Tuples: 0 in the first 4 bytes
+	*(int*)pageHandle->data = 0;
+	pageHandle->data = pageHandle->data + sizeof(int);
+
+	// Setting the number of attributes
+	*(int*)pageHandle->data = schema->numAttr;
+	pageHandle->data = pageHandle->data + sizeof(int);
+
+	// Setting the Key Size of the attributes
+	*(int*)pageHandle->data = schema->keySize;
+	pageHandle->data = pageHandle->data + sizeof(int);
+
+	// storing key attr
+	for (int i = 0; i < schema->keySize; i++) {
+		*(int*)pageHandle->data = (int)schema->keyAttrs[i];
+		pageHandle->data += sizeof(int);
+	}
+
+	for (int i = 0; i < schema->numAttr; i++) {
+		strncpy(pageHandle->data, schema->attrNames[i], ATTRIBUTE_NAME_LEN);
+		pageHandle->data = pageHandle->data + ATTRIBUTE_NAME_LEN;
+
+		*(int*)pageHandle->data = (int)schema->dataTypes[i];
+		pageHandle->data += sizeof(int);
+
+		*(int*)pageHandle->data = (int)schema->typeLength[i];
+		pageHandle->data += sizeof(int);
+	}
+
+	*(int*)pageHandle->data = getRecordSize(schema);
+	pageHandle->data = pageHandle->data + sizeof(int);
+
+	// no data page yet
+	*(int*)pageHandle->data = 0;
+	pageHandle->data = pageHandle->data + sizeof(int);
+
+	*(int*)pageHandle->data = format;
+	pageHandle->data = pageHandle->data + sizeof(int);
+
+	// only string attributes can be dictionary encoded
+	for (int i = 0; i < schema->numAttr; i++) {
+		*(int*)pageHandle->data = dictionaryEncoded != NULL && dictionaryEncoded[i] && schema->dataTypes[i] == DT_STRING;
+		pageHandle->data += sizeof(int);
+	}
+
+	// nothing logged yet
+	memset(pageHandle->data, 0, sizeof(WAL_LSN));
+	pageHandle->data += sizeof(WAL_LSN);
+
+	writeStatistics(pageHandle, NULL, schema);
+}
+
+void finalFillPageHandle(BM_PageHandle* pageHandle, RM_TableData* table) {
+	Schema* schema = table->schema;
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)table->mgmtData;
+
+	//Number of Tuples: 0 in the first 4 bytes
+	*(int*)pageHandle->data = recordMgr->tuplesCount;
+	pageHandle->data = pageHandle->data + sizeof(int);
+
+	// Setting the number of attributes
+	*(int*)pageHandle->data = schema->numAttr;
+	pageHandle->data = pageHandle->data + sizeof(int);
+
+	// Setting the Key Size of the attributes
+	*(int*)pageHandle->data = schema->keySize;
+	pageHandle->data = pageHandle->data + sizeof(int);
+
+	// storing key attr
+	for (int i = 0; i < schema->keySize; i++) {
+		*(int*)pageHandle->data = (int)schema->keyAttrs[i];
+		pageHandle->data += sizeof(int);
+	}
+
+	for (int i = 0; i < schema->numAttr; i++) {
+		strncpy(pageHandle->data, schema->attrNames[i], ATTRIBUTE_NAME_LEN);
+		pageHandle->data = pageHandle->data + ATTRIBUTE_NAME_LEN;
+
+		*(int*)pageHandle->data = (int)schema->dataTypes[i];
+		pageHandle->data += sizeof(int);
+
+		*(int*)pageHandle->data = (int)schema->typeLength[i];
+		pageHandle->data += sizeof(int);
+	}
+
+	*(int*)pageHandle->data = recordMgr->recordSize;
+	pageHandle->data = pageHandle->data + sizeof(int);
+
+	*(int*)pageHandle->data = recordMgr->numberOfPages;
+	pageHandle->data = pageHandle->data + sizeof(int);
+
+	*(int*)pageHandle->data = recordMgr->format;
+	pageHandle->data = pageHandle->data + sizeof(int);
+
+	for (int i = 0; i < schema->numAttr; i++) {
+		*(int*)pageHandle->data = isDictionaryEncoded(recordMgr, i);
+		pageHandle->data += sizeof(int);
+	}
+
+	memcpy(pageHandle->data, &recordMgr->checkpointLSN, sizeof(WAL_LSN));
+	pageHandle->data += sizeof(WAL_LSN);
+
+	writeStatistics(pageHandle, recordMgr->statistics, schema);
+}
+
+void fillSchemaFromLoadedPage(BM_PageHandle* pageHandle, Schema* schema) {
+	int numAttr = *(int*)pageHandle->data;
+	schema->numAttr = numAttr;
+	pageHandle->data += sizeof(int);
+
+	schema->keySize = *(int*)pageHandle->data;
+	pageHandle->data += sizeof(int);
+
+	schema->keyAttrs = malloc(sizeof(int) * schema->keySize);
+
+	// get key attr
+	for (int i = 0; i < schema->keySize; i++) {
+		schema->keyAttrs[i] = *(int*)pageHandle->data;
+		pageHandle->data += sizeof(int);
+	}
+
+	// allocating memory to store the values
+
+	schema->attrNames = (char**)malloc(sizeof(char*) * numAttr);
+	schema->dataTypes = (DataType*)malloc(sizeof(DataType) * numAttr);
+	schema->typeLength = (int*)malloc(sizeof(int) * numAttr);
+
+
+	for (int i = 0; i < numAttr; i++) {
+		schema->attrNames[i] = (char*)malloc(ATTRIBUTE_NAME_LEN);
+		memcpy(schema->attrNames[i], pageHandle->data, ATTRIBUTE_NAME_LEN);
+		pageHandle->data += ATTRIBUTE_NAME_LEN;
+
+		schema->dataTypes[i] = *(int*)pageHandle->data;
+		pageHandle->data = pageHandle->data + sizeof(int);
+
+		schema->typeLength[i] = *(int*)pageHandle->data;
+		pageHandle->data = pageHandle->data + sizeof(int);
+	}
+	computeAttrOffsets(schema);
+}
+
+/*
+ * The dictionaries of a table are stored in the page file <table>.dict, written after values were added when the table is
+ * checkpointed or before a page using the new codes is written. For every dictionary encoded attribute it holds
+ * [numberOfValues] then [length characters] for each value. It is written in <table>.dict.new first and then renamed, a
+ * crash never leaves a partially written dictionary file.
+ */
+char* dictionaryFileName(char* name) {
+	char* fileName = (char*)malloc(strlen(name) + strlen(".dict") + 1);
+	strcpy(fileName, name);
+	strcat(fileName, ".dict");
+	return fileName;
+}
+
+RC writeDictionaries(RM_TableData* rel) {
+	RM_RecordMgr* tableMgr = (RM_RecordMgr*)rel->mgmtData;
+	int size = 0;
+	for (int i = 0; i < rel->schema->numAttr; i++) {
+		RM_Dictionary* dictionary = tableMgr->dictionaries[i];
+		if (dictionary == NULL) {
+			continue;
+		}
+		size += sizeof(int);
+		for (int code = 0; code < dictionary->numberOfValues; code++) {
+			size += sizeof(uint16_t) + dictionary->lengths[code];
+		}
+	}
+	int numberOfPages = (size + PAGE_SIZE - 1) / PAGE_SIZE;
+	char* buffer = (char*)calloc(numberOfPages, PAGE_SIZE);
+	char* data = buffer;
+	for (int i = 0; i < rel->schema->numAttr; i++) {
+		RM_Dictionary* dictionary = tableMgr->dictionaries[i];
+		if (dictionary == NULL) {
+			continue;
+		}
+		memcpy(data, &dictionary->numberOfValues, sizeof(int));
+		data += sizeof(int);
+		for (int code = 0; code < dictionary->numberOfValues; code++) {
+			uint16_t length = dictionary->lengths[code];
+			memcpy(data, &length, sizeof(uint16_t));
+			memcpy(data + sizeof(uint16_t), dictionary->values[code], length);
+			data += sizeof(uint16_t) + length;
+		}
+	}
+
+	char* fileName = dictionaryFileName(rel->name);
+	char* newFileName = (char*)malloc(strlen(fileName) + strlen(".new") + 1);
+	strcpy(newFileName, fileName);
+	strcat(newFileName, ".new");
+	SM_FileHandle fileHandle;
+	RC rc = createPageFile(newFileName);
+	if (rc == RC_OK) {
+		rc = openPageFile(newFileName, &fileHandle);
+	}
+	if (rc == RC_OK) {
+		rc = ensureCapacity(numberOfPages, &fileHandle);
+		for (int page = 0; rc == RC_OK && page < numberOfPages; page++) {
+			rc = writeBlock(page, &fileHandle, buffer + page * PAGE_SIZE);
+		}
+		if (rc == RC_OK) {
+			rc = syncPageFile(&fileHandle);
+		}
+		closePageFile(&fileHandle);
+	}
+	if (rc == RC_OK && rename(newFileName, fileName) != 0) {
+		rc = RC_WRITE_FAILED;
+	}
+	free(newFileName);
+	free(fileName);
+	free(buffer);
+	return rc;
+}
+
+// a table without a dictionary file has empty dictionaries
+RC readDictionaries(RM_TableData* rel) {
+	RM_RecordMgr* tableMgr = (RM_RecordMgr*)rel->mgmtData;
+	char* fileName = dictionaryFileName(rel->name);
+	SM_FileHandle fileHandle;
+	RC rc = openPageFile(fileName, &fileHandle);
+	free(fileName);
+	if (rc != RC_OK) {
+		return RC_OK;
+	}
+	char* buffer = (char*)malloc((size_t)fileHandle.totalNumPages * PAGE_SIZE);
+	for (int page = 0; rc == RC_OK && page < fileHandle.totalNumPages; page++) {
+		rc = readBlock(page, &fileHandle, buffer + page * PAGE_SIZE);
+	}
+	closePageFile(&fileHandle);
+	char* data = buffer;
+	for (int i = 0; rc == RC_OK && i < rel->schema->numAttr; i++) {
+		RM_Dictionary* dictionary = tableMgr->dictionaries[i];
+		if (dictionary == NULL) {
+			continue;
+		}
+		int numberOfValues;
+		memcpy(&numberOfValues, data, sizeof(int));
+		data += sizeof(int);
+		for (int code = 0; rc == RC_OK && code < numberOfValues; code++) {
+			uint16_t length;
+			memcpy(&length, data, sizeof(uint16_t));
+			if (addToDictionary(dictionary, data + sizeof(uint16_t), length) == -1) {
+				rc = RC_RM_DICTIONARY_FULL;
+			}
+			data += sizeof(uint16_t) + length;
+		}
+	}
+	free(buffer);
+	return rc;
+}
+
+/*
+ * Write-ahead log: every change of a data page is appended to the log of the table, <table>.wal, and the page keeps the
+ * LSN of its last change. A page is only written once the log is on the disk up to its LSN, so committing the changes
+ * only needs the log to be written (commitTable). Page 0 and the free space map are not logged, they are written by
+ * checkpoints and recovery rebuilds what it needs of them.
+ */
+char* logFileName(char* name) {
+	char* fileName = (char*)malloc(strlen(name) + strlen(".wal") + 1);
+	strcpy(fileName, name);
+	strcat(fileName, ".wal");
+	return fileName;
+}
+
+/*
+ * Append a change of a pinned data page to the log, before the page is changed. data is the record, followed by the RID
+ * of its forward for a moved record, or the RID kept by a forward.
+ */
+void logChange(RM_RecordMgr* tableMgr, WAL_RecordType type, char* page, int pageNum, int slot, char* data) {
+	int length = data != NULL ? tableMgr->recordSize : 0;
+	if (type == WAL_MOVE_IN) {
+		length += sizeof(RID);
+	}
+	else if (type == WAL_FORWARD) {
+		length = sizeof(RID);
+	}
+	((RM_PageHeader*)page)->pageLSN = appendLogRecord(&tableMgr->log, type, pageNum, slot, data, length);
+}
+
+/*
+ * Before write hook of the buffer pool of an open table: the log records of the changes of a data page reach the disk
+ * before the page, and so do the dictionaries giving the strings of its codes.
+ */
+RC writeAheadOfPage(void* hookData, PageNumber pageNum, char* data) {
+	RM_TableData* rel = (RM_TableData*)hookData;
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+	if (pageNum == 0 || isFreeSpaceMapPage(pageNum)) {
+		return RC_OK;
+	}
+	if (recordMgr->dictionariesChanged) {
+		if (writeDictionaries(rel) != RC_OK) {
+			return RC_WRITE_FAILED;
+		}
+		recordMgr->dictionariesChanged = false;
+	}
+	return flushLog(&recordMgr->log, ((RM_PageHeader*)data)->pageLSN);
+}
+
+// the writes to the page file of the table are on the disk when it returns
+RC syncTableFile(char* name) {
+	SM_FileHandle fileHandle;
+	if (openPageFile(name, &fileHandle) != RC_OK) {
+		return RC_FILE_NOT_FOUND;
+	}
+	RC rc = syncPageFile(&fileHandle);
+	closePageFile(&fileHandle);
+	return rc;
+}
+
+/*
+ * Write to the files of the table everything recovery would need the log for: the data pages, the dictionaries and then
+ * page 0 with the LSN where the log ends. The log is emptied afterwards.
+ */
+RC checkpointTable(RM_TableData* rel) {
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+	if (forceFlushPool(recordMgr->bufferPool) != RC_OK || syncTableFile(rel->name) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	if (recordMgr->dictionariesChanged) {
+		if (writeDictionaries(rel) != RC_OK) {
+			return RC_WRITE_FAILED;
+		}
+		recordMgr->dictionariesChanged = false;
+	}
+
+	recordMgr->checkpointLSN = recordMgr->log.nextLSN;
+	if (pinPage(recordMgr->bufferPool, recordMgr->pageHandle, 0) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	finalFillPageHandle(recordMgr->pageHandle, rel);
+	if (markDirty(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
+		unpinPage(recordMgr->bufferPool, recordMgr->pageHandle);
+		return RC_WRITE_FAILED;
+	}
+	if (unpinPage(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK
+	    || forcePage(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK || syncTableFile(rel->name) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	return resetLog(&recordMgr->log, recordMgr->checkpointLSN);
+}
+
+/*
+ * Apply a logged change to its page unless the page was written with it (its LSN is not smaller). The strings of the
+ * record are added to the dictionaries in any case: they then get the codes they had, in the order of the log.
+ */
+RC redoLogRecord(RM_RecordMgr* recordMgr, WAL_Record* logRecord) {
+	if (logRecord->data != NULL && logRecord->type != WAL_FORWARD) {
+		RC dictionaryRc = addDictionaryValues(recordMgr, logRecord->data);
+		if (dictionaryRc != RC_OK) {
+			return dictionaryRc;
+		}
+	}
+	if (logRecord->type == WAL_INSERT) {
+		recordMgr->tuplesCount++;
+	}
+	else if (logRecord->type == WAL_DELETE) {
+		recordMgr->tuplesCount--;
+	}
+	if (logRecord->page > recordMgr->numberOfPages) {
+		recordMgr->numberOfPages = logRecord->page;
+	}
+
+	BM_PageHandle pageHandle;
+	if (pinPage(recordMgr->bufferPool, &pageHandle, logRecord->page) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	char* page = pageHandle.data;
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	if (header->pageLSN >= logRecord->lsn) {
+		return unpinPage(recordMgr->bufferPool, &pageHandle);
+	}
+	if (markDirty(recordMgr->bufferPool, &pageHandle) != RC_OK) {
+		unpinPage(recordMgr->bufferPool, &pageHandle);
+		return RC_WRITE_FAILED;
+	}
+	RC rc = RC_OK;
+	switch (logRecord->type) {
+	case WAL_NEW_PAGE:
+		initDataPage(recordMgr, page);
+		break;
+	case WAL_INSERT:
+		// the page is as it was when the record was inserted, it gets the same slot
+		if (reserveSlot(recordMgr, page, storedRecordSize(recordMgr, logRecord->data)) != logRecord->slot) {
+			rc = RC_BM_CORRUPTED_PAGE;
+			break;
+		}
+		writeSlot(recordMgr, page, logRecord->slot, logRecord->data);
+		break;
+	case WAL_MOVE_IN: {
+		RID home;
+		memcpy(&home, logRecord->data + recordMgr->recordSize, sizeof(RID));
+		int length = encodedRecordSize(recordMgr, logRecord->data) + sizeof(RID);
+		if (reserveSlot(recordMgr, page, length) != logRecord->slot) {
+			rc = RC_BM_CORRUPTED_PAGE;
+			break;
+		}
+		writeMovedSlot(recordMgr, page, logRecord->slot, logRecord->data, home);
+		break;
+	}
+	case WAL_UPDATE:
+		updateSlot(recordMgr, page, logRecord->slot, logRecord->data);
+		break;
+	case WAL_FORWARD: {
+		RID target;
+		memcpy(&target, logRecord->data, sizeof(RID));
+		forwardSlot(recordMgr, page, logRecord->slot, target);
+		break;
+	}
+	case WAL_DELETE:
+	case WAL_MOVE_OUT:
+		setSlotFree(recordMgr, page, logRecord->slot);
+		break;
+	}
+	header->pageLSN = logRecord->lsn;
+	if (rc == RC_OK) {
+		rc = setFreeSpace(recordMgr, logRecord->page, freeSpaceCategory(recordMgr, page));
+	}
+	unpinPage(recordMgr->bufferPool, &pageHandle);
+	return rc;
+}
+
+/*
+ * Redo the changes logged after the last checkpoint, the table is then as it was when its last change reached the log.
+ * It is checkpointed afterwards so the log is not needed anymore.
+ */
+RC recoverTable(RM_TableData* rel) {
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+	WAL_Log* log = &recordMgr->log;
+	if (log->nextLSN < recordMgr->checkpointLSN) {
+		// the log was created again, its LSNs must stay after the ones of the pages
+		return resetLog(log, recordMgr->checkpointLSN);
+	}
+
+	WAL_LSN position = log->base;
+	WAL_Record logRecord;
+	int redone = 0;
+	RC rc = RC_OK;
+	while (rc == RC_OK && readLogRecord(log, &position, &logRecord) == RC_OK) {
+		if (logRecord.lsn > recordMgr->checkpointLSN) {
+			rc = redoLogRecord(recordMgr, &logRecord);
+			redone++;
+		}
+		free(logRecord.data);
+	}
+	if (rc != RC_OK) {
+		return rc;
+	}
+	if (redone == 0) {
+		// the records of a checkpoint that stopped before emptying the log
+		return log->nextLSN == log->base ? RC_OK : resetLog(log, log->nextLSN);
+	}
+	return checkpointTable(rel);
+}
+
+RC initRecordManager(void* mgmtData) {
+	initStorageManager();
+	return RC_OK;
+}
+
+RC shutdownRecordManager() {
+	return RC_OK;
+}
+
+RC createTable(char* name, Schema* schema) {
+	return createTableWithFormat(name, schema, RM_FORMAT_ROW);
+}
+
+/*
+ * Create a table whose data pages use format. RM_FORMAT_PAX stores the records column by column in their pages, for
+ * tables mostly scanned on a few of their attributes.
+ */
+RC createTableWithFormat(char* name, Schema* schema, RM_TableFormat format) {
+	return createTableWithDictionaries(name, schema, format, NULL);
+}
+
+/*
+ * Create a table whose string attributes with dictionaryEncoded[attrNum] set are dictionary encoded: their pages store a
+ * 2 bytes code instead of the string, for attributes with few distinct values. dictionaryEncoded can be NULL.
+ */
+RC createTableWithDictionaries(char* name, Schema* schema, RM_TableFormat format, bool* dictionaryEncoded) {
+	if (createPageFile(name) != RC_OK) {
+		return RC_FILE_NOT_FOUND;
+	}
+
+	BM_BufferPool* bufferPool = MAKE_POOL();
+	BM_PageHandle* pageHandle = MAKE_PAGE_HANDLE();
+
+	//We decided 5 pages for the buffer and LRU strategy
+	if (initBufferPool(bufferPool, name, 5, RS_LRU, NULL) != RC_OK) {
+		return RC_FILE_NOT_FOUND;
+	}
+
+	if (pinPage(bufferPool, pageHandle, 0) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+
+	initialFillPageHandle(pageHandle, schema, format, dictionaryEncoded);
+
+	if (unpinPage(bufferPool, pageHandle) != RC_OK) {
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+
+	if (forcePage(bufferPool, pageHandle) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+
+	if (shutdownBufferPool(bufferPool) != RC_OK) {
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+
+	free(pageHandle);
+	free(bufferPool);
+
+	return RC_OK;
+}
+
+/*
+ * Every open table has its own record manager (stored in rel->mgmtData) with its own buffer pool, so any number of tables
+ * can be open at the same time.
+ */
+RC openTable(RM_TableData* rel, char* name) {
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)malloc(sizeof(RM_RecordMgr));
+
+	recordMgr->bufferPool = MAKE_POOL();
+	recordMgr->pageHandle = MAKE_PAGE_HANDLE();
+
+	if (initBufferPool(recordMgr->bufferPool, name, TABLE_POOL_FRAMES, RS_LRU, NULL) != RC_OK
+	    || setBufferPoolMinimum(recordMgr->bufferPool, TABLE_POOL_FRAMES) != RC_OK) {
+		return RC_FILE_NOT_FOUND;
+	}
+
+	if (pinPage(recordMgr->bufferPool, recordMgr->pageHandle, 0) != RC_OK) {
+		return RC_WRITE_FAILED;
 	}
 
 	printf("In open table\n");
@@ -337,323 +1943,2102 @@ RC openTable(RM_TableData* rel, char* name) {
 		return RC_WRITE_FAILED;
 	}
 
-	rel->name = name;
+	rel->name = name;
+
+	recordMgr->tuplesCount = *(int*)recordMgr->pageHandle->data;
+	printf("there are %d tuples\n", recordMgr->tuplesCount);
+	recordMgr->pageHandle->data += sizeof(int);
+
+	rel->schema = (Schema*)malloc(sizeof(Schema));
+
+
+	fillSchemaFromLoadedPage(recordMgr->pageHandle, rel->schema);
+
+	recordMgr->recordSize = *(int*)recordMgr->pageHandle->data;
+	recordMgr->pageHandle->data += sizeof(int);
+
+	recordMgr->numberOfPages = *(int*)recordMgr->pageHandle->data;
+	recordMgr->pageHandle->data += sizeof(int);
+
+	recordMgr->format = *(int*)recordMgr->pageHandle->data;
+	recordMgr->pageHandle->data += sizeof(int);
+
+	recordMgr->dictionaries = (RM_Dictionary**)malloc(sizeof(RM_Dictionary*) * rel->schema->numAttr);
+	for (int i = 0; i < rel->schema->numAttr; i++) {
+		recordMgr->dictionaries[i] = *(int*)recordMgr->pageHandle->data ? createDictionary() : NULL;
+		recordMgr->pageHandle->data += sizeof(int);
+	}
+	recordMgr->dictionariesChanged = false;
+
+	memcpy(&recordMgr->checkpointLSN, recordMgr->pageHandle->data, sizeof(WAL_LSN));
+	recordMgr->pageHandle->data += sizeof(WAL_LSN);
+
+	recordMgr->statistics = readStatistics(recordMgr->pageHandle, rel->schema);
+
+	recordMgr->schema = rel->schema;
+	computeStoredOffsets(recordMgr);
+	if (recordMgr->format == RM_FORMAT_PAX) {
+		recordMgr->slotsPerPage = computePaxSlotsPerPage(recordMgr->storedOffsets[rel->schema->numAttr]);
+	}
+	else {
+		recordMgr->slotsPerPage = computeSlotsPerPage(minimumEncodedRecordSize(recordMgr));
+	}
+	recordMgr->firstFreePage = 1;
+
+	rel->mgmtData = recordMgr;
+
+	RC rc = readDictionaries(rel);
+	if (rc != RC_OK) {
+		return rc;
+	}
+	char* fileName = logFileName(name);
+	rc = openLog(&recordMgr->log, fileName);
+	free(fileName);
+	if (rc != RC_OK) {
+		return rc;
+	}
+	setBeforeWriteHook(recordMgr->bufferPool, writeAheadOfPage, rel);
+	rc = recoverTable(rel);
+	initZoneMap(recordMgr);
+	return rc;
+}
+
+RC closeTable(RM_TableData* rel) {
+	printf("Closing table\n");
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+
+	if (pinPage(recordMgr->bufferPool, recordMgr->pageHandle, 0) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	printMetaData(recordMgr->pageHandle->data);
+	if (unpinPage(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	if (checkpointTable(rel) != RC_OK || closeLog(&recordMgr->log) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+
+	freeZoneMap(recordMgr);
+	freeStatistics(recordMgr->statistics);
+	for (int i = 0; i < rel->schema->numAttr; i++) {
+		if (recordMgr->dictionaries[i] != NULL) {
+			freeDictionary(recordMgr->dictionaries[i]);
+		}
+	}
+	free(recordMgr->dictionaries);
+	free(recordMgr->storedOffsets);
+	if (freeSchema(rel->schema) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	free(recordMgr->pageHandle);
+	RC r = shutdownBufferPool(recordMgr->bufferPool);
+	free(recordMgr->bufferPool);
+	free(recordMgr);
+	rel->mgmtData = NULL;
+	return r;
+}
+
+RC deleteTable(char* name) {
+	printf("Deleting table\n");
+	// a table without dictionary encoded attributes (or never closed with values) has no dictionary file
+	char* fileName = dictionaryFileName(name);
+	destroyPageFile(fileName);
+	free(fileName);
+	// a table never opened has no log
+	fileName = logFileName(name);
+	destroyPageFile(fileName);
+	free(fileName);
+	return destroyPageFile(name);
+}
+
+/*
+ * Make the changes made to the table so far durable. Only the log is written: the pages stay in the buffer pool, after a
+ * crash their changes are redone from the log when the table is opened.
+ */
+RC commitTable(RM_TableData* rel) {
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+	return flushLog(&recordMgr->log, recordMgr->log.nextLSN);
+}
+
+/*
+ * Store the pages of a closed table compressed (see compressPageFile), for cold tables that are mostly scanned: reading a
+ * page then takes a fraction of a block. The pages written afterwards are compressed too.
+ */
+RC compressTable(char* name) {
+	return compressPageFile(name, BM_CODEC_LZ);
+}
+
+// page 0 is only updated when the table is closed, the count of the open table is the one of its record manager
+int getNumTuples(RM_TableData* rel) {
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+	return recordMgr->tuplesCount;
+}
+
+/*
+ * Pin a page with room for length bytes in pageHandle and mark it dirty, its number is put in *pageNum. It is a page
+ * the free space map says has room, or a new page added at the end of the table when no page has room.
+ */
+RC pinPageWithRoom(RM_RecordMgr* recordMgr, BM_PageHandle* pageHandle, int length, int* pageNum) {
+	bool newPage = false;
+	// the page of the previous insert is tried first: the map rounds the free space down and would skip its last bytes
+	int page = recordMgr->firstFreePage;
+	if (!isDataPage(recordMgr, page)) {
+		page = findPageWithRoom(recordMgr, page, length);
+	}
+	while (page != -1) {
+		if (pinPage(recordMgr->bufferPool, pageHandle, page) != RC_OK) {
+			return RC_WRITE_FAILED;
+		}
+		if (hasRoomFor(recordMgr, pageHandle->data, length)) {
+			break;
+		}
+		// no room in this page, its entry in the map is refreshed and the search goes on
+		setFreeSpace(recordMgr, page, freeSpaceCategory(recordMgr, pageHandle->data));
+		if (unpinPage(recordMgr->bufferPool, pageHandle) != RC_OK) {
+			return RC_WRITE_FAILED;
+		}
+		page = findPageWithRoom(recordMgr, page + 1, length);
+	}
+
+	if (page == -1) {
+		newPage = true;
+		page = recordMgr->numberOfPages + 1;
+		if (isFreeSpaceMapPage(page)) {
+			recordMgr->numberOfPages = page;
+			if (initFreeSpaceMapPage(recordMgr, page) != RC_OK) {
+				return RC_WRITE_FAILED;
+			}
+			page++;
+		}
+		if (pinPage(recordMgr->bufferPool, pageHandle, page) != RC_OK) {
+			return RC_WRITE_FAILED;
+		}
+		recordMgr->numberOfPages = page;
+	}
+	recordMgr->firstFreePage = page;
+
+	// marking the page dirty before writing it so optimistic readers know it is changing
+	if (markDirty(recordMgr->bufferPool, pageHandle) != RC_OK) {
+		unpinPage(recordMgr->bufferPool, pageHandle);
+		return RC_WRITE_FAILED;
+	}
+
+	if (newPage) {
+		logChange(recordMgr, WAL_NEW_PAGE, pageHandle->data, page, 0, NULL);
+		initDataPage(recordMgr, pageHandle->data);
+		startZone(recordMgr, page);
+	}
+	*pageNum = page;
+	return RC_OK;
+}
+
+/*
+ * The record goes in a page the free space map says has room for it, in a free slot of its directory found with the
+ * occupancy bitmap. A new page is added at the end of the table when no page has room.
+ */
+RC insertRecord(RM_TableData* rel, Record* record) {
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+	BM_PageHandle* pageHandle = recordMgr->pageHandle;
+	RC dictionaryRc = addDictionaryValues(recordMgr, record->data);
+	if (dictionaryRc != RC_OK) {
+		return dictionaryRc;
+	}
+	int length = storedRecordSize(recordMgr, record->data);
+	int page;
+	RC rc = pinPageWithRoom(recordMgr, pageHandle, length, &page);
+	if (rc != RC_OK) {
+		return rc;
+	}
+
+	logChange(recordMgr, WAL_INSERT, pageHandle->data, page, nextSlot(recordMgr, pageHandle->data), record->data);
+	int slot = reserveSlot(recordMgr, pageHandle->data, length);
+	writeSlot(recordMgr, pageHandle->data, slot, record->data);
+	addToZone(recordMgr, page, record->data, true);
+	setFreeSpace(recordMgr, page, freeSpaceCategory(recordMgr, pageHandle->data));
+
+	record->id.page = page;
+	record->id.slot = slot;
+
+	if (unpinPage(recordMgr->bufferPool, pageHandle) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	recordMgr->tuplesCount++;
+	return RC_OK;
+}
+
+/*
+ * Put records[next], records[next + 1], ... in the pinned page of the table manager while they fit. The page is marked
+ * dirty and its entry in the free space map written once. Returns the index of the first record left.
+ */
+int fillPage(RM_RecordMgr* recordMgr, Record** records, int* lengths, int n, int next) {
+	BM_PageHandle* pageHandle = recordMgr->pageHandle;
+	int page = pageHandle->pageNum;
+	if (next == n || !hasRoomFor(recordMgr, pageHandle->data, lengths[next])) {
+		return next;
+	}
+	if (markDirty(recordMgr->bufferPool, pageHandle) != RC_OK) {
+		return -1;
+	}
+	for (; next < n && hasRoomFor(recordMgr, pageHandle->data, lengths[next]); next++) {
+		logChange(recordMgr, WAL_INSERT, pageHandle->data, page, nextSlot(recordMgr, pageHandle->data),
+		          records[next]->data);
+		int slot = reserveSlot(recordMgr, pageHandle->data, lengths[next]);
+		writeSlot(recordMgr, pageHandle->data, slot, records[next]->data);
+		addToZone(recordMgr, page, records[next]->data, true);
+		records[next]->id.page = page;
+		records[next]->id.slot = slot;
+		recordMgr->tuplesCount++;
+	}
+	return next;
+}
+
+/*
+ * Insert n records, with the same placement as n calls to insertRecord but each page receiving records is pinned, marked
+ * dirty and updated in the free space map only once. The pages added at the end of the table are added to the file in
+ * one step.
+ */
+RC insertRecords(RM_TableData* rel, Record** records, int n) {
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+	BM_PageHandle* pageHandle = recordMgr->pageHandle;
+	for (int i = 0; i < n; i++) {
+		RC dictionaryRc = addDictionaryValues(recordMgr, records[i]->data);
+		if (dictionaryRc != RC_OK) {
+			return dictionaryRc;
+		}
+	}
+	int* lengths = (int*)malloc(sizeof(int) * n);
+	for (int i = 0; i < n; i++) {
+		lengths[i] = storedRecordSize(recordMgr, records[i]->data);
+	}
+	int next = 0;
+	RC rc = RC_OK;
+
+	// filling the pages of the table having room first
+	int page = recordMgr->firstFreePage;
+	if (n > 0 && !isDataPage(recordMgr, page)) {
+		page = findPageWithRoom(recordMgr, page, lengths[0]);
+	}
+	while (next < n && page != -1) {
+		if (pinPage(recordMgr->bufferPool, pageHandle, page) != RC_OK) {
+			rc = RC_WRITE_FAILED;
+			break;
+		}
+		next = fillPage(recordMgr, records, lengths, n, next);
+		setFreeSpace(recordMgr, page, freeSpaceCategory(recordMgr, pageHandle->data));
+		if (unpinPage(recordMgr->bufferPool, pageHandle) != RC_OK || next == -1) {
+			rc = RC_WRITE_FAILED;
+			break;
+		}
+		recordMgr->firstFreePage = page;
+		if (next < n) {
+			page = findPageWithRoom(recordMgr, page + 1, lengths[next]);
+		}
+	}
+
+	if (rc == RC_OK && next < n) {
+		// the pages needed by the rest of the records, counting a directory entry per record
+		long bytes = 0;
+		for (int i = next; i < n; i++) {
+			bytes += lengths[i] + sizeof(RM_SlotEntry);
+		}
+		int usableBytes = PAGE_SIZE - directoryOffset(recordMgr->slotsPerPage);
+		int newPages = (bytes + usableBytes - 1) / usableBytes;
+		int slotPages = (n - next + recordMgr->slotsPerPage - 1) / recordMgr->slotsPerPage;
+		if (slotPages > newPages) {
+			newPages = slotPages;
+		}
+		int lastPage = recordMgr->numberOfPages;
+		for (int i = 0; i < newPages; i++) {
+			lastPage++;
+			if (isFreeSpaceMapPage(lastPage)) {
+				lastPage++;
+			}
+		}
+		// more pages are added one at a time by pinPage if records are left because of the space lost in each page
+		if (ensurePoolCapacity(recordMgr->bufferPool, lastPage + 1) != RC_OK) {
+			rc = RC_WRITE_FAILED;
+		}
+	}
+
+	while (rc == RC_OK && next < n) {
+		page = recordMgr->numberOfPages + 1;
+		if (isFreeSpaceMapPage(page)) {
+			recordMgr->numberOfPages = page;
+			if (initFreeSpaceMapPage(recordMgr, page) != RC_OK) {
+				rc = RC_WRITE_FAILED;
+				break;
+			}
+			page++;
+		}
+		if (pinPage(recordMgr->bufferPool, pageHandle, page) != RC_OK) {
+			rc = RC_WRITE_FAILED;
+			break;
+		}
+		recordMgr->numberOfPages = page;
+		recordMgr->firstFreePage = page;
+		if (markDirty(recordMgr->bufferPool, pageHandle) != RC_OK) {
+			unpinPage(recordMgr->bufferPool, pageHandle);
+			rc = RC_WRITE_FAILED;
+			break;
+		}
+		logChange(recordMgr, WAL_NEW_PAGE, pageHandle->data, page, 0, NULL);
+		initDataPage(recordMgr, pageHandle->data);
+		startZone(recordMgr, page);
+		int filled = fillPage(recordMgr, records, lengths, n, next);
+		setFreeSpace(recordMgr, page, freeSpaceCategory(recordMgr, pageHandle->data));
+		if (unpinPage(recordMgr->bufferPool, pageHandle) != RC_OK || filled == -1 || filled == next) {
+			// a record not fitting in an empty page
+			rc = RC_WRITE_FAILED;
+			break;
+		}
+		next = filled;
+	}
+
+	free(lengths);
+	return rc;
+}
+
+// Free the slot of a moved record, a forward which lost its record keeps nothing to free
+RC freeMovedSlot(RM_RecordMgr* recordMgr, RID movedId) {
+	BM_PageHandle moved;
+	if (!isDataPage(recordMgr, movedId.page) || pinPage(recordMgr->bufferPool, &moved, movedId.page) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	if (slotState(recordMgr, moved.data, movedId.slot) != SLOT_MOVED_IN) {
+		return unpinPage(recordMgr->bufferPool, &moved);
+	}
+	if (markDirty(recordMgr->bufferPool, &moved) != RC_OK) {
+		unpinPage(recordMgr->bufferPool, &moved);
+		return RC_WRITE_FAILED;
+	}
+	logChange(recordMgr, WAL_MOVE_OUT, moved.data, movedId.page, movedId.slot, NULL);
+	setSlotFree(recordMgr, moved.data, movedId.slot);
+	removeFromZone(recordMgr, movedId.page);
+	setFreeSpace(recordMgr, movedId.page, freeSpaceCategory(recordMgr, moved.data));
+	if (movedId.page < recordMgr->firstFreePage) {
+		recordMgr->firstFreePage = movedId.page;
+	}
+	return unpinPage(recordMgr->bufferPool, &moved);
+}
+
+RC deleteRecord(RM_TableData* rel, RID id) {
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+	if (!isDataPage(recordMgr, id.page)) {
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+	if (pinPage(recordMgr->bufferPool, recordMgr->pageHandle, id.page) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+
+	// tuple is already deleted, or id is the slot of a moved record instead of its forward
+	RM_SlotState state = slotState(recordMgr, recordMgr->pageHandle->data, id.slot);
+	if (state != SLOT_RECORD && state != SLOT_FORWARD) {
+		unpinPage(recordMgr->bufferPool, recordMgr->pageHandle);
+		return RC_WRITE_FAILED;
+	}
+
+	if (markDirty(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
+		unpinPage(recordMgr->bufferPool, recordMgr->pageHandle);
+		return RC_WRITE_FAILED;
+	}
+	if (state == SLOT_FORWARD) {
+		// the record is removed from its new slot before its forward
+		if (freeMovedSlot(recordMgr, forwardTarget(recordMgr, recordMgr->pageHandle->data, id.slot)) != RC_OK) {
+			unpinPage(recordMgr->bufferPool, recordMgr->pageHandle);
+			return RC_WRITE_FAILED;
+		}
+	}
+	logChange(recordMgr, WAL_DELETE, recordMgr->pageHandle->data, id.page, id.slot, NULL);
+	setSlotFree(recordMgr, recordMgr->pageHandle->data, id.slot);
+	if (state == SLOT_RECORD) {
+		removeFromZone(recordMgr, id.page);
+	}
+	setFreeSpace(recordMgr, id.page, freeSpaceCategory(recordMgr, recordMgr->pageHandle->data));
+
+	if (unpinPage(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+
+	if (id.page < recordMgr->firstFreePage) {
+		recordMgr->firstFreePage = id.page;
+	}
+	recordMgr->tuplesCount--;
+	return RC_OK;
+}
 
-	recordMgr->tuplesCount = *(int*)recordMgr->pageHandle->data;
-	printf("there are %d tuples\n", recordMgr->tuplesCount);
-	recordMgr->pageHandle->data += sizeof(int);
+// put a record moved from the forward home in a free slot of the pinned page pageNum with room for it, returns the slot
+int insertMovedRecord(RM_RecordMgr* recordMgr, char* page, int pageNum, char* data, RID home) {
+	char* logged = (char*)malloc(recordMgr->recordSize + sizeof(RID));
+	memcpy(logged, data, recordMgr->recordSize);
+	memcpy(logged + recordMgr->recordSize, &home, sizeof(RID));
+	logChange(recordMgr, WAL_MOVE_IN, page, pageNum, nextSlot(recordMgr, page), logged);
+	free(logged);
+
+	int slot = reserveSlot(recordMgr, page, encodedRecordSize(recordMgr, data) + sizeof(RID));
+	writeMovedSlot(recordMgr, page, slot, data, home);
+	addToZone(recordMgr, pageNum, data, true);
+	return slot;
+}
 
-	rel->schema = (Schema*)malloc(sizeof(Schema));
+/*
+ * Move record out of the pinned page of its slot, which has no room left for it, to the first page with room. Its slot
+ * becomes a forward to its new slot. The zone and the map entry of the page of the slot are left to the caller.
+ */
+RC moveRecord(RM_RecordMgr* recordMgr, char* page, Record* record) {
+	int length = encodedRecordSize(recordMgr, record->data) + sizeof(RID);
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	// the page must keep room for the forward and the record must fit in an empty page
+	if (header->freeBytes + slotDirectory(recordMgr, page)[record->id.slot].length < (int)sizeof(RID)
+	    || length + (int)sizeof(RM_SlotEntry) > PAGE_SIZE - directoryOffset(recordMgr->slotsPerPage)) {
+		return RC_RM_NO_ROOM_FOR_RECORD;
+	}
 
+	// the page of the slot has no room for length bytes so it is never the one found
+	BM_PageHandle target;
+	int targetPage;
+	RC rc = pinPageWithRoom(recordMgr, &target, length, &targetPage);
+	if (rc != RC_OK) {
+		return rc;
+	}
+	RID movedId = {targetPage, insertMovedRecord(recordMgr, target.data, targetPage, record->data, record->id)};
+	setFreeSpace(recordMgr, targetPage, freeSpaceCategory(recordMgr, target.data));
 
-	fillSchemaFromLoadedPage(recordMgr->pageHandle, rel->schema);
+	logChange(recordMgr, WAL_FORWARD, page, record->id.page, record->id.slot, (char*)&movedId);
+	forwardSlot(recordMgr, page, record->id.slot, movedId);
+	return unpinPage(recordMgr->bufferPool, &target);
+}
 
-	recordMgr->recordSize = *(int*)recordMgr->pageHandle->data;
-	recordMgr->pageHandle->data += sizeof(int);
+/*
+ * Update a record that moved out of its page, whose forward is in the pinned page. The record stays in its slot if it
+ * fits there, else it goes back to the slot of its forward if its page has room again or it moves to another page.
+ */
+RC updateMovedRecord(RM_RecordMgr* recordMgr, char* page, Record* record) {
+	RID movedId = forwardTarget(recordMgr, page, record->id.slot);
+	BM_PageHandle moved;
+	if (!isDataPage(recordMgr, movedId.page) || pinPage(recordMgr->bufferPool, &moved, movedId.page) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	if (markDirty(recordMgr->bufferPool, &moved) != RC_OK) {
+		unpinPage(recordMgr->bufferPool, &moved);
+		return RC_WRITE_FAILED;
+	}
 
-	//     filling the queue of free slots
-	RID rid;
-	while (*recordMgr->pageHandle->data != '\0') {
-		rid.page = *(int*)recordMgr->pageHandle->data;
-		recordMgr->pageHandle->data += sizeof(int);
+	RC rc = RC_OK;
+	bool present = slotState(recordMgr, moved.data, movedId.slot) == SLOT_MOVED_IN;
+	if (present && fitsInSlot(recordMgr, moved.data, movedId.slot, record->data)) {
+		logChange(recordMgr, WAL_UPDATE, moved.data, movedId.page, movedId.slot, record->data);
+		updateSlot(recordMgr, moved.data, movedId.slot, record->data);
+		addToZone(recordMgr, movedId.page, record->data, false);
+	}
+	else {
+		if (fitsInSlot(recordMgr, page, record->id.slot, record->data)) {
+			logChange(recordMgr, WAL_UPDATE, page, record->id.page, record->id.slot, record->data);
+			updateSlot(recordMgr, page, record->id.slot, record->data);
+			addToZone(recordMgr, record->id.page, record->data, true);
+		}
+		else {
+			rc = moveRecord(recordMgr, page, record);
+		}
+		// the old slot is freed once the record is in its new one
+		if (rc == RC_OK && present) {
+			logChange(recordMgr, WAL_MOVE_OUT, moved.data, movedId.page, movedId.slot, NULL);
+			setSlotFree(recordMgr, moved.data, movedId.slot);
+			removeFromZone(recordMgr, movedId.page);
+			if (movedId.page < recordMgr->firstFreePage) {
+				recordMgr->firstFreePage = movedId.page;
+			}
+		}
+	}
+	setFreeSpace(recordMgr, movedId.page, freeSpaceCategory(recordMgr, moved.data));
+	if (unpinPage(recordMgr->bufferPool, &moved) != RC_OK && rc == RC_OK) {
+		rc = RC_WRITE_FAILED;
+	}
+	return rc;
+}
 
-		rid.slot = *(int*)recordMgr->pageHandle->data;
-		recordMgr->pageHandle->data += sizeof(int);
+/*
+ * A record growing out of its page moves to the first page with room for it, its slot becoming a forward so the record
+ * keeps its RID. A scan open during the update may return a moving record twice or not at all.
+ * RC_RM_NO_ROOM_FOR_RECORD is returned, leaving the record unchanged, when it fits in no page.
+ */
+RC updateRecord(RM_TableData* rel, Record* record) {
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+	int page = record->id.page;
+	int slot = record->id.slot;
+	if (!isDataPage(recordMgr, page)) {
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+	RC dictionaryRc = addDictionaryValues(recordMgr, record->data);
+	if (dictionaryRc != RC_OK) {
+		return dictionaryRc;
+	}
+
+	if (pinPage(recordMgr->bufferPool, recordMgr->pageHandle, page) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
 
-		insertInFreeQueue(recordMgr->freeRecordsQueue, rid);
+	// tuple is deleted, or the id is the slot of a moved record instead of its forward
+	RM_SlotState state = slotState(recordMgr, recordMgr->pageHandle->data, slot);
+	if (state != SLOT_RECORD && state != SLOT_FORWARD) {
+		unpinPage(recordMgr->bufferPool, recordMgr->pageHandle);
+		return RC_WRITE_FAILED;
 	}
 
-	rel->mgmtData = recordMgr;
+	if (markDirty(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
+		unpinPage(recordMgr->bufferPool, recordMgr->pageHandle);
+		return RC_WRITE_FAILED;
+	}
+
+	char* data = recordMgr->pageHandle->data;
+	RC rc = RC_OK;
+	if (state == SLOT_FORWARD) {
+		rc = updateMovedRecord(recordMgr, data, record);
+	}
+	else if (fitsInSlot(recordMgr, data, slot, record->data)) {
+		logChange(recordMgr, WAL_UPDATE, data, page, slot, record->data);
+		updateSlot(recordMgr, data, slot, record->data);
+		addToZone(recordMgr, page, record->data, false);
+	}
+	else {
+		rc = moveRecord(recordMgr, data, record);
+		if (rc == RC_OK) {
+			removeFromZone(recordMgr, page);
+			if (page < recordMgr->firstFreePage) {
+				recordMgr->firstFreePage = page;
+			}
+		}
+	}
+	if (recordMgr->format != RM_FORMAT_PAX) {
+		setFreeSpace(recordMgr, page, freeSpaceCategory(recordMgr, data));
+	}
+
+	if (unpinPage(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+
+	return rc;
+}
 
+/*
+ * Pin the page holding the record id in pageHandle through strategy and put the slot of the record in it in *slot: the
+ * slot of id, or the one its forward gives if the record moved. *slot is -1 if there is no record, the page is pinned
+ * anyway when RC_OK is returned.
+ */
+RC pinRecordPage(RM_RecordMgr* tableMgr, BM_PageHandle* pageHandle, RID id, BM_AccessStrategy* strategy, int* slot) {
+	if (pinPageWithStrategy(tableMgr->bufferPool, pageHandle, id.page, strategy) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	RM_SlotState state = slotState(tableMgr, pageHandle->data, id.slot);
+	*slot = id.slot;
+	if (state == SLOT_FORWARD) {
+		RID movedId = forwardTarget(tableMgr, pageHandle->data, id.slot);
+		if (unpinPage(tableMgr->bufferPool, pageHandle) != RC_OK || !isDataPage(tableMgr, movedId.page)
+		    || pinPageWithStrategy(tableMgr->bufferPool, pageHandle, movedId.page, strategy) != RC_OK) {
+			return RC_WRITE_FAILED;
+		}
+		*slot = movedId.slot;
+		state = slotState(tableMgr, pageHandle->data, movedId.slot) == SLOT_MOVED_IN ? SLOT_RECORD : SLOT_FREE;
+	}
+	// a moved record is only found through its forward
+	if (state != SLOT_RECORD) {
+		*slot = -1;
+	}
 	return RC_OK;
+}
 
+// bytes the record of a used slot takes in its page
+int slotLength(RM_RecordMgr* tableMgr, char* page, int slot) {
+	if (tableMgr->format == RM_FORMAT_PAX) {
+		return tableMgr->storedOffsets[tableMgr->schema->numAttr];
+	}
+	return slotDirectory(tableMgr, page)[slot].length;
 }
 
-RC closeTable(RM_TableData* rel) {
-	printf("Closing table\n");
-	recordMgr = rel->mgmtData;
+// last data page holding a record, 0 if the table is empty
+int lastUsedPage(RM_RecordMgr* tableMgr, int page) {
+	for (; page >= 1; page--) {
+		if (isFreeSpaceMapPage(page)) {
+			continue;
+		}
+		BM_PageHandle pageHandle;
+		if (pinPage(tableMgr->bufferPool, &pageHandle, page) != RC_OK) {
+			return -1;
+		}
+		int numberOfRecords = ((RM_PageHeader*)pageHandle.data)->numberOfRecords;
+		unpinPage(tableMgr->bufferPool, &pageHandle);
+		if (numberOfRecords > 0) {
+			return page;
+		}
+	}
+	return 0;
+}
 
-	if (pinPage(recordMgr->bufferPool, recordMgr->pageHandle, 0) != RC_OK) {
+// Put a moved record of the forward home in the pinned target page of a vacuum and point the forward to it
+RC vacuumMovedRecord(RM_RecordMgr* recordMgr, char* data, RID home, BM_PageHandle* target, int targetPage) {
+	BM_PageHandle forward;
+	if (pinPage(recordMgr->bufferPool, &forward, home.page) != RC_OK) {
 		return RC_WRITE_FAILED;
 	}
-	printMetaData(recordMgr->pageHandle->data);
-	finalFillPageHandle(recordMgr->pageHandle, rel);
-	if (markDirty(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
+	if (markDirty(recordMgr->bufferPool, &forward) != RC_OK) {
+		unpinPage(recordMgr->bufferPool, &forward);
+		return RC_WRITE_FAILED;
+	}
+	RID movedId = {targetPage, insertMovedRecord(recordMgr, target->data, targetPage, data, home)};
+	logChange(recordMgr, WAL_FORWARD, forward.data, home.page, home.slot, (char*)&movedId);
+	forwardSlot(recordMgr, forward.data, home.slot, movedId);
+	return unpinPage(recordMgr->bufferPool, &forward);
+}
+
+/*
+ * Move the records of the last pages of the table to the free space of the first ones, then cut the empty pages at the
+ * end of the file. The records are taken from the last page backwards and put in the first page with room found in the
+ * free space map, until no page before the one being emptied has room. The moves are returned in *moves (allocated,
+ * freed by the caller, in the order they were done) so indexes can update their RIDs, moves can be NULL. A record that
+ * moved out of its page keeps its RID: its forward stays in place and gets its new slot.
+ * No scan or borrowed record of the table may be open during the vacuum.
+ */
+RC vacuumTable(RM_TableData* rel, RM_RecordMove** moves, int* numberOfMoves) {
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+	BM_PageHandle source, target;
+	bool targetPinned = false;
+	int targetPage = 1;
+	int capacity = 0;
+	RM_RecordMove* done = NULL;
+	int count = 0;
+	RC rc = RC_OK;
+	Record* record;
+	createRecord(&record, rel->schema);
+
+	int sourcePage = lastUsedPage(recordMgr, recordMgr->numberOfPages);
+	bool full = sourcePage <= 0;
+	while (!full && rc == RC_OK) {
+		if (pinPage(recordMgr->bufferPool, &source, sourcePage) != RC_OK) {
+			rc = RC_WRITE_FAILED;
+			break;
+		}
+		if (markDirty(recordMgr->bufferPool, &source) != RC_OK) {
+			unpinPage(recordMgr->bufferPool, &source);
+			rc = RC_WRITE_FAILED;
+			break;
+		}
+		char* page = source.data;
+		int numberOfSlots = ((RM_PageHeader*)page)->numberOfSlots;
+		for (int slot = findUsedSlot(page, 0); slot != -1 && slot < numberOfSlots && rc == RC_OK;
+		     slot = findUsedSlot(page, slot + 1)) {
+			int length = slotLength(recordMgr, page, slot);
+			// the pinned target page is used while it has room, the map is searched for the next one
+			while (!targetPinned || !hasRoomFor(recordMgr, target.data, length)) {
+				if (targetPinned) {
+					setFreeSpace(recordMgr, targetPage, freeSpaceCategory(recordMgr, target.data));
+					unpinPage(recordMgr->bufferPool, &target);
+					targetPinned = false;
+					targetPage++;
+				}
+				targetPage = findPageWithRoom(recordMgr, targetPage, length);
+				if (targetPage == -1 || targetPage >= sourcePage) {
+					full = true;
+					break;
+				}
+				if (pinPage(recordMgr->bufferPool, &target, targetPage) != RC_OK) {
+					rc = RC_WRITE_FAILED;
+					break;
+				}
+				targetPinned = true;
+				if (markDirty(recordMgr->bufferPool, &target) != RC_OK) {
+					rc = RC_WRITE_FAILED;
+					break;
+				}
+			}
+			if (full || rc != RC_OK) {
+				break;
+			}
+
+			readSlot(recordMgr, page, slot, record->data, NULL);
+			if (slotState(recordMgr, page, slot) == SLOT_MOVED_IN) {
+				// a moved record keeps its RID, its forward is changed to its new slot
+				rc = vacuumMovedRecord(recordMgr, record->data, recordId(recordMgr, page, sourcePage, slot), &target,
+				                       targetPage);
+				if (rc != RC_OK) {
+					break;
+				}
+				logChange(recordMgr, WAL_MOVE_OUT, page, sourcePage, slot, NULL);
+				setSlotFree(recordMgr, page, slot);
+				removeFromZone(recordMgr, sourcePage);
+				continue;
+			}
+			logChange(recordMgr, WAL_INSERT, target.data, targetPage, nextSlot(recordMgr, target.data), record->data);
+			int newSlot = reserveSlot(recordMgr, target.data, length);
+			writeSlot(recordMgr, target.data, newSlot, record->data);
+			addToZone(recordMgr, targetPage, record->data, true);
+			logChange(recordMgr, WAL_DELETE, page, sourcePage, slot, NULL);
+			setSlotFree(recordMgr, page, slot);
+			removeFromZone(recordMgr, sourcePage);
+
+			if (count == capacity) {
+				capacity = capacity == 0 ? recordMgr->slotsPerPage : capacity * 2;
+				done = (RM_RecordMove*)realloc(done, sizeof(RM_RecordMove) * capacity);
+			}
+			done[count].from.page = sourcePage;
+			done[count].from.slot = slot;
+			done[count].to.page = targetPage;
+			done[count].to.slot = newSlot;
+			count++;
+		}
+		setFreeSpace(recordMgr, sourcePage, freeSpaceCategory(recordMgr, page));
+		unpinPage(recordMgr->bufferPool, &source);
+
+		// the next page to empty, skipping the map pages
+		do {
+			sourcePage--;
+		} while (sourcePage >= 1 && isFreeSpaceMapPage(sourcePage));
+		if (sourcePage <= targetPage) {
+			full = true;
+		}
+	}
+	if (targetPinned) {
+		setFreeSpace(recordMgr, targetPage, freeSpaceCategory(recordMgr, target.data));
+		unpinPage(recordMgr->bufferPool, &target);
+	}
+	freeRecord(record);
+
+	// the empty pages at the end of the table leave the file
+	int lastPage = rc == RC_OK ? lastUsedPage(recordMgr, recordMgr->numberOfPages) : -1;
+	if (lastPage == -1) {
+		rc = RC_WRITE_FAILED;
+	}
+	else if (lastPage < recordMgr->numberOfPages) {
+		// checkpointed first, so recovery never redoes the changes logged for the pages leaving the file
+		recordMgr->numberOfPages = lastPage;
+		if (checkpointTable(rel) != RC_OK || truncatePool(recordMgr->bufferPool, lastPage + 1) != RC_OK) {
+			rc = RC_WRITE_FAILED;
+		}
+	}
+	recordMgr->firstFreePage = 1;
+
+	if (moves != NULL) {
+		*moves = done;
+	}
+	else {
+		free(done);
+	}
+	if (numberOfMoves != NULL) {
+		*numberOfMoves = count;
+	}
+	return rc;
+}
+
+/*
+ * Read the record id into record, pinning its page through strategy.
+ * strategy can be NULL to use the buffer pool replacement strategy.
+ */
+RC readRecord(RM_TableData* rel, RID id, Record* record, BM_AccessStrategy* strategy) {
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+	if (!isDataPage(recordMgr, id.page)) {
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+
+	int slot;
+	if (pinRecordPage(recordMgr, recordMgr->pageHandle, id, strategy, &slot) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+
+	bool used = slot != -1;
+	if (used) {
+		readSlot(recordMgr, recordMgr->pageHandle->data, slot, record->data, NULL);
+		record->id = id;
+	}
+
+	if (unpinPage(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+
+	// tuple is deleted
+	if (!used) {
+		return RC_WRITE_FAILED;
+	}
+	return RC_OK;
+}
+
+/*
+ * Point lookups read the page optimistically: no pin, the frame version is checked after copying the page and the
+ * read is retried if the page changed meanwhile. Only a validated copy is decoded, the slot directory of a torn page
+ * could point anywhere. After OPTIMISTIC_READ_RETRIES failures the page is pinned.
+ */
+RC getRecord(RM_TableData* rel, RID id, Record* record) {
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+	BM_PageHandle page;
+	unsigned long version;
+	char copy[PAGE_SIZE];
+
+	if (!isDataPage(recordMgr, id.page)) {
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+
+	for (int attempt = 0; attempt < OPTIMISTIC_READ_RETRIES; attempt++) {
+		if (readPageOptimistic(recordMgr->bufferPool, &page, id.page, &version) != RC_OK) {
+			break;
+		}
+		memcpy(copy, page.data, PAGE_SIZE);
+		if (!validatePageRead(recordMgr->bufferPool, &page, version)) {
+			continue;
+		}
+		RM_SlotState state = slotState(recordMgr, copy, id.slot);
+		// the record moved out of its page, it is read with the pages pinned
+		if (state == SLOT_FORWARD) {
+			break;
+		}
+		// tuple is deleted
+		if (state != SLOT_RECORD) {
+			return RC_WRITE_FAILED;
+		}
+		readSlot(recordMgr, copy, id.slot, record->data, NULL);
+		record->id = id;
+		return RC_OK;
+	}
+	return readRecord(rel, id, record, NULL);
+}
+
+// point a borrowed record to its slot in the pinned page
+void setBorrowedData(RM_RecordMgr* tableMgr, char* page, int slot, RM_BorrowedRecord* record) {
+	record->tableMgmtData = tableMgr;
+	if (tableMgr->format == RM_FORMAT_PAX) {
+		record->data = page;
+		record->length = tableMgr->storedOffsets[tableMgr->schema->numAttr];
+		return;
+	}
+	RM_SlotEntry entry = slotDirectory(tableMgr, page)[slot];
+	record->data = page + entry.offset;
+	record->length = entry.length - (entry.movedIn ? sizeof(RID) : 0);
+}
+
+/*
+ * Give access to the record id without copying it: its page stays pinned until releaseBorrowedRecord is called and the
+ * attributes are read in the page with the getBorrowed functions.
+ */
+RC borrowRecord(RM_TableData* rel, RID id, RM_BorrowedRecord* record) {
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+	if (!isDataPage(recordMgr, id.page)) {
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+
+	BM_PageHandle* pageHandle = MAKE_PAGE_HANDLE();
+	int slot;
+	if (pinRecordPage(recordMgr, pageHandle, id, NULL, &slot) != RC_OK) {
+		free(pageHandle);
+		return RC_WRITE_FAILED;
+	}
+
+	// tuple is deleted
+	if (slot == -1) {
+		unpinPage(recordMgr->bufferPool, pageHandle);
+		free(pageHandle);
 		return RC_WRITE_FAILED;
 	}
-	if (unpinPage(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
-		return RC_WRITE_FAILED;
+
+	record->id = id;
+	setBorrowedData(recordMgr, pageHandle->data, slot, record);
+	record->schema = rel->schema;
+
+	RM_BorrowedPin* pin = (RM_BorrowedPin*)malloc(sizeof(RM_BorrowedPin));
+	pin->bufferPool = recordMgr->bufferPool;
+	pin->pageHandle = pageHandle;
+	record->mgmtData = pin;
+	return RC_OK;
+}
+
+RC releaseBorrowedRecord(RM_BorrowedRecord* record) {
+	RM_BorrowedPin* pin = (RM_BorrowedPin*)record->mgmtData;
+	// records borrowed from a scan are released by the scan
+	if (pin == NULL) {
+		return RC_OK;
+	}
+	RC r = unpinPage(pin->bufferPool, pin->pageHandle);
+	free(pin->pageHandle);
+	free(pin);
+	record->mgmtData = NULL;
+	record->data = NULL;
+	return r;
+}
+
+RC createRecord(Record** record, Schema* schema) {
+	*record = (Record*)malloc(sizeof(Record));
+
+	int recordSize = getRecordSize(schema);
+
+	(*record)->data = (char*)malloc(recordSize);
+	(*record)->id.page = 0;
+	(*record)->id.slot = 0;
+
+	return RC_OK;
+
+}
+
+RC freeRecord(Record* record) {
+	free(record->data);
+	free(record);
+	return RC_OK;
+}
+
+RC compileOperand(Expr* expr, Schema* schema, RM_Predicate* predicate, RM_Operand* operand, DataType* dataType) {
+	if (expr->type == EXPR_ATTRREF) {
+		int attrNum = expr->expr.attrRef;
+		if (attrNum < 0 || attrNum >= schema->numAttr) {
+			return RC_RM_UNKOWN_DATATYPE;
+		}
+		if (predicate->columnOfAttr[attrNum] == -1) {
+			predicate->columnOfAttr[attrNum] = predicate->numberOfColumns++;
+		}
+		if (attrNum > predicate->lastAttr) {
+			predicate->lastAttr = attrNum;
+		}
+		operand->isAttribute = true;
+		operand->column = predicate->columnOfAttr[attrNum];
+		operand->length = 0;
+		operand->constant = NULL;
+		*dataType = schema->dataTypes[attrNum];
+		return RC_OK;
+	}
+	if (expr->type == EXPR_CONST) {
+		operand->isAttribute = false;
+		operand->column = -1;
+		operand->constant = expr->expr.cons;
+		*dataType = expr->expr.cons->dt;
+		operand->length = *dataType == DT_STRING ? strlen(expr->expr.cons->v.stringV) : 0;
+		operand->code = -1;
+		return RC_OK;
+	}
+	// comparing the results of operators is left to evalExpr
+	return RC_RM_UNKOWN_DATATYPE;
+}
+
+void addPredicateStep(RM_Predicate* predicate, RM_PredicateStep* step) {
+	predicate->steps = realloc(predicate->steps, sizeof(RM_PredicateStep) * (predicate->numberOfSteps + 1));
+	predicate->steps[predicate->numberOfSteps] = *step;
+	predicate->numberOfSteps++;
+}
+
+/*
+ * Append the steps of expr to predicate. depth is the number of bitmaps on the stack when expr is evaluated.
+ */
+RC compileExpr(Expr* expr, Schema* schema, RM_Predicate* predicate, int depth) {
+	RM_PredicateStep step;
+	RC rc;
+	if (depth >= PREDICATE_MAX_DEPTH) {
+		return RC_RM_UNKOWN_DATATYPE;
+	}
+
+	step.compareCodes = false;
+	if (expr->type != EXPR_OP) {
+		step.op = PRED_VALUE;
+		if (compileOperand(expr, schema, predicate, &step.left, &step.dataType) != RC_OK || step.dataType != DT_BOOL) {
+			return RC_RM_BOOLEAN_EXPR_ARG_IS_NOT_BOOLEAN;
+		}
+		addPredicateStep(predicate, &step);
+		return RC_OK;
+	}
+
+	Operator* op = expr->expr.op;
+	switch (op->type) {
+	case OP_BOOL_NOT:
+		rc = compileExpr(op->args[0], schema, predicate, depth);
+		if (rc != RC_OK) {
+			return rc;
+		}
+		step.op = PRED_NOT;
+		break;
+	case OP_BOOL_AND:
+	case OP_BOOL_OR:
+		rc = compileExpr(op->args[0], schema, predicate, depth);
+		if (rc != RC_OK) {
+			return rc;
+		}
+		rc = compileExpr(op->args[1], schema, predicate, depth + 1);
+		if (rc != RC_OK) {
+			return rc;
+		}
+		step.op = op->type == OP_BOOL_AND ? PRED_AND : PRED_OR;
+		break;
+	case OP_COMP_EQUAL:
+	case OP_COMP_SMALLER: {
+		DataType rightType;
+		step.op = PRED_COMPARE;
+		step.comparison = op->type;
+		rc = compileOperand(op->args[0], schema, predicate, &step.left, &step.dataType);
+		if (rc != RC_OK) {
+			return rc;
+		}
+		rc = compileOperand(op->args[1], schema, predicate, &step.right, &rightType);
+		if (rc != RC_OK) {
+			return rc;
+		}
+		if (step.dataType != rightType) {
+			return RC_RM_COMPARE_VALUE_OF_DIFFERENT_DATATYPE;
+		}
+		// an encoded attribute equal to a constant: the code of the constant is compared with the codes of the records
+		step.compareCodes = false;
+		if (step.comparison == OP_COMP_EQUAL && step.left.isAttribute != step.right.isAttribute) {
+			RM_Operand* constant = step.left.isAttribute ? &step.right : &step.left;
+			Expr* attributeExpr = step.left.isAttribute ? op->args[0] : op->args[1];
+			RM_Dictionary* dictionary = predicate->dictionaries[attributeExpr->expr.attrRef];
+			if (dictionary != NULL) {
+				step.compareCodes = true;
+				constant->code = dictionaryCode(dictionary, constant->constant->v.stringV, constant->length);
+			}
+		}
+		break;
+	}
+	}
+	addPredicateStep(predicate, &step);
+	return RC_OK;
+}
+
+void freePredicate(RM_Predicate* predicate) {
+	// the columns are only allocated once the whole condition compiled
+	for (int i = 0; predicate->columns != NULL && i < predicate->numberOfColumns; i++) {
+		RM_Column* column = &predicate->columns[i];
+		free(column->ints);
+		free(column->floats);
+		free(column->bools);
+		free(column->strings);
+		free(column->lengths);
+		free(column->codes);
+	}
+	free(predicate->columns);
+	free(predicate->columnOfAttr);
+	free(predicate->steps);
+	free(predicate->stack);
+	free(predicate->selection);
+	free(predicate);
+}
+
+/*
+ * Compile a scan condition for the pages of a table, NULL if it cannot be compiled (the scan then uses evalExpr).
+ */
+RM_Predicate* compilePredicate(Expr* cond, RM_RecordMgr* tableMgr) {
+	Schema* schema = tableMgr->schema;
+	int numberOfSlots = tableMgr->slotsPerPage;
+	RM_Predicate* predicate = (RM_Predicate*)calloc(1, sizeof(RM_Predicate));
+	predicate->dictionaries = tableMgr->dictionaries;
+	predicate->columnOfAttr = (int*)malloc(sizeof(int) * schema->numAttr);
+	for (int i = 0; i < schema->numAttr; i++) {
+		predicate->columnOfAttr[i] = -1;
+	}
+	predicate->lastAttr = -1;
+	if (compileExpr(cond, schema, predicate, 0) != RC_OK) {
+		freePredicate(predicate);
+		return NULL;
+	}
+
+	predicate->numberOfSlots = numberOfSlots;
+	predicate->columns = (RM_Column*)calloc(predicate->numberOfColumns, sizeof(RM_Column));
+	for (int attr = 0; attr < schema->numAttr; attr++) {
+		if (predicate->columnOfAttr[attr] == -1) {
+			continue;
+		}
+		RM_Column* column = &predicate->columns[predicate->columnOfAttr[attr]];
+		column->attrNum = attr;
+		column->dataType = schema->dataTypes[attr];
+		switch (column->dataType) {
+		case DT_INT:
+			column->ints = (int*)malloc(sizeof(int) * numberOfSlots);
+			break;
+		case DT_FLOAT:
+			column->floats = (float*)malloc(sizeof(float) * numberOfSlots);
+			break;
+		case DT_BOOL:
+			column->bools = (bool*)malloc(sizeof(bool) * numberOfSlots);
+			break;
+		case DT_STRING:
+			column->strings = (char**)malloc(sizeof(char*) * numberOfSlots);
+			column->lengths = (int*)malloc(sizeof(int) * numberOfSlots);
+			if (isDictionaryEncoded(tableMgr, attr)) {
+				column->codes = (int*)malloc(sizeof(int) * numberOfSlots);
+			}
+			break;
+		}
+	}
+	predicate->stack = (uint64_t*)malloc(sizeof(uint64_t) * bitmapWords(numberOfSlots) * PREDICATE_MAX_DEPTH);
+	predicate->selection = (uint64_t*)malloc(sizeof(uint64_t) * bitmapWords(numberOfSlots));
+	return predicate;
+}
+
+/*
+ * PAX pages already hold the values of an attribute together: a column is loaded with a single copy of its minipage.
+ * Free slots keep the values of their last record, they are removed from the selection with the occupancy bitmap.
+ */
+void loadPaxColumns(RM_Predicate* predicate, RM_RecordMgr* tableMgr, char* page) {
+	int numberOfSlots = ((RM_PageHeader*)page)->numberOfSlots;
+	for (int i = 0; i < predicate->numberOfColumns; i++) {
+		RM_Column* column = &predicate->columns[i];
+		char* minipage = paxValue(tableMgr, page, column->attrNum, 0);
+		switch (column->dataType) {
+		case DT_INT:
+			memcpy(column->ints, minipage, sizeof(int) * numberOfSlots);
+			break;
+		case DT_FLOAT:
+			memcpy(column->floats, minipage, sizeof(float) * numberOfSlots);
+			break;
+		case DT_BOOL:
+			memcpy(column->bools, minipage, sizeof(bool) * numberOfSlots);
+			break;
+		case DT_STRING: {
+			if (column->codes != NULL) {
+				RM_Dictionary* dictionary = tableMgr->dictionaries[column->attrNum];
+				for (int slot = 0; slot < numberOfSlots; slot++) {
+					uint16_t code;
+					memcpy(&code, minipage + slot * sizeof(uint16_t), sizeof(uint16_t));
+					column->codes[slot] = code;
+					column->strings[slot] = dictionaryString(dictionary, code, &column->lengths[slot]);
+				}
+				break;
+			}
+			int typeLength = tableMgr->schema->typeLength[column->attrNum];
+			for (int slot = 0; slot < numberOfSlots; slot++) {
+				column->strings[slot] = minipage + slot * typeLength;
+				column->lengths[slot] = strnlen(column->strings[slot], typeLength);
+			}
+			break;
+		}
+		}
+	}
+}
+
+/*
+ * Load the attributes used by the condition of every slot of the page in the columns. Free slots get zeros and empty
+ * strings so the comparisons can run over all the slots without checking the occupancy bitmap.
+ */
+void loadColumns(RM_Predicate* predicate, RM_RecordMgr* tableMgr, char* page) {
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	if (tableMgr->format == RM_FORMAT_PAX) {
+		loadPaxColumns(predicate, tableMgr, page);
+		return;
 	}
-	if (forceFlushPool(recordMgr->bufferPool) != RC_OK) {
-		return RC_WRITE_FAILED;
+	RM_SlotEntry* directory = slotDirectory(tableMgr, page);
+	Schema* schema = tableMgr->schema;
+
+	for (int slot = 0; slot < header->numberOfSlots; slot++) {
+		bool used = isSlotUsed(page, slot);
+		char* attrData = page + directory[slot].offset;
+		for (int attr = 0; attr <= predicate->lastAttr; attr++) {
+			int columnNumber = predicate->columnOfAttr[attr];
+			int size = attributeSize(schema, attr);
+			if (isDictionaryEncoded(tableMgr, attr)) {
+				uint16_t code = 0;
+				if (used) {
+					memcpy(&code, attrData, sizeof(uint16_t));
+				}
+				if (columnNumber != -1) {
+					RM_Column* column = &predicate->columns[columnNumber];
+					column->codes[slot] = used ? code : -1;
+					column->strings[slot] = used ? dictionaryString(tableMgr->dictionaries[attr], code, &column->lengths[slot])
+					                             : "";
+					if (!used) {
+						column->lengths[slot] = 0;
+					}
+				}
+				attrData += sizeof(uint16_t);
+				continue;
+			}
+			if (schema->dataTypes[attr] == DT_STRING) {
+				uint16_t length = 0;
+				if (used) {
+					memcpy(&length, attrData, sizeof(uint16_t));
+				}
+				if (columnNumber != -1) {
+					predicate->columns[columnNumber].strings[slot] = used ? attrData + sizeof(uint16_t) : "";
+					predicate->columns[columnNumber].lengths[slot] = length;
+				}
+				attrData += sizeof(uint16_t) + length;
+				continue;
+			}
+			if (columnNumber != -1) {
+				RM_Column* column = &predicate->columns[columnNumber];
+				void* value = column->dataType == DT_INT ? (void*)&column->ints[slot]
+				            : column->dataType == DT_FLOAT ? (void*)&column->floats[slot] : (void*)&column->bools[slot];
+				if (used) {
+					memcpy(value, attrData, size);
+				}
+				else {
+					memset(value, 0, size);
+				}
+			}
+			attrData += size;
+		}
 	}
+}
 
-	freeRecordsQueue(recordMgr->freeRecordsQueue);
-	if (freeSchema(rel->schema) != RC_OK) {
-		return RC_WRITE_FAILED;
+// strings compare as strcmp does
+int compareStrings(char* left, int leftLength, char* right, int rightLength) {
+	int cmp = memcmp(left, right, leftLength < rightLength ? leftLength : rightLength);
+	if (cmp != 0) {
+		return cmp;
 	}
-	free(recordMgr->pageHandle);
-	RC r = shutdownBufferPool(recordMgr->bufferPool);
-	free(recordMgr->bufferPool);
-	return r;
+	return leftLength - rightLength;
 }
 
-RC deleteTable(char* name) {
-	printf("Deleting table\n");
-	return destroyPageFile(name);
+/*
+ * Set in result the bits of the slots for which the comparison is true. Ints and floats are compared 4 slots at a time
+ * with SSE2 when it is available.
+ */
+void compareInts(RM_Predicate* predicate, RM_PredicateStep* step, int numberOfSlots, uint64_t* result) {
+	int* left = step->left.isAttribute ? predicate->columns[step->left.column].ints : NULL;
+	int* right = step->right.isAttribute ? predicate->columns[step->right.column].ints : NULL;
+	int leftConstant = left == NULL ? step->left.constant->v.intV : 0;
+	int rightConstant = right == NULL ? step->right.constant->v.intV : 0;
+	bool equal = step->comparison == OP_COMP_EQUAL;
+	int slot = 0;
+#ifdef __SSE2__
+	__m128i leftConstants = _mm_set1_epi32(leftConstant);
+	__m128i rightConstants = _mm_set1_epi32(rightConstant);
+	for (; slot + 4 <= numberOfSlots; slot += 4) {
+		__m128i l = left != NULL ? _mm_loadu_si128((__m128i*)(left + slot)) : leftConstants;
+		__m128i r = right != NULL ? _mm_loadu_si128((__m128i*)(right + slot)) : rightConstants;
+		__m128i matches = equal ? _mm_cmpeq_epi32(l, r) : _mm_cmplt_epi32(l, r);
+		uint64_t bits = _mm_movemask_ps(_mm_castsi128_ps(matches));
+		result[slot / SLOTS_PER_BITMAP_WORD] |= bits << (slot % SLOTS_PER_BITMAP_WORD);
+	}
+#endif
+	for (; slot < numberOfSlots; slot++) {
+		int l = left != NULL ? left[slot] : leftConstant;
+		int r = right != NULL ? right[slot] : rightConstant;
+		result[slot / SLOTS_PER_BITMAP_WORD] |= (uint64_t)(equal ? l == r : l < r) << (slot % SLOTS_PER_BITMAP_WORD);
+	}
 }
 
-int getNumTuples(RM_TableData* rel) {
-	recordMgr = rel->mgmtData;
-	if (pinPage(recordMgr->bufferPool, recordMgr->pageHandle, 0) != RC_OK) {
-		return RC_WRITE_FAILED;
+void compareFloats(RM_Predicate* predicate, RM_PredicateStep* step, int numberOfSlots, uint64_t* result) {
+	float* left = step->left.isAttribute ? predicate->columns[step->left.column].floats : NULL;
+	float* right = step->right.isAttribute ? predicate->columns[step->right.column].floats : NULL;
+	float leftConstant = left == NULL ? step->left.constant->v.floatV : 0;
+	float rightConstant = right == NULL ? step->right.constant->v.floatV : 0;
+	bool equal = step->comparison == OP_COMP_EQUAL;
+	int slot = 0;
+#ifdef __SSE2__
+	__m128 leftConstants = _mm_set1_ps(leftConstant);
+	__m128 rightConstants = _mm_set1_ps(rightConstant);
+	for (; slot + 4 <= numberOfSlots; slot += 4) {
+		__m128 l = left != NULL ? _mm_loadu_ps(left + slot) : leftConstants;
+		__m128 r = right != NULL ? _mm_loadu_ps(right + slot) : rightConstants;
+		__m128 matches = equal ? _mm_cmpeq_ps(l, r) : _mm_cmplt_ps(l, r);
+		uint64_t bits = _mm_movemask_ps(matches);
+		result[slot / SLOTS_PER_BITMAP_WORD] |= bits << (slot % SLOTS_PER_BITMAP_WORD);
 	}
-	int num = *(int*)recordMgr->pageHandle->data;
-	if (unpinPage(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
-		return RC_WRITE_FAILED;
+#endif
+	for (; slot < numberOfSlots; slot++) {
+		float l = left != NULL ? left[slot] : leftConstant;
+		float r = right != NULL ? right[slot] : rightConstant;
+		result[slot / SLOTS_PER_BITMAP_WORD] |= (uint64_t)(equal ? l == r : l < r) << (slot % SLOTS_PER_BITMAP_WORD);
 	}
-	return num;
 }
 
-RC insertRecord(RM_TableData* rel, Record* record) {
-	recordMgr = rel->mgmtData;
+void compareBools(RM_Predicate* predicate, RM_PredicateStep* step, int numberOfSlots, uint64_t* result) {
+	bool* left = step->left.isAttribute ? predicate->columns[step->left.column].bools : NULL;
+	bool* right = step->right.isAttribute ? predicate->columns[step->right.column].bools : NULL;
+	bool equal = step->comparison == OP_COMP_EQUAL;
+	for (int slot = 0; slot < numberOfSlots; slot++) {
+		bool l = left != NULL ? left[slot] : step->left.constant->v.boolV;
+		bool r = right != NULL ? right[slot] : step->right.constant->v.boolV;
+		result[slot / SLOTS_PER_BITMAP_WORD] |= (uint64_t)(equal ? l == r : l < r) << (slot % SLOTS_PER_BITMAP_WORD);
+	}
+}
 
-	RID* freeSlotRID = getFirstFreeRecordRid(recordMgr->freeRecordsQueue);
+void compareStringColumns(RM_Predicate* predicate, RM_PredicateStep* step, int numberOfSlots, uint64_t* result) {
+	RM_Column* left = step->left.isAttribute ? &predicate->columns[step->left.column] : NULL;
+	RM_Column* right = step->right.isAttribute ? &predicate->columns[step->right.column] : NULL;
+	bool equal = step->comparison == OP_COMP_EQUAL;
+	for (int slot = 0; slot < numberOfSlots; slot++) {
+		char* l = left != NULL ? left->strings[slot] : step->left.constant->v.stringV;
+		int leftLength = left != NULL ? left->lengths[slot] : step->left.length;
+		char* r = right != NULL ? right->strings[slot] : step->right.constant->v.stringV;
+		int rightLength = right != NULL ? right->lengths[slot] : step->right.length;
+		int cmp = compareStrings(l, leftLength, r, rightLength);
+		result[slot / SLOTS_PER_BITMAP_WORD] |= (uint64_t)(equal ? cmp == 0 : cmp < 0) << (slot % SLOTS_PER_BITMAP_WORD);
+	}
+}
 
-	if (freeSlotRID == NULL) {
-		freeSlotRID = (RID*)malloc(sizeof(RID));
+/*
+ * Equality of a dictionary encoded attribute with a constant, compared as ints on the codes. A constant that was not in
+ * the dictionary when the condition was compiled is looked up again, records with it may have been inserted since.
+ */
+void compareCodes(RM_Predicate* predicate, RM_PredicateStep* step, int numberOfSlots, uint64_t* result) {
+	RM_Operand* attribute = step->left.isAttribute ? &step->left : &step->right;
+	RM_Operand* constant = step->left.isAttribute ? &step->right : &step->left;
+	if (constant->code == -1) {
+		RM_Dictionary* dictionary = predicate->dictionaries[predicate->columns[attribute->column].attrNum];
+		constant->code = dictionaryCode(dictionary, constant->constant->v.stringV, constant->length);
+		if (constant->code == -1) {
+			return;
+		}
+	}
+	Value code;
+	code.dt = DT_INT;
+	code.v.intV = constant->code;
+	RM_PredicateStep codeStep = *step;
+	RM_Operand* codeConstant = step->left.isAttribute ? &codeStep.right : &codeStep.left;
+	codeConstant->constant = &code;
+	// the codes of the column are read as its ints
+	RM_Column* column = &predicate->columns[attribute->column];
+	int* ints = column->ints;
+	column->ints = column->codes;
+	compareInts(predicate, &codeStep, numberOfSlots, result);
+	column->ints = ints;
+}
 
-		int maxRecordPerPage = floor(PAGE_SIZE / (recordMgr->recordSize + 1));
-		int lastPage = 1 + floor(recordMgr->tuplesCount / maxRecordPerPage);
-		freeSlotRID->page = lastPage;
+/*
+ * Evaluate the condition on all the records of a page, the slots satisfying it are set in predicate->selection.
+ */
+void evalPredicateOnPage(RM_Predicate* predicate, RM_RecordMgr* tableMgr, char* page) {
+	RM_PageHeader* header = (RM_PageHeader*)page;
+	int numberOfSlots = header->numberOfSlots;
+	int words = bitmapWords(numberOfSlots);
+	int stride = bitmapWords(predicate->numberOfSlots);
+	int top = 0;
+
+	loadColumns(predicate, tableMgr, page);
+	for (int i = 0; i < predicate->numberOfSteps; i++) {
+		RM_PredicateStep* step = &predicate->steps[i];
+		uint64_t* result = predicate->stack + top * stride;
+		uint64_t* previous = result - stride;
+		switch (step->op) {
+		case PRED_VALUE:
+			memset(result, 0, sizeof(uint64_t) * words);
+			for (int slot = 0; slot < numberOfSlots; slot++) {
+				bool value = step->left.isAttribute ? predicate->columns[step->left.column].bools[slot]
+				                                    : step->left.constant->v.boolV;
+				result[slot / SLOTS_PER_BITMAP_WORD] |= (uint64_t)value << (slot % SLOTS_PER_BITMAP_WORD);
+			}
+			top++;
+			break;
+		case PRED_COMPARE:
+			memset(result, 0, sizeof(uint64_t) * words);
+			switch (step->dataType) {
+			case DT_INT:
+				compareInts(predicate, step, numberOfSlots, result);
+				break;
+			case DT_FLOAT:
+				compareFloats(predicate, step, numberOfSlots, result);
+				break;
+			case DT_BOOL:
+				compareBools(predicate, step, numberOfSlots, result);
+				break;
+			case DT_STRING:
+				if (step->compareCodes) {
+					compareCodes(predicate, step, numberOfSlots, result);
+				}
+				else {
+					compareStringColumns(predicate, step, numberOfSlots, result);
+				}
+				break;
+			}
+			top++;
+			break;
+		case PRED_NOT:
+			for (int word = 0; word < words; word++) {
+				previous[word] = ~previous[word];
+			}
+			break;
+		case PRED_AND:
+			for (int word = 0; word < words; word++) {
+				previous[word - stride] &= previous[word];
+			}
+			top--;
+			break;
+		case PRED_OR:
+			for (int word = 0; word < words; word++) {
+				previous[word - stride] |= previous[word];
+			}
+			top--;
+			break;
+		}
+	}
 
-		int recordInLastPage = recordMgr->tuplesCount - (lastPage - 1) * maxRecordPerPage;
-		freeSlotRID->slot = recordInLastPage;
+	// free slots never satisfy the condition
+	uint64_t* occupancy = pageBitmap(page);
+	for (int word = 0; word < words; word++) {
+		predicate->selection[word] = predicate->stack[word] & occupancy[word];
 	}
+}
 
-	if (pinPage(recordMgr->bufferPool, recordMgr->pageHandle, freeSlotRID->page) != RC_OK) {
-		return RC_WRITE_FAILED;
+// a full scan only recycles a small ring of frames, leaving the rest of the pool to point lookups
+BM_AccessStrategy* createScanStrategy(RM_RecordMgr* tableMgr) {
+	int ringSize = tableMgr->bufferPool->numPages / 4;
+	if (ringSize > SCAN_RING_SIZE) {
+		ringSize = SCAN_RING_SIZE;
 	}
+	return createAccessStrategy(ringSize);
+}
 
-	recordMgr->pageHandle->data += (recordMgr->recordSize + 1) * freeSlotRID->slot;
+RC startScan(RM_TableData* rel, RM_ScanHandle* scan, Expr* cond) {
+	RM_ScanMgr* scanManager = (RM_ScanMgr*)malloc(sizeof(RM_ScanMgr));
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
 
-	char* start = record->data;
-	*(char*)recordMgr->pageHandle->data = '+';
-	recordMgr->pageHandle->data++;
+	scanManager->condition = cond;
+	scanManager->nextRid.page = 1;
+	scanManager->nextRid.slot = 0;
 
-	for (int i = 0; i < recordMgr->recordSize; i++) {
-		*(char*)recordMgr->pageHandle->data = *(char*)record->data;
-		recordMgr->pageHandle->data++;
-		record->data++;
-	}
+	scanManager->scanCount = 0;
 
-	record->data = start;
-	record->id = *freeSlotRID;
-	free(freeSlotRID);
+	scanManager->strategy = createScanStrategy(recordMgr);
+	scanManager->pageHandle = MAKE_PAGE_HANDLE();
+	scanManager->pagePinned = false;
+	scanManager->conditionRecord = NULL;
+	scanManager->predicate = cond != NULL ? compilePredicate(cond, recordMgr) : NULL;
+	scanManager->projection = NULL;
+	scanManager->pageFraction = 1;
+	scanManager->recordFraction = 1;
+	scanManager->seed = 0;
 
+	scan->mgmtData = scanManager;
+	scan->rel = rel;
+	return RC_OK;
+}
 
-	if (markDirty(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
-		return RC_WRITE_FAILED;
+// mark the attributes read by expr
+void addExprAttributes(Expr* expr, bool* projection, int numAttr) {
+	if (expr->type == EXPR_ATTRREF) {
+		if (expr->expr.attrRef >= 0 && expr->expr.attrRef < numAttr) {
+			projection[expr->expr.attrRef] = true;
+		}
 	}
-	if (unpinPage(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
-		return RC_WRITE_FAILED;
+	else if (expr->type == EXPR_OP) {
+		int numberOfArgs = expr->expr.op->type == OP_BOOL_NOT ? 1 : 2;
+		for (int i = 0; i < numberOfArgs; i++) {
+			addExprAttributes(expr->expr.op->args[i], projection, numAttr);
+		}
 	}
-	recordMgr->tuplesCount++;
-	return RC_OK;
 }
 
-RC deleteRecord(RM_TableData* rel, RID id) {
-	recordMgr = rel->mgmtData;
-	int page = id.page;
-	int slot = id.slot;
-	if (pinPage(recordMgr->bufferPool, recordMgr->pageHandle, page) != RC_OK) {
-		return RC_WRITE_FAILED;
+/*
+ * Scan copying only the attributes attrs[0..numberOfAttrs-1] in the records returned by next. They keep their place in
+ * the record so getAttr works as usual, the other attributes of the record are left unchanged.
+ */
+RC startProjectedScan(RM_TableData* rel, RM_ScanHandle* scan, Expr* cond, int* attrs, int numberOfAttrs) {
+	for (int i = 0; i < numberOfAttrs; i++) {
+		if (attrs[i] < 0 || attrs[i] >= rel->schema->numAttr) {
+			return RC_RM_UNKNOWN_ATTRIBUTE;
+		}
 	}
-	recordMgr->pageHandle->data += slot * (recordMgr->recordSize + 1);
-	printf("PUTTING -\n");
-	*(char*)recordMgr->pageHandle->data = '-';
-
-	if (markDirty(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
-		return RC_WRITE_FAILED;
+	RC rc = startScan(rel, scan, cond);
+	if (rc != RC_OK) {
+		return rc;
 	}
-
-	if (unpinPage(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
-		return RC_WRITE_FAILED;
+	RM_ScanMgr* scanManager = (RM_ScanMgr*)scan->mgmtData;
+	scanManager->projection = (bool*)calloc(rel->schema->numAttr, sizeof(bool));
+	for (int i = 0; i < numberOfAttrs; i++) {
+		scanManager->projection[attrs[i]] = true;
+	}
+	// a condition evaluated with evalExpr reads its attributes in the record
+	if (cond != NULL && scanManager->predicate == NULL) {
+		addExprAttributes(cond, scanManager->projection, rel->schema->numAttr);
 	}
-
-	insertInFreeQueue(recordMgr->freeRecordsQueue, id);
-	recordMgr->tuplesCount--;
 	return RC_OK;
 }
 
-RC updateRecord(RM_TableData* rel, Record* record) {
-	recordMgr = rel->mgmtData;
-	int page = record->id.page;
-	int slot = record->id.slot;
+/*
+ * Uniform draw in [0, 1) for a page (slot -1) or a record of a sample scan. It only depends on the seed and the position
+ * so the same seed always gives the same sample.
+ */
+double sampleDraw(unsigned int seed, int page, int slot) {
+	int key[3] = {(int)seed, page, slot};
+	return (hashValue((char*)key, sizeof(key)) >> 11) * (1.0 / (1ULL << 53));
+}
 
-	if (pinPage(recordMgr->bufferPool, recordMgr->pageHandle, page) != RC_OK) {
-		return RC_WRITE_FAILED;
+/*
+ * Scan reading a Bernoulli sample of the table: every data page is read with probability pageFraction, the others are
+ * skipped without being read, and every record of a read page is returned with probability recordFraction. A count or a
+ * sum over the records returned divided by pageFraction * recordFraction estimates the one of the whole table.
+ */
+RC startSampleScan(RM_TableData* rel, RM_ScanHandle* scan, Expr* cond, double pageFraction, double recordFraction,
+                   unsigned int seed) {
+	if (!(pageFraction > 0 && pageFraction <= 1 && recordFraction > 0 && recordFraction <= 1)) {
+		return RC_RM_INVALID_SAMPLE_FRACTION;
+	}
+	RC rc = startScan(rel, scan, cond);
+	if (rc != RC_OK) {
+		return rc;
 	}
+	RM_ScanMgr* scanManager = (RM_ScanMgr*)scan->mgmtData;
+	scanManager->pageFraction = pageFraction;
+	scanManager->recordFraction = recordFraction;
+	scanManager->seed = seed;
+	return RC_OK;
+}
 
-	recordMgr->pageHandle->data += slot * (recordMgr->recordSize + 1) + 1;
+/*
+ * Move the scan to the next record satisfying its condition and return its slot in the pinned page of the scan.
+ * A page is pinned once, when the scan reaches it, and all its records are read before it is unpinned. Pages whose zone
+ * says they have no record satisfying the condition, or not drawn by a sample scan, are skipped without being pinned. The
+ * others get their zone when they are pinned if they have none yet.
+ * A compiled condition is evaluated on the whole page when it is pinned, the scan then only goes through the slots of
+ * the selection bitmap. Without condition the used slots are found with the occupancy bitmap of the page.
+ * The returned record is decoded in record if decode is true. A condition that could not be compiled is evaluated with
+ * evalExpr on every record, decoded in record.
+ */
+RC advanceScan(RM_ScanHandle* scan, Record* record, bool decode, int* foundSlot) {
+	RM_ScanMgr* scanManager = (RM_ScanMgr*)scan->mgmtData;
+	RM_RecordMgr* tableMgr = (RM_RecordMgr*)scan->rel->mgmtData;
+	BM_PageHandle* pageHandle = scanManager->pageHandle;
+	RM_Predicate* predicate = scanManager->predicate;
+
+	while (scanManager->nextRid.page <= tableMgr->numberOfPages) {
+		if (isFreeSpaceMapPage(scanManager->nextRid.page)) {
+			scanManager->nextRid.page++;
+			continue;
+		}
+		if (!scanManager->pagePinned) {
+			int page = scanManager->nextRid.page;
+			bool sampled = scanManager->pageFraction >= 1
+			               || sampleDraw(scanManager->seed, page, -1) < scanManager->pageFraction;
+			if (!sampled || !pageMayMatch(tableMgr, page, scanManager->condition)) {
+				scanManager->nextRid.page++;
+				scanManager->nextRid.slot = 0;
+				continue;
+			}
+			if (pinPageWithStrategy(tableMgr->bufferPool, pageHandle, scanManager->nextRid.page,
+			                        scanManager->strategy) != RC_OK) {
+				return RC_WRITE_FAILED;
+			}
+			scanManager->pagePinned = true;
+			summarizePage(tableMgr, scanManager->nextRid.page, pageHandle->data);
+			if (predicate != NULL) {
+				evalPredicateOnPage(predicate, tableMgr, pageHandle->data);
+			}
+		}
 
-	char* start = record->data;
+		char* data = pageHandle->data;
+		uint64_t* candidates = predicate != NULL ? predicate->selection : pageBitmap(data);
+		int numberOfSlots = ((RM_PageHeader*)data)->numberOfSlots;
+		for (int slot = findSetBit(candidates, numberOfSlots, scanManager->nextRid.slot); slot != -1;
+		     slot = findSetBit(candidates, numberOfSlots, slot + 1)) {
+			scanManager->nextRid.slot = slot + 1;
+			// the record was deleted since the page was evaluated
+			if (!isSlotUsed(data, slot)) {
+				continue;
+			}
+			if (scanManager->recordFraction < 1
+			    && sampleDraw(scanManager->seed, scanManager->nextRid.page, slot) >= scanManager->recordFraction) {
+				continue;
+			}
+			scanManager->scanCount++;
+			bool exprCondition = scanManager->condition != NULL && predicate == NULL;
+			if (decode || exprCondition) {
+				readSlot(tableMgr, data, slot, record->data, scanManager->projection);
+				record->id = recordId(tableMgr, data, scanManager->nextRid.page, slot);
+			}
+
+			if (exprCondition) {
+				Value* result;
+				evalExpr(record, scan->rel->schema, scanManager->condition, &result);
+				bool satisfied = result->v.boolV;
+				free(result);
+				if (!satisfied) {
+					continue;
+				}
+			}
+			*foundSlot = slot;
+			return RC_OK;
+		}
 
-	for (int i = 0; i < recordMgr->recordSize; i++) {
-		*(char*)recordMgr->pageHandle->data = *(char*)record->data;
-		recordMgr->pageHandle->data++;
-		record->data++;
+		// nothing left in this page
+		scanManager->pagePinned = false;
+		if (unpinPage(tableMgr->bufferPool, pageHandle) != RC_OK) {
+			return RC_WRITE_FAILED;
+		}
+		scanManager->nextRid.page++;
+		scanManager->nextRid.slot = 0;
 	}
+	return RC_RM_NO_MORE_TUPLES;
+}
 
-	record->data = start;
+// Return a copy of the next record satisfying the condition of the scan
+RC next(RM_ScanHandle* scan, Record* record) {
+	int slot;
+	return advanceScan(scan, record, true, &slot);
+}
 
-	if (markDirty(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
-		return RC_WRITE_FAILED;
-	}
+/*
+ * Same as next but the record is not copied: it points in the page pinned by the scan and stays valid until the next call
+ * to nextBorrowed or closeScan. It must not be released.
+ */
+RC nextBorrowed(RM_ScanHandle* scan, RM_BorrowedRecord* record) {
+	RM_ScanMgr* scanManager = (RM_ScanMgr*)scan->mgmtData;
+	RM_RecordMgr* tableMgr = (RM_RecordMgr*)scan->rel->mgmtData;
 
-	if (unpinPage(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
-		return RC_READ_NON_EXISTING_PAGE;
+	if (scanManager->condition != NULL && scanManager->predicate == NULL && scanManager->conditionRecord == NULL) {
+		createRecord(&scanManager->conditionRecord, scan->rel->schema);
+	}
+	int slot;
+	RC rc = advanceScan(scan, scanManager->conditionRecord, false, &slot);
+	if (rc != RC_OK) {
+		return rc;
 	}
 
+	char* data = scanManager->pageHandle->data;
+	record->id = recordId(tableMgr, data, scanManager->nextRid.page, slot);
+	setBorrowedData(tableMgr, data, slot, record);
+	record->schema = scan->rel->schema;
+	// the pin belongs to the scan
+	record->mgmtData = NULL;
 	return RC_OK;
 }
 
-RC getRecord(RM_TableData* rel, RID id, Record* record) {
-	recordMgr = rel->mgmtData;
-	int page = id.page;
-	int slot = id.slot;
+RC closeScan(RM_ScanHandle* scan) {
+	RM_ScanMgr* scanMgr = scan->mgmtData;
+	RM_RecordMgr* tableMgr = (RM_RecordMgr*)scan->rel->mgmtData;
+	RC r = RC_OK;
+	// the scan was stopped in the middle of a page
+	if (scanMgr->pagePinned) {
+		r = unpinPage(tableMgr->bufferPool, scanMgr->pageHandle);
+	}
+	freeAccessStrategy(scanMgr->strategy);
+	if (scanMgr->conditionRecord != NULL) {
+		freeRecord(scanMgr->conditionRecord);
+	}
+	if (scanMgr->predicate != NULL) {
+		freePredicate(scanMgr->predicate);
+	}
+	free(scanMgr->projection);
+	free(scanMgr->pageHandle);
+	free(scanMgr);
+	return r;
+}
 
-	if (pinPage(recordMgr->bufferPool, recordMgr->pageHandle, page) != RC_OK) {
-		return RC_WRITE_FAILED;
+/*
+ * State shared by the threads of a parallel scan: the pages are handed out in morsels of PARALLEL_SCAN_MORSEL_PAGES
+ * pages, taken by incrementing nextPage.
+ */
+typedef struct RM_ParallelScan {
+	RM_TableData* rel;
+	Expr* condition;
+	int nextPage;
+	RC rc; // error of a thread, RC_OK if none
+} RM_ParallelScan;
+
+typedef struct RM_ScanWorker {
+	RM_ParallelScan* scan;
+	RM_ScanOutput* output;
+	pthread_t thread;
+} RM_ScanWorker;
+
+// copy the record of a slot of page pageNum at the end of the output of a thread
+void appendScanOutput(RM_ScanOutput* output, RM_RecordMgr* tableMgr, char* page, int pageNum, int slot) {
+	if (output->numberOfRecords == output->capacity) {
+		output->capacity = output->capacity == 0 ? tableMgr->slotsPerPage : output->capacity * 2;
+		output->ids = (RID*)realloc(output->ids, sizeof(RID) * output->capacity);
+		output->data = (char*)realloc(output->data, (size_t)tableMgr->recordSize * output->capacity);
 	}
+	readSlot(tableMgr, page, slot, output->data + (size_t)tableMgr->recordSize * output->numberOfRecords, NULL);
+	output->ids[output->numberOfRecords] = recordId(tableMgr, page, pageNum, slot);
+	output->numberOfRecords++;
+}
 
-	if (unpinPage(recordMgr->bufferPool, recordMgr->pageHandle) != RC_OK) {
-		return RC_READ_NON_EXISTING_PAGE;
+/*
+ * Thread of a parallel scan: takes morsels of pages until there are none left and adds the records satisfying the
+ * condition to its own output. Each thread compiles its own copy of the condition, it holds the columns of its page.
+ */
+void* parallelScanWorker(void* arg) {
+	RM_ScanWorker* worker = (RM_ScanWorker*)arg;
+	RM_ParallelScan* scan = worker->scan;
+	RM_RecordMgr* tableMgr = (RM_RecordMgr*)scan->rel->mgmtData;
+	RM_Predicate* predicate = NULL;
+	Record* record = NULL;
+	BM_PageHandle pageHandle;
+
+	if (scan->condition != NULL) {
+		predicate = compilePredicate(scan->condition, tableMgr);
+		if (predicate == NULL) {
+			createRecord(&record, scan->rel->schema);
+		}
+	}
+
+	int first;
+	while ((first = __atomic_fetch_add(&scan->nextPage, PARALLEL_SCAN_MORSEL_PAGES, __ATOMIC_RELAXED))
+	       <= tableMgr->numberOfPages) {
+		int last = first + PARALLEL_SCAN_MORSEL_PAGES - 1;
+		if (last > tableMgr->numberOfPages) {
+			last = tableMgr->numberOfPages;
+		}
+		for (int page = first; page <= last; page++) {
+			// the zones are only read, pages without one are not summarized by the threads
+			if (isFreeSpaceMapPage(page) || !pageMayMatch(tableMgr, page, scan->condition)) {
+				continue;
+			}
+			if (pinPage(tableMgr->bufferPool, &pageHandle, page) != RC_OK) {
+				__atomic_store_n(&scan->rc, RC_WRITE_FAILED, __ATOMIC_RELAXED);
+				break;
+			}
+			char* data = pageHandle.data;
+			if (predicate != NULL) {
+				evalPredicateOnPage(predicate, tableMgr, data);
+			}
+			uint64_t* candidates = predicate != NULL ? predicate->selection : pageBitmap(data);
+			int numberOfSlots = ((RM_PageHeader*)data)->numberOfSlots;
+			for (int slot = findSetBit(candidates, numberOfSlots, 0); slot != -1;
+			     slot = findSetBit(candidates, numberOfSlots, slot + 1)) {
+				if (record != NULL) {
+					Value* result;
+					readSlot(tableMgr, data, slot, record->data, NULL);
+					evalExpr(record, scan->rel->schema, scan->condition, &result);
+					bool satisfied = result->v.boolV;
+					free(result);
+					if (!satisfied) {
+						continue;
+					}
+				}
+				appendScanOutput(worker->output, tableMgr, data, page, slot);
+			}
+			unpinPage(tableMgr->bufferPool, &pageHandle);
+		}
+		if (__atomic_load_n(&scan->rc, __ATOMIC_RELAXED) != RC_OK) {
+			break;
+		}
 	}
 
-	recordMgr->pageHandle->data += slot * (recordMgr->recordSize + 1);
+	if (predicate != NULL) {
+		freePredicate(predicate);
+	}
+	if (record != NULL) {
+		freeRecord(record);
+	}
+	return NULL;
+}
 
-	// tuple is deleted
-	if (*recordMgr->pageHandle->data != '+') {
+/*
+ * Scan the whole table with numberOfThreads threads. outputs must have numberOfThreads elements, each thread puts the
+ * records it finds in its own output (in no particular order across the outputs), they are freed with freeScanOutput.
+ * The pool of the table gets a frame more per thread during the scan, as every thread keeps its current page pinned. It
+ * is held meanwhile so that the memory governor does not resize it.
+ * The table must not be changed during the scan.
+ */
+RC parallelScan(RM_TableData* rel, Expr* cond, int numberOfThreads, RM_ScanOutput* outputs) {
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+	if (numberOfThreads < 1) {
+		numberOfThreads = 1;
+	}
+	RM_ParallelScan scan = {rel, cond, 1, RC_OK};
+	RM_ScanWorker* workers = (RM_ScanWorker*)malloc(sizeof(RM_ScanWorker) * numberOfThreads);
+
+	holdBufferPoolSize(recordMgr->bufferPool);
+	if (resizeBufferPool(recordMgr->bufferPool, recordMgr->bufferPool->numPages + numberOfThreads) != RC_OK) {
+		releaseBufferPoolSize(recordMgr->bufferPool);
+		free(workers);
 		return RC_WRITE_FAILED;
 	}
-	recordMgr->pageHandle->data++;
 
-	memcpy(record->data, recordMgr->pageHandle->data, recordMgr->recordSize);
-	record->id = id;
+	int started = 0;
+	for (int i = 0; i < numberOfThreads; i++) {
+		outputs[i].numberOfRecords = 0;
+		outputs[i].capacity = 0;
+		outputs[i].ids = NULL;
+		outputs[i].data = NULL;
+		workers[i].scan = &scan;
+		workers[i].output = &outputs[i];
+		if (pthread_create(&workers[i].thread, NULL, parallelScanWorker, &workers[i]) != 0) {
+			scan.rc = RC_WRITE_FAILED;
+			break;
+		}
+		started++;
+	}
+	for (int i = 0; i < started; i++) {
+		pthread_join(workers[i].thread, NULL);
+	}
+	free(workers);
 
+	resizeBufferPool(recordMgr->bufferPool, recordMgr->bufferPool->numPages - numberOfThreads);
+	releaseBufferPoolSize(recordMgr->bufferPool);
+	return scan.rc;
+}
 
-	return RC_OK;
+void freeScanOutput(RM_ScanOutput* output) {
+	free(output->ids);
+	free(output->data);
+	output->ids = NULL;
+	output->data = NULL;
+	output->numberOfRecords = 0;
+	output->capacity = 0;
 }
 
-RC createRecord(Record** record, Schema* schema) {
-	*record = (Record*)malloc(sizeof(Record));
+// dealing with schemas
+// the first bits of the hash choose the register, which keeps the longest run of leading zeros of the other bits
+void addToSketch(uint8_t* registers, uint64_t hash) {
+	int index = hash >> (64 - HLL_REGISTER_BITS);
+	uint64_t rest = hash << HLL_REGISTER_BITS;
+	int rank = rest == 0 ? 64 - HLL_REGISTER_BITS + 1 : __builtin_clzll(rest) + 1;
+	if (rank > registers[index]) {
+		registers[index] = rank;
+	}
+}
 
-	int recordSize = getRecordSize(schema);
+double estimateDistinct(uint8_t* registers) {
+	double sum = 0;
+	int zeros = 0;
+	for (int i = 0; i < HLL_REGISTERS; i++) {
+		sum += ldexp(1.0, -registers[i]);
+		zeros += registers[i] == 0;
+	}
+	double estimate = 0.709 * HLL_REGISTERS * HLL_REGISTERS / sum;
+	// few values: counting the empty registers is more precise
+	if (estimate <= 2.5 * HLL_REGISTERS && zeros > 0) {
+		estimate = HLL_REGISTERS * log((double)HLL_REGISTERS / zeros);
+	}
+	return estimate;
+}
 
-	(*record)->data = (char*)malloc(recordSize);
-	(*record)->id.page = 0;
-	(*record)->id.slot = 0;
+int compareDoubles(const void* left, const void* right) {
+	double a = *(const double*)left;
+	double b = *(const double*)right;
+	return (a > b) - (a < b);
+}
 
-	return RC_OK;
+int comparePageNumbers(const void* left, const void* right) {
+	int a = *(const int*)left;
+	int b = *(const int*)right;
+	return (a > b) - (a < b);
+}
 
+// value of an int or float attribute of a record in the in memory layout
+double numericAttr(Schema* schema, char* data, int attrNum) {
+	if (schema->dataTypes[attrNum] == DT_INT) {
+		int value;
+		memcpy(&value, data + schema->attrOffsets[attrNum], sizeof(int));
+		return value;
+	}
+	float value;
+	memcpy(&value, data + schema->attrOffsets[attrNum], sizeof(float));
+	return value;
 }
 
-RC freeRecord(Record* record) {
-	free(record->data);
-	free(record);
-	return RC_OK;
+/*
+ * The data pages sampled by analyzeTable, in increasing order: all of them if the table has at most numberOfSamplePages
+ * data pages (or numberOfSamplePages is 0), numberOfSamplePages pages drawn at random otherwise.
+ */
+int* samplePages(RM_RecordMgr* tableMgr, int numberOfSamplePages, int* numberOfPages) {
+	int* pages = (int*)malloc(sizeof(int) * (tableMgr->numberOfPages + 1));
+	int count = 0;
+	for (int page = 1; page <= tableMgr->numberOfPages; page++) {
+		if (!isFreeSpaceMapPage(page)) {
+			pages[count++] = page;
+		}
+	}
+	if (numberOfSamplePages > 0 && numberOfSamplePages < count) {
+		// the first numberOfSamplePages steps of a Fisher-Yates shuffle
+		uint64_t state = ANALYZE_SEED;
+		for (int i = 0; i < numberOfSamplePages; i++) {
+			state ^= state << 13;
+			state ^= state >> 7;
+			state ^= state << 17;
+			int j = i + state % (count - i);
+			int page = pages[i];
+			pages[i] = pages[j];
+			pages[j] = page;
+		}
+		count = numberOfSamplePages;
+		qsort(pages, count, sizeof(int), comparePageNumbers);
+	}
+	*numberOfPages = count;
+	return pages;
 }
 
-RC startScan(RM_TableData* rel, RM_ScanHandle* scan, Expr* cond) {
-	RM_ScanMgr* scanManager = (RM_ScanMgr*)malloc(sizeof(RM_ScanMgr));
-	recordMgr = (RM_RecordMgr*)rel->mgmtData;
+/*
+ * Build the statistics of the table from the records of numberOfSamplePages data pages chosen at random (all the pages
+ * if numberOfSamplePages is 0): an equi-depth histogram of every int and float attribute and the number of distinct
+ * values of every attribute, estimated with a HyperLogLog sketch. They replace the previous ones and are written in
+ * page 0 when the table is closed. The sampled pages also get their zone.
+ */
+RC analyzeTable(RM_TableData* rel, int numberOfSamplePages) {
+	RM_RecordMgr* recordMgr = (RM_RecordMgr*)rel->mgmtData;
+	Schema* schema = rel->schema;
+	if (metadataSize(schema) + statisticsSize(schema) > PAGE_SIZE) {
+		return RC_RM_STATISTICS_TOO_LARGE;
+	}
 
-	scanManager->condition = cond;
-	scanManager->lastRid.page = 1;
-	scanManager->lastRid.slot = 0;
+	RM_Statistics* statistics = (RM_Statistics*)malloc(sizeof(RM_Statistics));
+	statistics->attrs = (RM_AttrStatistics*)calloc(schema->numAttr, sizeof(RM_AttrStatistics));
+	statistics->numberOfTuples = recordMgr->tuplesCount;
+	statistics->sampledTuples = 0;
+	// sampled values of the int and float attributes
+	double** values = (double**)calloc(schema->numAttr, sizeof(double*));
+	int capacity = 0;
+
+	int numberOfPages;
+	int* pages = samplePages(recordMgr, numberOfSamplePages, &numberOfPages);
+	BM_AccessStrategy* strategy = createScanStrategy(recordMgr);
+	BM_PageHandle pageHandle;
+	Record* record;
+	createRecord(&record, schema);
+	RC rc = RC_OK;
+
+	for (int i = 0; i < numberOfPages && rc == RC_OK; i++) {
+		if (pinPageWithStrategy(recordMgr->bufferPool, &pageHandle, pages[i], strategy) != RC_OK) {
+			rc = RC_WRITE_FAILED;
+			break;
+		}
+		char* page = pageHandle.data;
+		summarizePage(recordMgr, pages[i], page);
+		int numberOfSlots = ((RM_PageHeader*)page)->numberOfSlots;
+		for (int slot = findUsedSlot(page, 0); slot != -1 && slot < numberOfSlots; slot = findUsedSlot(page, slot + 1)) {
+			readSlot(recordMgr, page, slot, record->data, NULL);
+			int sample = statistics->sampledTuples++;
+			if (sample == capacity) {
+				capacity = capacity == 0 ? recordMgr->slotsPerPage : capacity * 2;
+				for (int attr = 0; attr < schema->numAttr; attr++) {
+					if (schema->dataTypes[attr] == DT_INT || schema->dataTypes[attr] == DT_FLOAT) {
+						values[attr] = (double*)realloc(values[attr], sizeof(double) * capacity);
+					}
+				}
+			}
+			for (int attr = 0; attr < schema->numAttr; attr++) {
+				char* value = record->data + schema->attrOffsets[attr];
+				int length = attributeSize(schema, attr);
+				if (schema->dataTypes[attr] == DT_STRING) {
+					length = strnlen(value, length);
+				}
+				addToSketch(statistics->attrs[attr].registers, hashValue(value, length));
+				if (values[attr] != NULL) {
+					values[attr][sample] = numericAttr(schema, record->data, attr);
+				}
+			}
+		}
+		if (unpinPage(recordMgr->bufferPool, &pageHandle) != RC_OK) {
+			rc = RC_WRITE_FAILED;
+		}
+	}
 
-	scanManager->scanCount = 0;
+	int sampled = statistics->sampledTuples;
+	for (int attr = 0; attr < schema->numAttr && rc == RC_OK; attr++) {
+		RM_AttrStatistics* attrStatistics = &statistics->attrs[attr];
+		double distinct = estimateDistinct(attrStatistics->registers);
+		if (distinct > sampled) {
+			distinct = sampled;
+		}
+		// only the values of the sample were counted
+		if (sampled < statistics->numberOfTuples && distinct >= ANALYZE_UNIQUE_FRACTION * sampled) {
+			distinct = distinct * statistics->numberOfTuples / sampled;
+		}
+		attrStatistics->distinctValues = distinct;
+		if (values[attr] != NULL && sampled > 0) {
+			qsort(values[attr], sampled, sizeof(double), compareDoubles);
+			for (int bucket = 0; bucket <= STATISTICS_BUCKETS; bucket++) {
+				attrStatistics->bounds[bucket] = values[attr][(long)(sampled - 1) * bucket / STATISTICS_BUCKETS];
+			}
+			attrStatistics->hasHistogram = true;
+		}
+	}
 
-	scan->mgmtData = scanManager;
-	scan->rel = rel;
+	for (int attr = 0; attr < schema->numAttr; attr++) {
+		free(values[attr]);
+	}
+	free(values);
+	free(pages);
+	freeRecord(record);
+	freeAccessStrategy(strategy);
+	if (rc != RC_OK) {
+		freeStatistics(statistics);
+		return rc;
+	}
+	freeStatistics(recordMgr->statistics);
+	recordMgr->statistics = statistics;
 	return RC_OK;
 }
 
-RID computeNextRid(RID actualRid, int recordSize) {
-	RID nextRid;
-	int maxRecordPerPage = floor(PAGE_SIZE / (recordSize + 1));
-	if (actualRid.slot >= maxRecordPerPage) {
-		nextRid.page = actualRid.page + 1;
-		nextRid.slot = 0;
+// fraction of the values of an attribute smaller than value, interpolated in the bucket of value
+double fractionBelow(RM_AttrStatistics* attr, double value) {
+	double* bounds = attr->bounds;
+	if (value <= bounds[0]) {
+		return 0;
 	}
-	else {
-		nextRid.page = actualRid.page;
-		nextRid.slot = actualRid.slot + 1;
+	if (value > bounds[STATISTICS_BUCKETS]) {
+		return 1;
+	}
+	int bucket = 0;
+	while (value > bounds[bucket + 1]) {
+		bucket++;
 	}
-	return nextRid;
+	double width = bounds[bucket + 1] - bounds[bucket];
+	double inBucket = width > 0 ? (value - bounds[bucket]) / width : 0;
+	return (bucket + inBucket) / STATISTICS_BUCKETS;
 }
 
-RC next(RM_ScanHandle* scan, Record* record) {
-	RM_ScanMgr* scanManager = (RM_ScanMgr*)scan->mgmtData;
-	RID nextRid = computeNextRid(scanManager->lastRid, recordMgr->recordSize);
-	if (scanManager->condition == NULL) {
-		getRecord(scan->rel, nextRid, record);
-		return RC_OK;
+double exprSelectivity(RM_RecordMgr* tableMgr, Expr* expr) {
+	Schema* schema = tableMgr->schema;
+	if (expr->type == EXPR_CONST) {
+		return expr->expr.cons->dt == DT_BOOL && expr->expr.cons->v.boolV ? 1 : 0;
 	}
-	Value* result = (Value*)malloc(sizeof(Value));
-	result->v.boolV = FALSE;
-	while (result->v.boolV != TRUE) {
-		free(result);
-		if (getRecord(scan->rel, nextRid, record) != RC_OK) {
-			return RC_RM_NO_MORE_TUPLES;
-		}
-		evalExpr(record, scan->rel->schema, scanManager->condition, &result);
-		nextRid = computeNextRid(nextRid, recordMgr->recordSize);
-		scanManager->scanCount++;
+	if (expr->type == EXPR_ATTRREF) {
+		return 0.5;
 	}
-
-	if (result->v.boolV == TRUE) {
-		free(result);
-		scanManager->lastRid = nextRid;
-		return RC_OK;
+	Operator* op = expr->expr.op;
+	switch (op->type) {
+	case OP_BOOL_NOT:
+		return 1 - exprSelectivity(tableMgr, op->args[0]);
+	case OP_BOOL_AND:
+		return exprSelectivity(tableMgr, op->args[0]) * exprSelectivity(tableMgr, op->args[1]);
+	case OP_BOOL_OR: {
+		double left = exprSelectivity(tableMgr, op->args[0]);
+		double right = exprSelectivity(tableMgr, op->args[1]);
+		return left + right - left * right;
+	}
+	case OP_COMP_EQUAL:
+	case OP_COMP_SMALLER:
+		break;
+	}
+	double defaultSelectivity = op->type == OP_COMP_EQUAL ? DEFAULT_EQUALITY_SELECTIVITY : DEFAULT_RANGE_SELECTIVITY;
+
+	// attribute on the left or on the right of the constant
+	Expr* attribute = op->args[0];
+	Expr* constant = op->args[1];
+	bool attributeFirst = true;
+	if (attribute->type != EXPR_ATTRREF) {
+		attribute = op->args[1];
+		constant = op->args[0];
+		attributeFirst = false;
+	}
+	if (tableMgr->statistics == NULL || attribute->type != EXPR_ATTRREF || constant->type != EXPR_CONST) {
+		return defaultSelectivity;
+	}
+	int attrNum = attribute->expr.attrRef;
+	if (attrNum < 0 || attrNum >= schema->numAttr || constant->expr.cons->dt != schema->dataTypes[attrNum]) {
+		return defaultSelectivity;
+	}
+	RM_AttrStatistics* attr = &tableMgr->statistics->attrs[attrNum];
+	double value = 0;
+	if (attr->hasHistogram) {
+		value = constant->expr.cons->dt == DT_INT ? constant->expr.cons->v.intV : constant->expr.cons->v.floatV;
 	}
 
-	if (scanManager->scanCount == recordMgr->tuplesCount) {
-		free(result);
-		return RC_RM_NO_MORE_TUPLES;
+	double equal = attr->distinctValues >= 1 ? 1 / attr->distinctValues : 1;
+	if (attr->hasHistogram && (value < attr->bounds[0] || value > attr->bounds[STATISTICS_BUCKETS])) {
+		equal = 0;
 	}
-	free(result);
-	printf("Found record satisfying condition\n");
-	return RC_OK;
+	if (op->type == OP_COMP_EQUAL) {
+		return equal;
+	}
+	if (!attr->hasHistogram) {
+		return defaultSelectivity;
+	}
+	double below = fractionBelow(attr, value);
+	if (attributeFirst) {
+		return below;
+	}
+	// constant < attribute
+	double above = 1 - below - equal;
+	return above > 0 ? above : 0;
 }
 
-RC closeScan(RM_ScanHandle* scan) {
-	RM_ScanMgr* scanMgr = scan->mgmtData;
-	free(scanMgr);
-	return RC_OK;
+/*
+ * Estimated fraction of the records of the table satisfying cond, from the statistics of analyzeTable. Comparisons of an
+ * attribute with a constant use the histogram and the number of distinct values of the attribute, AND, OR and NOT take
+ * the conditions as independent. Without statistics the default selectivities are used. A caller can compare it with the
+ * cost of a full scan to choose between an index lookup and a scan.
+ */
+double estimateSelectivity(RM_TableData* rel, Expr* cond) {
+	if (cond == NULL) {
+		return 1;
+	}
+	return exprSelectivity((RM_RecordMgr*)rel->mgmtData, cond);
 }
 
-// dealing with schemas
 int getRecordSize(Schema* schema) {
-	int size = 0;
-	for (int i = 0; i < schema->numAttr; i++) {
-		switch (schema->dataTypes[i]) {
-		case DT_INT:
-			size += sizeof(int);
-			break;
-		case DT_STRING:
-			size += schema->typeLength[i];
-			break;
-		case DT_FLOAT:
-			size += sizeof(float);
-			break;
-		case DT_BOOL:
-			size += sizeof(bool);
-			break;
-		}
-	}
-	return size;
+	return schema->attrOffsets[schema->numAttr];
 }
 
 Schema* createSchema(int numAttr, char** attrNames, DataType* dataTypes, int* typeLength, int keySize, int* keys) {
@@ -664,6 +4049,7 @@ Schema* createSchema(int numAttr, char** attrNames, DataType* dataTypes, int* ty
 	schema->typeLength = typeLength;
 	schema->keyAttrs = keys;
 	schema->keySize = keySize;
+	computeAttrOffsets(schema);
 	return schema;
 }
 
@@ -674,26 +4060,21 @@ RC freeSchema(Schema* schema) {
 	free(schema->attrNames);
 	free(schema->dataTypes);
 	free(schema->typeLength);
+	free(schema->attrOffsets);
 	free(schema->keyAttrs);
 	free(schema);
 	return RC_OK;
 }
 
 
-// to have access to func in rm_serializer.c
-static RC attrOffset(Schema* schema, int attrNum, int* result);
-
 RC getAttr(Record* record, Schema* schema, int attrNum, Value** value) {
-	// same way as in rm_serializer.c
-	int offset;
-	char* attrData;
+	char* attrData = record->data + schema->attrOffsets[attrNum];
 	(*value) = malloc(sizeof(Value));
 	DataType type = schema->dataTypes[attrNum];
-	attrOffset(schema, attrNum, &offset);
-	attrData = record->data + offset;
 	switch (type) {
 	case DT_INT: ;
-		int int_val = (int)*attrData;
+		int int_val;
+		memcpy(&int_val, attrData, sizeof(int));
 		(*value)->dt = DT_INT;
 		(*value)->v.intV = int_val;
 		break;
@@ -705,7 +4086,8 @@ RC getAttr(Record* record, Schema* schema, int attrNum, Value** value) {
 		(*value)->dt = DT_STRING;
 		break;
 	case DT_FLOAT: ;
-		float float_val = (float)*attrData;
+		float float_val;
+		memcpy(&float_val, attrData, sizeof(float));
 		(*value)->dt = DT_FLOAT;
 		(*value)->v.floatV = float_val;
 		break;
@@ -719,11 +4101,7 @@ RC getAttr(Record* record, Schema* schema, int attrNum, Value** value) {
 }
 
 RC setAttr(Record* record, Schema* schema, int attrNum, Value* value) {
-	int offset;
-
-	attrOffset(schema, attrNum, &offset);
-
-	char* pointerToData = record->data + offset;
+	char* pointerToData = record->data + schema->attrOffsets[attrNum];
 
 	switch (schema->dataTypes[attrNum]) {
 	case DT_STRING: {
@@ -754,27 +4132,71 @@ RC setAttr(Record* record, Schema* schema, int attrNum, Value* value) {
 	return RC_OK;
 }
 
-RC
-attrOffset(Schema* schema, int attrNum, int* result) {
-	int offset = 0;
-	int attrPos = 0;
-
-	for (attrPos = 0; attrPos < attrNum; attrPos++) {
-		switch (schema->dataTypes[attrPos]) {
-		case DT_STRING:
-			offset += schema->typeLength[attrPos];
-			break;
-		case DT_INT:
-			offset += sizeof(int);
-			break;
-		case DT_FLOAT:
-			offset += sizeof(float);
-			break;
-		case DT_BOOL:
-			offset += sizeof(bool);
-			break;
+/*
+ * Start of an attribute in an encoded record: the strings before it are skipped using their length.
+ */
+char* borrowedAttrData(RM_BorrowedRecord* record, int attrNum) {
+	Schema* schema = record->schema;
+	RM_RecordMgr* tableMgr = (RM_RecordMgr*)record->tableMgmtData;
+	if (tableMgr->format == RM_FORMAT_PAX) {
+		return paxValue(tableMgr, record->data, attrNum, record->id.slot);
+	}
+	char* attrData = record->data;
+	for (int i = 0; i < attrNum; i++) {
+		if (isDictionaryEncoded(tableMgr, i)) {
+			attrData += sizeof(uint16_t);
+		}
+		else if (schema->dataTypes[i] == DT_STRING) {
+			uint16_t length;
+			memcpy(&length, attrData, sizeof(uint16_t));
+			attrData += sizeof(uint16_t) + length;
+		}
+		else {
+			attrData += attributeSize(schema, i);
 		}
 	}
-	*result = offset;
-	return RC_OK;
+	return attrData;
+}
+
+// attributes are not aligned in an encoded record, they are read with memcpy
+int getBorrowedInt(RM_BorrowedRecord* record, int attrNum) {
+	int value;
+	memcpy(&value, borrowedAttrData(record, attrNum), sizeof(int));
+	return value;
+}
+
+float getBorrowedFloat(RM_BorrowedRecord* record, int attrNum) {
+	float value;
+	memcpy(&value, borrowedAttrData(record, attrNum), sizeof(float));
+	return value;
+}
+
+bool getBorrowedBool(RM_BorrowedRecord* record, int attrNum) {
+	bool value;
+	memcpy(&value, borrowedAttrData(record, attrNum), sizeof(bool));
+	return value;
+}
+
+/*
+ * Pointer to the characters of a string attribute in the page. The string is not '\0' terminated, its length is put in
+ * length.
+ */
+char* getBorrowedString(RM_BorrowedRecord* record, int attrNum, int* length) {
+	char* attrData = borrowedAttrData(record, attrNum);
+	RM_RecordMgr* tableMgr = (RM_RecordMgr*)record->tableMgmtData;
+	// the string of a code is in the dictionary, '\0' terminated
+	if (isDictionaryEncoded(tableMgr, attrNum)) {
+		uint16_t code;
+		memcpy(&code, attrData, sizeof(uint16_t));
+		return dictionaryString(tableMgr->dictionaries[attrNum], code, length);
+	}
+	// strings of PAX pages keep their in memory layout
+	if (tableMgr->format == RM_FORMAT_PAX) {
+		*length = strnlen(attrData, record->schema->typeLength[attrNum]);
+		return attrData;
+	}
+	uint16_t stringLength;
+	memcpy(&stringLength, attrData, sizeof(uint16_t));
+	*length = stringLength;
+	return attrData + sizeof(uint16_t);
 }
@@ -39,5 +39,16 @@ extern RC writeBlock (int pageNum, SM_FileHandle *fHandle, SM_PageHandle memPage
 extern RC writeCurrentBlock (SM_FileHandle *fHandle, SM_PageHandle memPage);
 extern RC appendEmptyBlock (SM_FileHandle *fHandle);
 extern RC ensureCapacity (int numberOfPages, SM_FileHandle *fHandle);
+extern RC truncatePageFile (int numberOfPages, SM_FileHandle *fHandle);
+
+/* reading and writing bytes, for page files whose pages are not stored in blocks (compressed page files) */
+extern long getFileSize (SM_FileHandle *fHandle);
+extern RC readBytes (long offset, int length, SM_FileHandle *fHandle, char *memory);
+extern RC writeBytes (long offset, int length, SM_FileHandle *fHandle, char *memory);
+extern RC truncateBytes (long size, SM_FileHandle *fHandle);
+
+/* durability */
+extern RC syncPageFile (SM_FileHandle *fHandle);
+extern RC renamePageFile (char *fileName, char *newName);
 
 #endif
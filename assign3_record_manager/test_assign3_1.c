@@ -1,8 +1,15 @@
 #include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "buffer_mgr.h"
 #include "dberror.h"
 #include "expr.h"
 #include "record_mgr.h"
+#include "storage_mgr.h"
 #include "tables.h"
+#include "wal_mgr.h"
 #include "test_helper.h"
 
 
@@ -68,6 +75,50 @@ static void testInsertManyRecords(void);
 
 static void testMultipleScans(void);
 
+static void testSlottedPages(void);
+
+static void testUpdateGrowingRecords(void);
+
+static void testFreeSpaceMap(void);
+
+static void testTwoOpenTables(void);
+
+static void testScanPins(void);
+
+static void testBorrowedRecords(void);
+
+static void testCompiledPredicates(void);
+
+static void testPageAtATimeScans(void);
+
+static void testAttributeOffsets(void);
+
+static void testInsertRecords(void);
+
+static void testPaxTable(void);
+
+static void testProjectedScans(void);
+
+static void testParallelScan(void);
+
+static void testZoneMaps(void);
+
+static void testSelectivityEstimates(void);
+
+static void testSampleScans(void);
+
+static void testVacuumTable(void);
+
+static void testDictionaryEncoding(void);
+
+static void testCompressTable(void);
+
+static void testWriteAheadLog(void);
+
+static void testCrashRecovery(void);
+
+static void testGovernedTablePool(void);
+
 // struct for test records
 typedef struct TestRecord {
     int a;
@@ -82,6 +133,20 @@ Schema *testSchema(void);
 
 Record *fromTestRecord(Schema *schema, TestRecord in);
 
+void checkGrownRecords(RM_TableData *table, Schema *schema, RID *rids, char **values, int numRecords);
+
+Record *numberedRecord(Schema *schema, int i);
+
+void insertNumberedRecords(RM_TableData *table, Schema *schema, RID *rids, int numRecords);
+
+bool compiledCondition(int k, int i);
+
+void pageScanRecord(Record *r, Schema *schema, int i, char *b);
+
+bool pageCondition(int k, int i);
+
+int countScan(RM_TableData *table, Expr *cond);
+
 // test name
 char *testName;
 
@@ -97,6 +162,28 @@ main(void) {
     testScans();
     testScansTwo();
     testMultipleScans();
+    testSlottedPages();
+    testUpdateGrowingRecords();
+    testFreeSpaceMap();
+    testTwoOpenTables();
+    testScanPins();
+    testBorrowedRecords();
+    testCompiledPredicates();
+    testPageAtATimeScans();
+    testAttributeOffsets();
+    testInsertRecords();
+    testPaxTable();
+    testProjectedScans();
+    testParallelScan();
+    testZoneMaps();
+    testSelectivityEstimates();
+    testSampleScans();
+    testVacuumTable();
+    testDictionaryEncoding();
+    testCompressTable();
+    testWriteAheadLog();
+    testCrashRecovery();
+    testGovernedTablePool();
 
     return 0;
 }
@@ -682,6 +769,244 @@ void testScansTwo(void) {
     TEST_DONE();
 }
 
+// ************************************************************
+void
+testSlottedPages(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    int numInserts = 2000, numDeleted = 0, i, rc, scanned, firstPage, lastPage, wrong = 0;
+    bool *deleted;
+    Record *r;
+    RID *rids;
+    Schema *schema;
+    testName = "test slotted pages with an occupancy bitmap";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+    deleted = (bool *) calloc(numInserts, sizeof(bool));
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_s", schema));
+    TEST_CHECK(openTable(table, "test_table_s"));
+    for (i = 0; i < numInserts; i++) {
+        r = testRecord(schema, i, "ssss", i);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+
+    // the slots of a page are filled in order before the next page is used
+    for (i = 1; i < numInserts; i++) {
+        if (!(rids[i].page == rids[i - 1].page && rids[i].slot == rids[i - 1].slot + 1)
+            && !(rids[i].page == rids[i - 1].page + 1 && rids[i].slot == 0))
+            wrong++;
+    }
+    ASSERT_EQUALS_INT(0, wrong, "the records fill the slots of each page in order");
+    firstPage = rids[0].page;
+    lastPage = rids[numInserts - 1].page;
+    ASSERT_TRUE(lastPage - firstPage >= 3, "the records take several pages");
+
+    // a whole page, every other record of the next one and the last record
+    for (i = 0; i < numInserts; i++) {
+        deleted[i] = rids[i].page == firstPage || (rids[i].page == firstPage + 1 && i % 2 == 0) || i == numInserts - 1;
+        if (deleted[i]) {
+            TEST_CHECK(deleteRecord(table, rids[i]));
+            numDeleted++;
+        }
+    }
+
+    // the scan skips the empty page and the free slots, and returns the other records in the order of their slots
+    TEST_CHECK(createRecord(&r, schema));
+    for (int reopen = 0; reopen < 2; reopen++) {
+        TEST_CHECK(startScan(table, sc, NULL));
+        scanned = 0;
+        i = 0;
+        while ((rc = next(sc, r)) == RC_OK) {
+            while (i < numInserts && deleted[i])
+                i++;
+            if (i == numInserts || r->id.page != rids[i].page || r->id.slot != rids[i].slot) {
+                wrong++;
+            }
+            else {
+                Record *expected = testRecord(schema, i, "ssss", i);
+                if (memcmp(expected->data, r->data, getRecordSize(schema)) != 0)
+                    wrong++;
+                freeRecord(expected);
+            }
+            i++;
+            scanned++;
+        }
+        if (rc != RC_RM_NO_MORE_TUPLES)
+            TEST_CHECK(rc);
+        TEST_CHECK(closeScan(sc));
+        ASSERT_EQUALS_INT(0, wrong, "the scan returns the records left in order");
+        ASSERT_EQUALS_INT(numInserts - numDeleted, scanned, "the scan returns every record left");
+        TEST_CHECK(closeTable(table));
+        TEST_CHECK(openTable(table, "test_table_s"));
+    }
+    freeRecord(r);
+
+    // the emptied page is the first one with a free slot
+    r = testRecord(schema, numInserts, "new", 0);
+    TEST_CHECK(insertRecord(table, r));
+    ASSERT_EQUALS_INT(firstPage, r->id.page, "the insert reuses the first free slot");
+    ASSERT_EQUALS_INT(0, r->id.slot, "the insert reuses the first free slot");
+    freeRecord(r);
+    TEST_CHECK(createRecord(&r, schema));
+    for (i = 1; i < numInserts; i++) {
+        if (deleted[i])
+            ASSERT_ERROR(getRecord(table, rids[i], r), "a deleted record is not found");
+    }
+    freeRecord(r);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_s"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    free(sc);
+    free(rids);
+    free(deleted);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testUpdateGrowingRecords(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    int numInserts = 1000, numRecords = 2 * numInserts, i;
+    Record *r;
+    RID *rids;
+    char **values;
+    Schema *schema;
+    testName = "test updating records growing out of their page, they keep their RIDs";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numRecords);
+    // attribute b of record i, NULL when it is not in the table
+    values = (char **) calloc(numRecords, sizeof(char *));
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_g", schema));
+    TEST_CHECK(openTable(table, "test_table_g"));
+
+    // the shortest records fill the pages
+    for (i = 0; i < numInserts; i++) {
+        values[i] = "";
+        r = testRecord(schema, i, values[i], -i);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+
+    // the pages have no room for all their records once they grow, some move to other pages
+    for (i = 0; i < numInserts; i++) {
+        values[i] = "gggg";
+        r = testRecord(schema, i, values[i], -i);
+        r->id = rids[i];
+        TEST_CHECK(updateRecord(table, r));
+        freeRecord(r);
+    }
+    checkGrownRecords(table, schema, rids, values, numRecords);
+
+    // deleting the moved records too
+    TEST_CHECK(createRecord(&r, schema));
+    for (i = 0; i < numInserts; i += 2) {
+        TEST_CHECK(deleteRecord(table, rids[i]));
+        values[i] = NULL;
+        if (getRecord(table, rids[i], r) == RC_OK)
+            ASSERT_ERROR(getRecord(table, rids[i], r), "try to access record after you delete it");
+    }
+    freeRecord(r);
+    checkGrownRecords(table, schema, rids, values, numRecords);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openTable(table, "test_table_g"));
+    checkGrownRecords(table, schema, rids, values, numRecords);
+
+    // the moved records shrink in their new slots, new records take the space left
+    for (i = 1; i < numInserts; i += 2) {
+        values[i] = "";
+        r = testRecord(schema, i, values[i], -i);
+        r->id = rids[i];
+        TEST_CHECK(updateRecord(table, r));
+        freeRecord(r);
+    }
+    for (i = numInserts; i < numRecords; i++) {
+        values[i] = "";
+        r = testRecord(schema, i, values[i], -i);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    checkGrownRecords(table, schema, rids, values, numRecords);
+
+    // growing again, they go back to their pages or move once more
+    for (i = 1; i < numRecords; i += 2) {
+        values[i] = "hhhh";
+        r = testRecord(schema, i, values[i], -i);
+        r->id = rids[i];
+        TEST_CHECK(updateRecord(table, r));
+        freeRecord(r);
+    }
+    checkGrownRecords(table, schema, rids, values, numRecords);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_g"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    free(rids);
+    free(values);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// record i is testRecord(schema, i, values[i], -i), read with getRecord and returned once by a scan with its RID
+void
+checkGrownRecords(RM_TableData *table, Schema *schema, RID *rids, char **values, int numRecords) {
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    int *seen = (int *) calloc(numRecords, sizeof(int));
+    int i, rc, wrong = 0, numPresent = 0, scanned = 0;
+    Record *r, *expected;
+
+    TEST_CHECK(createRecord(&r, schema));
+    for (i = 0; i < numRecords; i++) {
+        if (values[i] == NULL)
+            continue;
+        numPresent++;
+        expected = testRecord(schema, i, values[i], -i);
+        TEST_CHECK(getRecord(table, rids[i], r));
+        if (memcmp(expected->data, r->data, getRecordSize(schema)) != 0)
+            wrong++;
+        freeRecord(expected);
+    }
+    ASSERT_EQUALS_INT(0, wrong, "getRecord finds the records at their RIDs");
+
+    TEST_CHECK(startScan(table, sc, NULL));
+    while ((rc = next(sc, r)) == RC_OK) {
+        scanned++;
+        memcpy(&i, r->data, sizeof(int));
+        if (i < 0 || i >= numRecords || values[i] == NULL || seen[i]++ > 0
+            || r->id.page != rids[i].page || r->id.slot != rids[i].slot) {
+            wrong++;
+            continue;
+        }
+        expected = testRecord(schema, i, values[i], -i);
+        if (memcmp(expected->data, r->data, getRecordSize(schema)) != 0)
+            wrong++;
+        freeRecord(expected);
+    }
+    if (rc != RC_RM_NO_MORE_TUPLES)
+        TEST_CHECK(rc);
+    TEST_CHECK(closeScan(sc));
+    ASSERT_EQUALS_INT(numPresent, scanned, "the scan returns every record once");
+    ASSERT_EQUALS_INT(0, wrong, "the scan returns the records with their RIDs");
+
+    freeRecord(r);
+    free(seen);
+    free(sc);
+}
+
 
 Schema *
 testSchema(void) {
@@ -734,4 +1059,1818 @@ testRecord(Schema *schema, int a, char *b, int c) {
     freeVal(value);
 
     return result;
-}
\ No newline at end of file
+}
+
+// ************************************************************
+void
+testFreeSpaceMap(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    int numInserts = 8200, freed[] = {5, 8195}, i, rc, scanned = 0, wrong = 0;
+    char *b;
+    Record *r, *expected;
+    RID *rids;
+    Schema *schema, *narrow;
+    testName = "test the free space map pages of a table";
+    // a record takes more than half a page so every record gets its own page, createSchema computes the offsets
+    narrow = testSchema();
+    narrow->typeLength[1] = 2500;
+    schema = createSchema(narrow->numAttr, narrow->attrNames, narrow->dataTypes, narrow->typeLength, narrow->keySize,
+                          narrow->keyAttrs);
+    free(narrow->attrOffsets);
+    free(narrow);
+    b = (char *) malloc(2501);
+    memset(b, 'f', 2500);
+    b[2500] = '\0';
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_f", schema));
+    TEST_CHECK(openTable(table, "test_table_f"));
+    for (i = 0; i < numInserts; i++) {
+        r = testRecord(schema, i, b, i);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+
+    // page 1 maps the 8192 pages after it, page 8194 is the next map page
+    for (i = 0; i < numInserts; i++) {
+        if (rids[i].page != i + 2 + (i >= 8192) || rids[i].slot != 0)
+            wrong++;
+    }
+    ASSERT_EQUALS_INT(0, wrong, "the records fill the data pages around the map pages");
+
+    // the map gives the pages with room again, on both sides of the second map page
+    for (i = 0; i < 2; i++)
+        TEST_CHECK(deleteRecord(table, rids[freed[i]]));
+    for (i = 0; i < 2; i++) {
+        r = testRecord(schema, freed[i], b, freed[i]);
+        TEST_CHECK(insertRecord(table, r));
+        ASSERT_EQUALS_INT(freed[i] + 2 + (freed[i] >= 8192), r->id.page, "the insert goes to the page the map gives");
+        rids[freed[i]] = r->id;
+        freeRecord(r);
+    }
+
+    // the map is kept in the file
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openTable(table, "test_table_f"));
+    TEST_CHECK(deleteRecord(table, rids[8197]));
+    r = testRecord(schema, 8197, b, 8197);
+    TEST_CHECK(insertRecord(table, r));
+    ASSERT_EQUALS_INT(8200, r->id.page, "the search crosses the map page after reopening the table");
+    rids[8197] = r->id;
+    freeRecord(r);
+
+    // the scan skips the map pages
+    TEST_CHECK(createRecord(&r, schema));
+    TEST_CHECK(startScan(table, sc, NULL));
+    while ((rc = next(sc, r)) == RC_OK) {
+        memcpy(&i, r->data, sizeof(int));
+        expected = testRecord(schema, i, b, i);
+        if (i < 0 || i >= numInserts || r->id.page != rids[i].page || r->id.slot != rids[i].slot
+            || memcmp(expected->data, r->data, getRecordSize(schema)) != 0)
+            wrong++;
+        freeRecord(expected);
+        scanned++;
+    }
+    if (rc != RC_RM_NO_MORE_TUPLES)
+        TEST_CHECK(rc);
+    TEST_CHECK(closeScan(sc));
+    ASSERT_EQUALS_INT(numInserts, scanned, "the scan returns every record");
+    ASSERT_EQUALS_INT(0, wrong, "the scan returns the records of the data pages");
+    freeRecord(r);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_f"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    free(sc);
+    free(rids);
+    free(b);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testTwoOpenTables(void) {
+    RM_TableData *tables[2];
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    char *names[] = {"test_table_t1", "test_table_t2"};
+    char *values[] = {"one", "two"};
+    int numInserts[] = {700, 300}, i, t, rc, scanned, wrong = 0;
+    Record *r, *expected;
+    Schema *schema;
+    testName = "test two tables open at the same time";
+    schema = testSchema();
+
+    TEST_CHECK(initRecordManager(NULL));
+    for (t = 0; t < 2; t++) {
+        tables[t] = (RM_TableData *) malloc(sizeof(RM_TableData));
+        TEST_CHECK(createTable(names[t], schema));
+        TEST_CHECK(openTable(tables[t], names[t]));
+    }
+
+    // the inserts alternate between the tables
+    for (i = 0; i < numInserts[0]; i++) {
+        for (t = 0; t < 2; t++) {
+            if (i >= numInserts[t])
+                continue;
+            r = testRecord(schema, i, values[t], t);
+            TEST_CHECK(insertRecord(tables[t], r));
+            freeRecord(r);
+        }
+    }
+    for (t = 0; t < 2; t++)
+        ASSERT_EQUALS_INT(numInserts[t], getNumTuples(tables[t]), "each table counts its own records");
+
+    // a scan of the first table stays on it while the second one changes
+    TEST_CHECK(createRecord(&r, schema));
+    TEST_CHECK(startScan(tables[0], sc, NULL));
+    scanned = 0;
+    while ((rc = next(sc, r)) == RC_OK) {
+        memcpy(&i, r->data, sizeof(int));
+        expected = testRecord(schema, i, values[0], 0);
+        if (memcmp(expected->data, r->data, getRecordSize(schema)) != 0)
+            wrong++;
+        freeRecord(expected);
+        if (scanned % 100 == 0) {
+            expected = testRecord(schema, numInserts[1], values[1], 1);
+            TEST_CHECK(insertRecord(tables[1], expected));
+            numInserts[1]++;
+            freeRecord(expected);
+        }
+        scanned++;
+    }
+    if (rc != RC_RM_NO_MORE_TUPLES)
+        TEST_CHECK(rc);
+    TEST_CHECK(closeScan(sc));
+    ASSERT_EQUALS_INT(numInserts[0], scanned, "the scan returns the records of its table");
+    ASSERT_EQUALS_INT(0, wrong, "the scan returns the records of its table");
+    ASSERT_EQUALS_INT(numInserts[1], getNumTuples(tables[1]), "the second table counts the inserts done meanwhile");
+
+    // closing the first table leaves the second one open
+    TEST_CHECK(closeTable(tables[0]));
+    TEST_CHECK(startScan(tables[1], sc, NULL));
+    scanned = 0;
+    while ((rc = next(sc, r)) == RC_OK) {
+        memcpy(&i, r->data, sizeof(int));
+        expected = testRecord(schema, i, values[1], 1);
+        if (memcmp(expected->data, r->data, getRecordSize(schema)) != 0)
+            wrong++;
+        freeRecord(expected);
+        scanned++;
+    }
+    if (rc != RC_RM_NO_MORE_TUPLES)
+        TEST_CHECK(rc);
+    TEST_CHECK(closeScan(sc));
+    ASSERT_EQUALS_INT(numInserts[1], scanned, "the second table is still usable");
+    ASSERT_EQUALS_INT(0, wrong, "the second table is still usable");
+    freeRecord(r);
+
+    TEST_CHECK(openTable(tables[0], names[0]));
+    ASSERT_EQUALS_INT(numInserts[0], getNumTuples(tables[0]), "the count of the first table is kept");
+    for (t = 0; t < 2; t++) {
+        TEST_CHECK(closeTable(tables[t]));
+        TEST_CHECK(deleteTable(names[t]));
+        free(tables[t]);
+    }
+    TEST_CHECK(shutdownRecordManager());
+
+    free(sc);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testScanPins(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_ScanHandle *scans[5];
+    int numInserts = 2000, numScans = 5, i, k, rc, firstPage, wrong = 0;
+    Record *r;
+    RID *rids;
+    RID beyond, at[5];
+    Schema *schema;
+    testName = "test the page pinned by a scan between calls to next";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_n", schema));
+    TEST_CHECK(openTable(table, "test_table_n"));
+    for (i = 0; i < numInserts; i++) {
+        r = testRecord(schema, i, "nnnn", i);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    firstPage = rids[0].page;
+    ASSERT_TRUE(rids[numInserts - 1].page > firstPage + numScans, "the records take more pages than the pool has frames");
+    for (i = 0; rids[i].page != firstPage + numScans; i++)
+        ;
+    beyond = rids[i];
+
+    // scan k stops on page firstPage + k, the scans keep every frame of the pool pinned
+    TEST_CHECK(createRecord(&r, schema));
+    for (k = 0; k < numScans; k++) {
+        scans[k] = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+        TEST_CHECK(startScan(table, scans[k], NULL));
+        do {
+            TEST_CHECK(next(scans[k], r));
+        } while (r->id.page != firstPage + k);
+        at[k] = r->id;
+    }
+    ASSERT_ERROR(getRecord(table, beyond, r), "no frame is left for another page");
+
+    // closing a scan in the middle of a page releases its pin
+    TEST_CHECK(closeScan(scans[numScans - 1]));
+    TEST_CHECK(getRecord(table, beyond, r));
+    TEST_CHECK(startScan(table, scans[numScans - 1], NULL));
+    do {
+        TEST_CHECK(next(scans[numScans - 1], r));
+    } while (r->id.page != firstPage + numScans - 1);
+    at[numScans - 1] = r->id;
+    ASSERT_ERROR(getRecord(table, beyond, r), "the new scan pins the last frame again");
+
+    // moving to the next page releases the pin of the previous one
+    do {
+        TEST_CHECK(next(scans[0], r));
+    } while (r->id.page != firstPage + 1);
+    at[0] = r->id;
+    TEST_CHECK(getRecord(table, beyond, r));
+
+    // every scan goes on after the record it stopped on
+    for (k = 0; k < numScans; k++) {
+        for (i = 0; rids[i].page != at[k].page || rids[i].slot != at[k].slot; i++)
+            ;
+        while ((rc = next(scans[k], r)) == RC_OK) {
+            i++;
+            if (i >= numInserts || r->id.page != rids[i].page || r->id.slot != rids[i].slot)
+                wrong++;
+        }
+        if (rc != RC_RM_NO_MORE_TUPLES)
+            TEST_CHECK(rc);
+        ASSERT_EQUALS_INT(numInserts - 1, i, "the scan goes on to the last record");
+        TEST_CHECK(closeScan(scans[k]));
+        free(scans[k]);
+    }
+    ASSERT_EQUALS_INT(0, wrong, "the scans return the records in order");
+    freeRecord(r);
+
+    // no pin is left once the scans are closed
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_n"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    free(rids);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testBorrowedRecords(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    RM_BorrowedRecord borrowed;
+    int numInserts = 500, i, length, scanned = 0, wrong = 0;
+    char expected[5];
+    char *value;
+    RID *rids;
+    Schema *schema;
+    Expr *sel, *left, *right;
+    testName = "test reading records in place in their pinned pages";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_b", schema));
+    TEST_CHECK(openTable(table, "test_table_b"));
+    insertNumberedRecords(table, schema, rids, numInserts);
+
+    // c < 1
+    MAKE_CONS(left, stringToValue("i1"));
+    MAKE_ATTRREF(right, 2);
+    MAKE_BINOP_EXPR(sel, right, left, OP_COMP_SMALLER);
+    TEST_CHECK(startScan(table, sc, sel));
+    while (nextBorrowed(sc, &borrowed) == RC_OK) {
+        scanned++;
+        i = getBorrowedInt(&borrowed, 0);
+        sprintf(expected, "r%d", i % 100);
+        value = getBorrowedString(&borrowed, 1, &length);
+        if (i < 0 || i >= numInserts || i % 10 != 0 || borrowed.id.page != rids[i].page
+            || borrowed.id.slot != rids[i].slot || length != (int) strlen(expected)
+            || memcmp(value, expected, length) != 0 || getBorrowedInt(&borrowed, 2) != 0)
+            wrong++;
+    }
+    TEST_CHECK(closeScan(sc));
+    ASSERT_EQUALS_INT(numInserts / 10, scanned, "the scan returns the records matching the condition");
+    ASSERT_EQUALS_INT(0, wrong, "borrowed records read in their pages");
+
+    TEST_CHECK(borrowRecord(table, rids[321], &borrowed));
+    ASSERT_EQUALS_INT(321, getBorrowedInt(&borrowed, 0), "attribute a of a borrowed record");
+    value = getBorrowedString(&borrowed, 1, &length);
+    ASSERT_TRUE(length == 3 && memcmp(value, "r21", 3) == 0, "attribute b of a borrowed record");
+    TEST_CHECK(releaseBorrowedRecord(&borrowed));
+
+    TEST_CHECK(deleteRecord(table, rids[321]));
+    ASSERT_ERROR(borrowRecord(table, rids[321], &borrowed), "a deleted record cannot be borrowed");
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_b"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    free(sc);
+    free(rids);
+    freeExpr(sel);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// record i is testRecord(schema, i, "r<i % 100>", i % 10)
+Record *
+numberedRecord(Schema *schema, int i) {
+    char b[5];
+    sprintf(b, "r%d", i % 100);
+    return testRecord(schema, i, b, i % 10);
+}
+
+void
+insertNumberedRecords(RM_TableData *table, Schema *schema, RID *rids, int numRecords) {
+    Record *r;
+    int i;
+
+    for (i = 0; i < numRecords; i++) {
+        r = numberedRecord(schema, i);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+}
+
+// ************************************************************
+void
+testCompiledPredicates(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    int numInserts = 1000, numConditions = 5, i, k, a, rc, scanned, matching, wrong;
+    char b[5];
+    Record *r;
+    Schema *schema;
+    Value *value;
+    Expr *conds[5], *left, *right, *small, *large, *equal, *floatSmall, *stringSmall, *stringEqual, *constant,
+        *notExpr, *andExpr;
+    testName = "test scans with compiled conditions";
+    schema = testSchema();
+    // c is a float for the comparisons of floats
+    schema->dataTypes[2] = DT_FLOAT;
+
+    // a < 700 AND NOT (a < 200)
+    MAKE_CONS(left, stringToValue("i700"));
+    MAKE_ATTRREF(right, 0);
+    MAKE_BINOP_EXPR(small, right, left, OP_COMP_SMALLER);
+    MAKE_CONS(left, stringToValue("i200"));
+    MAKE_ATTRREF(right, 0);
+    MAKE_BINOP_EXPR(large, right, left, OP_COMP_SMALLER);
+    MAKE_UNOP_EXPR(notExpr, large, OP_BOOL_NOT);
+    MAKE_BINOP_EXPR(conds[0], small, notExpr, OP_BOOL_AND);
+    // a = 5 OR c < 2.5
+    MAKE_CONS(left, stringToValue("i5"));
+    MAKE_ATTRREF(right, 0);
+    MAKE_BINOP_EXPR(equal, right, left, OP_COMP_EQUAL);
+    MAKE_CONS(left, stringToValue("f2.5"));
+    MAKE_ATTRREF(right, 2);
+    MAKE_BINOP_EXPR(floatSmall, right, left, OP_COMP_SMALLER);
+    MAKE_BINOP_EXPR(conds[1], equal, floatSmall, OP_BOOL_OR);
+    // b < "s010"
+    MAKE_CONS(left, stringToValue("ss010"));
+    MAKE_ATTRREF(right, 1);
+    MAKE_BINOP_EXPR(conds[2], right, left, OP_COMP_SMALLER);
+    // NOT (b < "s500") AND c < 200.0
+    MAKE_CONS(left, stringToValue("ss500"));
+    MAKE_ATTRREF(right, 1);
+    MAKE_BINOP_EXPR(stringSmall, right, left, OP_COMP_SMALLER);
+    MAKE_UNOP_EXPR(notExpr, stringSmall, OP_BOOL_NOT);
+    MAKE_CONS(left, stringToValue("f200.0"));
+    MAKE_ATTRREF(right, 2);
+    MAKE_BINOP_EXPR(floatSmall, right, left, OP_COMP_SMALLER);
+    MAKE_BINOP_EXPR(conds[3], notExpr, floatSmall, OP_BOOL_AND);
+    // b = "s123" OR (a = 999 AND TRUE)
+    MAKE_CONS(left, stringToValue("ss123"));
+    MAKE_ATTRREF(right, 1);
+    MAKE_BINOP_EXPR(stringEqual, right, left, OP_COMP_EQUAL);
+    MAKE_CONS(left, stringToValue("i999"));
+    MAKE_ATTRREF(right, 0);
+    MAKE_BINOP_EXPR(equal, right, left, OP_COMP_EQUAL);
+    MAKE_CONS(constant, stringToValue("bt"));
+    MAKE_BINOP_EXPR(andExpr, equal, constant, OP_BOOL_AND);
+    MAKE_BINOP_EXPR(conds[4], stringEqual, andExpr, OP_BOOL_OR);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_k", schema));
+    TEST_CHECK(openTable(table, "test_table_k"));
+    // record i is (i, "s<i>" on 3 digits, i / 4.0)
+    for (i = 0; i < numInserts; i++) {
+        TEST_CHECK(createRecord(&r, schema));
+        MAKE_VALUE(value, DT_INT, i);
+        TEST_CHECK(setAttr(r, schema, 0, value));
+        freeVal(value);
+        sprintf(b, "s%03d", i);
+        MAKE_STRING_VALUE(value, b);
+        TEST_CHECK(setAttr(r, schema, 1, value));
+        freeVal(value);
+        MAKE_VALUE(value, DT_FLOAT, i / 4.0f);
+        TEST_CHECK(setAttr(r, schema, 2, value));
+        freeVal(value);
+        TEST_CHECK(insertRecord(table, r));
+        freeRecord(r);
+    }
+
+    // the values of a are out of the range of a char, the whole int is compared
+    TEST_CHECK(createRecord(&r, schema));
+    for (k = 0; k < numConditions; k++) {
+        matching = 0;
+        for (i = 0; i < numInserts; i++) {
+            if (compiledCondition(k, i))
+                matching++;
+        }
+        scanned = 0;
+        wrong = 0;
+        TEST_CHECK(startScan(table, sc, conds[k]));
+        while ((rc = next(sc, r)) == RC_OK) {
+            memcpy(&a, r->data, sizeof(int));
+            if (!compiledCondition(k, a))
+                wrong++;
+            scanned++;
+        }
+        if (rc != RC_RM_NO_MORE_TUPLES)
+            TEST_CHECK(rc);
+        TEST_CHECK(closeScan(sc));
+        ASSERT_EQUALS_INT(matching, scanned, "the scan returns every record satisfying the condition");
+        ASSERT_EQUALS_INT(0, wrong, "the scan only returns records satisfying the condition");
+    }
+    freeRecord(r);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_k"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    free(sc);
+    for (k = 0; k < numConditions; k++)
+        freeExpr(conds[k]);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// true if record i of testCompiledPredicates satisfies its condition k
+bool
+compiledCondition(int k, int i) {
+    float c = i / 4.0f;
+    switch (k) {
+    case 0:
+        return i < 700 && !(i < 200);
+    case 1:
+        return i == 5 || c < 2.5;
+    case 2:
+        return i < 10;
+    case 3:
+        return !(i < 500) && c < 200.0;
+    default:
+        return i == 123 || i == 999;
+    }
+}
+
+// ************************************************************
+void
+testPageAtATimeScans(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    int numInserts = 2000, numConditions = 3, numMoved = 0, i, j, k, a, rc, scanned, matching, wrong = 0;
+    bool *deleted;
+    Record *r;
+    RID *rids;
+    Schema *schema;
+    Expr *conds[3], *left, *right, *large, *grown, *floatSmall, *floatLarge, *small, *shortString;
+    testName = "test scans evaluating their condition a page at a time";
+    schema = testSchema();
+    // c is a float for the comparisons of floats
+    schema->dataTypes[2] = DT_FLOAT;
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+    deleted = (bool *) calloc(numInserts, sizeof(bool));
+
+    // NOT (a < 1000)
+    MAKE_CONS(left, stringToValue("i1000"));
+    MAKE_ATTRREF(right, 0);
+    MAKE_BINOP_EXPR(large, right, left, OP_COMP_SMALLER);
+    MAKE_UNOP_EXPR(conds[0], large, OP_BOOL_NOT);
+    // b = "gggg" AND NOT (c < 100.0)
+    MAKE_CONS(left, stringToValue("sgggg"));
+    MAKE_ATTRREF(right, 1);
+    MAKE_BINOP_EXPR(grown, right, left, OP_COMP_EQUAL);
+    MAKE_CONS(left, stringToValue("f100.0"));
+    MAKE_ATTRREF(right, 2);
+    MAKE_BINOP_EXPR(floatSmall, right, left, OP_COMP_SMALLER);
+    MAKE_UNOP_EXPR(floatLarge, floatSmall, OP_BOOL_NOT);
+    MAKE_BINOP_EXPR(conds[1], grown, floatLarge, OP_BOOL_AND);
+    // a < 100 OR b < "g"
+    MAKE_CONS(left, stringToValue("i100"));
+    MAKE_ATTRREF(right, 0);
+    MAKE_BINOP_EXPR(small, right, left, OP_COMP_SMALLER);
+    MAKE_CONS(left, stringToValue("sg"));
+    MAKE_ATTRREF(right, 1);
+    MAKE_BINOP_EXPR(shortString, right, left, OP_COMP_SMALLER);
+    MAKE_BINOP_EXPR(conds[2], small, shortString, OP_BOOL_OR);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_a", schema));
+    TEST_CHECK(openTable(table, "test_table_a"));
+    // record i is (i, "", i / 4.0), the shortest records fill the pages
+    TEST_CHECK(createRecord(&r, schema));
+    for (i = 0; i < numInserts; i++) {
+        pageScanRecord(r, schema, i, "");
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+    }
+
+    // every fifth record grows to "gggg" and moves out of its full page, every third record is deleted
+    for (i = 0; i < numInserts; i += 5) {
+        pageScanRecord(r, schema, i, "gggg");
+        r->id = rids[i];
+        TEST_CHECK(updateRecord(table, r));
+    }
+    for (i = 0; i < numInserts; i += 3) {
+        TEST_CHECK(deleteRecord(table, rids[i]));
+        deleted[i] = true;
+    }
+
+    for (k = 0; k < numConditions; k++) {
+        matching = 0;
+        for (i = 0; i < numInserts; i++) {
+            if (!deleted[i] && pageCondition(k, i))
+                matching++;
+        }
+        scanned = 0;
+        TEST_CHECK(startScan(table, sc, conds[k]));
+        while ((rc = next(sc, r)) == RC_OK) {
+            memcpy(&a, r->data, sizeof(int));
+            if (a < 0 || a >= numInserts || deleted[a] || !pageCondition(k, a) || r->id.page != rids[a].page
+                || r->id.slot != rids[a].slot)
+                wrong++;
+            if (a % 5 == 0 && k == 1)
+                numMoved++;
+            scanned++;
+        }
+        if (rc != RC_RM_NO_MORE_TUPLES)
+            TEST_CHECK(rc);
+        TEST_CHECK(closeScan(sc));
+        ASSERT_EQUALS_INT(matching, scanned, "the scan returns every record satisfying the condition");
+    }
+    ASSERT_EQUALS_INT(0, wrong, "the free slots and the forwards are never selected, moved records keep their RIDs");
+    ASSERT_TRUE(numMoved > 0, "moved records are selected");
+
+    // the records of the current page deleted after it was evaluated are skipped
+    TEST_CHECK(startScan(table, sc, conds[0]));
+    TEST_CHECK(next(sc, r));
+    memcpy(&a, r->data, sizeof(int));
+    matching = 0;
+    for (i = 0; i < numInserts; i++) {
+        if (!deleted[i] && pageCondition(0, i))
+            matching++;
+    }
+    for (i = a + 1, j = 0; i < numInserts && j < 10; i++) {
+        if (!deleted[i] && rids[i].page == r->id.page) {
+            TEST_CHECK(deleteRecord(table, rids[i]));
+            deleted[i] = true;
+            matching--;
+            j++;
+        }
+    }
+    ASSERT_EQUALS_INT(10, j, "records of the page of the scan are deleted");
+    scanned = 1;
+    while ((rc = next(sc, r)) == RC_OK) {
+        memcpy(&a, r->data, sizeof(int));
+        if (a < 0 || a >= numInserts || deleted[a])
+            wrong++;
+        scanned++;
+    }
+    if (rc != RC_RM_NO_MORE_TUPLES)
+        TEST_CHECK(rc);
+    TEST_CHECK(closeScan(sc));
+    ASSERT_EQUALS_INT(matching, scanned, "the deleted records are not returned");
+    ASSERT_EQUALS_INT(0, wrong, "the deleted records are not returned");
+    freeRecord(r);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_a"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    free(sc);
+    free(rids);
+    free(deleted);
+    for (k = 0; k < numConditions; k++)
+        freeExpr(conds[k]);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// set r to record i of testPageAtATimeScans, (i, b, i / 4.0)
+void
+pageScanRecord(Record *r, Schema *schema, int i, char *b) {
+    Value *value;
+
+    MAKE_VALUE(value, DT_INT, i);
+    TEST_CHECK(setAttr(r, schema, 0, value));
+    freeVal(value);
+    MAKE_STRING_VALUE(value, b);
+    TEST_CHECK(setAttr(r, schema, 1, value));
+    freeVal(value);
+    MAKE_VALUE(value, DT_FLOAT, i / 4.0f);
+    TEST_CHECK(setAttr(r, schema, 2, value));
+    freeVal(value);
+}
+
+// true if record i of testPageAtATimeScans satisfies its condition k, every fifth record holds "gggg"
+bool
+pageCondition(int k, int i) {
+    bool grown = i % 5 == 0;
+    switch (k) {
+    case 0:
+        return !(i < 1000);
+    case 1:
+        return grown && !(i / 4.0f < 100.0);
+    default:
+        return i < 100 || !grown;
+    }
+}
+
+// ************************************************************
+void
+testAttributeOffsets(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    char *names[] = {"a", "b", "c", "d"};
+    DataType dt[] = {DT_INT, DT_STRING, DT_FLOAT, DT_BOOL};
+    int sizes[] = {0, 5, 0, 0};
+    int offsets[] = {0, 4, 9, 13, 13 + sizeof(bool)};
+    char *values[] = {"i100000", "shello", "f2.5", "bt"};
+    char *serialized[] = {"a:100000", "b:hello", "c:2.500000", "d:TRUE"};
+    int keys[] = {0};
+    int i, round;
+    char **cpNames = (char **) malloc(sizeof(char *) * 4);
+    DataType *cpDt = (DataType *) malloc(sizeof(DataType) * 4);
+    int *cpSizes = (int *) malloc(sizeof(int) * 4);
+    int *cpKeys = (int *) malloc(sizeof(int));
+    char *attr;
+    Schema *schema, *tableSchema, *s;
+    Record *r;
+    RID rid;
+    Value *value;
+    testName = "test attribute offsets cached in the schema";
+
+    for (i = 0; i < 4; i++) {
+        cpNames[i] = (char *) malloc(2);
+        strcpy(cpNames[i], names[i]);
+    }
+    memcpy(cpDt, dt, sizeof(DataType) * 4);
+    memcpy(cpSizes, sizes, sizeof(int) * 4);
+    memcpy(cpKeys, keys, sizeof(int));
+    schema = createSchema(4, cpNames, cpDt, cpSizes, 1, cpKeys);
+    for (i = 0; i <= 4; i++)
+        ASSERT_EQUALS_INT(offsets[i], schema->attrOffsets[i], "createSchema computes the attribute offsets");
+    ASSERT_EQUALS_INT(offsets[4], getRecordSize(schema), "the record size is the last offset");
+
+    // values that do not fit in one byte are read back whole
+    TEST_CHECK(createRecord(&r, schema));
+    for (i = 0; i < 4; i++) {
+        value = stringToValue(values[i]);
+        TEST_CHECK(setAttr(r, schema, i, value));
+        freeVal(value);
+    }
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_o", schema));
+    TEST_CHECK(openTable(table, "test_table_o"));
+    TEST_CHECK(insertRecord(table, r));
+    rid = r->id;
+    TEST_CHECK(closeTable(table));
+
+    // the second round reads the record with the offsets openTable computes for the stored schema
+    TEST_CHECK(openTable(table, "test_table_o"));
+    tableSchema = table->schema;
+    for (i = 0; i <= 4; i++)
+        ASSERT_EQUALS_INT(offsets[i], tableSchema->attrOffsets[i], "openTable computes the attribute offsets");
+    TEST_CHECK(getRecord(table, rid, r));
+    for (round = 0; round < 2; round++) {
+        s = round == 0 ? schema : tableSchema;
+        TEST_CHECK(getAttr(r, s, 0, &value));
+        ASSERT_EQUALS_INT(100000, value->v.intV, "an int attribute is read whole");
+        freeVal(value);
+        TEST_CHECK(getAttr(r, s, 1, &value));
+        ASSERT_EQUALS_STRING("hello", value->v.stringV, "a string attribute is read");
+        freeVal(value);
+        TEST_CHECK(getAttr(r, s, 2, &value));
+        ASSERT_TRUE(value->v.floatV == 2.5f, "a float attribute is read whole");
+        freeVal(value);
+        TEST_CHECK(getAttr(r, s, 3, &value));
+        ASSERT_TRUE(value->v.boolV, "a bool attribute is read");
+        freeVal(value);
+        for (i = 0; i < 4; i++) {
+            attr = serializeAttr(r, s, i);
+            ASSERT_EQUALS_STRING(serialized[i], attr, "the serializer finds the attribute at its offset");
+            free(attr);
+        }
+    }
+    freeRecord(r);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_o"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testInsertRecords(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    int numInserts = 5000, numSingle = 300, i, wrong = 0;
+    Record **records;
+    Record *r;
+    Schema *schema;
+    testName = "test inserting records in bulk";
+    schema = testSchema();
+    records = (Record **) malloc(sizeof(Record *) * numInserts);
+    for (i = 0; i < numInserts; i++)
+        records[i] = numberedRecord(schema, i);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_i", schema));
+    TEST_CHECK(openTable(table, "test_table_i"));
+
+    // the bulk insert fills the free slots left by the deletes too
+    for (i = 0; i < numSingle; i++)
+        TEST_CHECK(insertRecord(table, records[i]));
+    for (i = 0; i < numSingle; i += 3)
+        TEST_CHECK(deleteRecord(table, records[i]->id));
+    TEST_CHECK(insertRecords(table, records + numSingle, numInserts - numSingle));
+    ASSERT_EQUALS_INT(numInserts - numSingle / 3, getNumTuples(table), "number of tuples after the bulk insert");
+    ASSERT_TRUE(records[numSingle]->id.page == records[0]->id.page
+                && records[numSingle]->id.slot == records[0]->id.slot,
+                "the first record inserted in bulk takes the first free slot");
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openTable(table, "test_table_i"));
+    ASSERT_EQUALS_INT(numInserts - numSingle / 3, getNumTuples(table), "number of tuples after reopening");
+    TEST_CHECK(createRecord(&r, schema));
+    for (i = numSingle; i < numInserts; i++) {
+        TEST_CHECK(getRecord(table, records[i]->id, r));
+        if (memcmp(records[i]->data, r->data, getRecordSize(schema)) != 0)
+            wrong++;
+    }
+    ASSERT_EQUALS_INT(0, wrong, "the records inserted in bulk are found at their RIDs");
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_i"));
+    TEST_CHECK(shutdownRecordManager());
+
+    for (i = 0; i < numInserts; i++)
+        freeRecord(records[i]);
+    freeRecord(r);
+    free(records);
+    free(table);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testPaxTable(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    int numInserts = 3000, i, rc, scanned = 0, numExpected = 0, wrong = 0;
+    Record *r;
+    RID *rids;
+    char **values;
+    Schema *schema;
+    Value *value;
+    Expr *sel, *left, *right;
+    testName = "test a table with the PAX page layout";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+    values = (char **) calloc(numInserts, sizeof(char *));
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTableWithFormat("test_table_p", schema, RM_FORMAT_PAX));
+    TEST_CHECK(openTable(table, "test_table_p"));
+
+    for (i = 0; i < numInserts; i++) {
+        values[i] = i % 2 ? "pp" : "pppp";
+        r = testRecord(schema, i, values[i], -i);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    for (i = 0; i < numInserts; i += 7) {
+        TEST_CHECK(deleteRecord(table, rids[i]));
+        values[i] = NULL;
+    }
+    for (i = 1; i < numInserts; i += 11) {
+        if (values[i] == NULL)
+            continue;
+        values[i] = "u";
+        r = testRecord(schema, i, values[i], -i);
+        r->id = rids[i];
+        TEST_CHECK(updateRecord(table, r));
+        freeRecord(r);
+    }
+    checkGrownRecords(table, schema, rids, values, numInserts);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openTable(table, "test_table_p"));
+    checkGrownRecords(table, schema, rids, values, numInserts);
+
+    // b = "u", the condition is evaluated column by column
+    for (i = 0; i < numInserts; i++)
+        if (values[i] != NULL && strcmp(values[i], "u") == 0)
+            numExpected++;
+    MAKE_CONS(left, stringToValue("su"));
+    MAKE_ATTRREF(right, 1);
+    MAKE_BINOP_EXPR(sel, right, left, OP_COMP_EQUAL);
+    TEST_CHECK(createRecord(&r, schema));
+    TEST_CHECK(startScan(table, sc, sel));
+    while ((rc = next(sc, r)) == RC_OK) {
+        scanned++;
+        TEST_CHECK(getAttr(r, schema, 0, &value));
+        if (value->v.intV % 11 != 1)
+            wrong++;
+        freeVal(value);
+    }
+    if (rc != RC_RM_NO_MORE_TUPLES)
+        TEST_CHECK(rc);
+    TEST_CHECK(closeScan(sc));
+    ASSERT_EQUALS_INT(numExpected, scanned, "the scan returns the updated records");
+    ASSERT_EQUALS_INT(0, wrong, "the scan returns only the updated records");
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_p"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeRecord(r);
+    free(table);
+    free(sc);
+    free(rids);
+    free(values);
+    freeExpr(sel);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testProjectedScans(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    RM_TableFormat formats[] = {RM_FORMAT_ROW, RM_FORMAT_PAX};
+    int numInserts = 1000, f, rc, scanned, wrong;
+    int attrs[] = {0, 2};
+    int badAttrs[] = {3};
+    Record *r;
+    RID *rids;
+    Schema *schema;
+    Value *a, *b, *c;
+    Expr *sel, *left, *right;
+    testName = "test scans copying only some attributes";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    // a < 100
+    MAKE_CONS(left, stringToValue("i100"));
+    MAKE_ATTRREF(right, 0);
+    MAKE_BINOP_EXPR(sel, right, left, OP_COMP_SMALLER);
+
+    TEST_CHECK(initRecordManager(NULL));
+    for (f = 0; f < 2; f++) {
+        TEST_CHECK(createTableWithFormat("test_table_j", schema, formats[f]));
+        TEST_CHECK(openTable(table, "test_table_j"));
+        insertNumberedRecords(table, schema, rids, numInserts);
+
+        // b is not copied, it keeps its value
+        r = testRecord(schema, -1, "zzzz", -1);
+        scanned = 0;
+        wrong = 0;
+        TEST_CHECK(startProjectedScan(table, sc, sel, attrs, 2));
+        while ((rc = next(sc, r)) == RC_OK) {
+            scanned++;
+            TEST_CHECK(getAttr(r, schema, 0, &a));
+            TEST_CHECK(getAttr(r, schema, 1, &b));
+            TEST_CHECK(getAttr(r, schema, 2, &c));
+            if (a->v.intV < 0 || a->v.intV >= 100 || c->v.intV != a->v.intV % 10 || strcmp(b->v.stringV, "zzzz") != 0)
+                wrong++;
+            freeVal(a);
+            freeVal(b);
+            freeVal(c);
+        }
+        if (rc != RC_RM_NO_MORE_TUPLES)
+            TEST_CHECK(rc);
+        TEST_CHECK(closeScan(sc));
+        ASSERT_EQUALS_INT(100, scanned, "the projected scan returns the records matching the condition");
+        ASSERT_EQUALS_INT(0, wrong, "only the projected attributes are copied");
+        ASSERT_ERROR(startProjectedScan(table, sc, NULL, badAttrs, 1), "projecting an unknown attribute");
+
+        freeRecord(r);
+        TEST_CHECK(closeTable(table));
+        TEST_CHECK(deleteTable("test_table_j"));
+    }
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    free(sc);
+    free(rids);
+    freeExpr(sel);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testParallelScan(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    int numInserts = 5000, numThreads = 4, i, j, t, scanned = 0, wrong = 0;
+    int *seen = (int *) calloc(numInserts, sizeof(int));
+    RM_ScanOutput outputs[4];
+    Record *r, *expected;
+    RID *rids;
+    Schema *schema;
+    Value *value;
+    Expr *sel, *left, *right;
+    testName = "test scanning a table with several threads";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_l", schema));
+    TEST_CHECK(openTable(table, "test_table_l"));
+    insertNumberedRecords(table, schema, rids, numInserts);
+    // records growing out of their full page are returned under their RID
+    for (i = 3; i < numInserts; i += 100) {
+        r = testRecord(schema, i, "gggg", 3);
+        r->id = rids[i];
+        TEST_CHECK(updateRecord(table, r));
+        freeRecord(r);
+    }
+
+    // c = 3
+    MAKE_CONS(left, stringToValue("i3"));
+    MAKE_ATTRREF(right, 2);
+    MAKE_BINOP_EXPR(sel, right, left, OP_COMP_EQUAL);
+    TEST_CHECK(parallelScan(table, sel, numThreads, outputs));
+
+    TEST_CHECK(createRecord(&r, schema));
+    for (t = 0; t < numThreads; t++) {
+        for (j = 0; j < outputs[t].numberOfRecords; j++) {
+            scanned++;
+            memcpy(r->data, outputs[t].data + (size_t) j * getRecordSize(schema), getRecordSize(schema));
+            TEST_CHECK(getAttr(r, schema, 0, &value));
+            i = value->v.intV;
+            freeVal(value);
+            if (i < 0 || i >= numInserts || i % 10 != 3 || seen[i]++ > 0
+                || outputs[t].ids[j].page != rids[i].page || outputs[t].ids[j].slot != rids[i].slot) {
+                wrong++;
+                continue;
+            }
+            expected = i % 100 == 3 ? testRecord(schema, i, "gggg", 3) : numberedRecord(schema, i);
+            if (memcmp(expected->data, r->data, getRecordSize(schema)) != 0)
+                wrong++;
+            freeRecord(expected);
+        }
+        freeScanOutput(&outputs[t]);
+    }
+    ASSERT_EQUALS_INT(numInserts / 10, scanned, "the threads together return every matching record once");
+    ASSERT_EQUALS_INT(0, wrong, "the threads return the records with their RIDs");
+
+    // the whole table, without a condition
+    TEST_CHECK(parallelScan(table, NULL, numThreads, outputs));
+    scanned = 0;
+    for (t = 0; t < numThreads; t++) {
+        scanned += outputs[t].numberOfRecords;
+        freeScanOutput(&outputs[t]);
+    }
+    ASSERT_EQUALS_INT(numInserts, scanned, "the threads return every record without a condition");
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_l"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeRecord(r);
+    free(table);
+    free(rids);
+    free(seen);
+    freeExpr(sel);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testZoneMaps(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    int numInserts = 3000, i, round;
+    Record *r;
+    RID *rids;
+    Schema *schema;
+    Value *value;
+    Expr *small, *equal, *large, *notSmall, *moved, *negative, *left, *right;
+    testName = "test scans skipping pages with the zone maps";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    // a < 100, a = 1234, NOT (a < 2900), a = 50000, a < 0
+    MAKE_CONS(left, stringToValue("i100"));
+    MAKE_ATTRREF(right, 0);
+    MAKE_BINOP_EXPR(small, right, left, OP_COMP_SMALLER);
+    MAKE_CONS(left, stringToValue("i1234"));
+    MAKE_ATTRREF(right, 0);
+    MAKE_BINOP_EXPR(equal, right, left, OP_COMP_EQUAL);
+    MAKE_CONS(left, stringToValue("i2900"));
+    MAKE_ATTRREF(right, 0);
+    MAKE_BINOP_EXPR(large, right, left, OP_COMP_SMALLER);
+    MAKE_UNOP_EXPR(notSmall, large, OP_BOOL_NOT);
+    MAKE_CONS(left, stringToValue("i50000"));
+    MAKE_ATTRREF(right, 0);
+    MAKE_BINOP_EXPR(moved, right, left, OP_COMP_EQUAL);
+    MAKE_CONS(left, stringToValue("i0"));
+    MAKE_ATTRREF(right, 0);
+    MAKE_BINOP_EXPR(negative, right, left, OP_COMP_SMALLER);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_z", schema));
+    TEST_CHECK(openTable(table, "test_table_z"));
+
+    // a grows with the pages, most of them are out of the range of a condition
+    insertNumberedRecords(table, schema, rids, numInserts);
+    ASSERT_EQUALS_INT(100, countScan(table, small), "a < 100 on the first pages");
+    ASSERT_EQUALS_INT(1, countScan(table, equal), "a = 1234 on one page");
+    ASSERT_EQUALS_INT(100, countScan(table, notSmall), "NOT (a < 2900) on the last pages");
+
+    // the zone of a page widens with the values updated or inserted, a delete does not narrow it
+    TEST_CHECK(createRecord(&r, schema));
+    TEST_CHECK(getRecord(table, rids[5], r));
+    MAKE_VALUE(value, DT_INT, 50000);
+    TEST_CHECK(setAttr(r, schema, 0, value));
+    freeVal(value);
+    TEST_CHECK(updateRecord(table, r));
+    for (i = 10; i < 20; i++)
+        TEST_CHECK(deleteRecord(table, rids[i]));
+    freeRecord(r);
+    r = testRecord(schema, -7, "neg", 3);
+    TEST_CHECK(insertRecord(table, r));
+    freeRecord(r);
+    // records growing out of their page widen the zone of the page they move to
+    for (i = 2000; i < 2010; i++) {
+        r = testRecord(schema, -3, "gggg", 0);
+        r->id = rids[i];
+        TEST_CHECK(updateRecord(table, r));
+        freeRecord(r);
+    }
+
+    // the zones are only in memory, after reopening the first scan rebuilds them and the second one uses them
+    for (round = 0; round < 3; round++) {
+        ASSERT_EQUALS_INT(100, countScan(table, small), "a < 100 with the inserts, without the update and the deletes");
+        ASSERT_EQUALS_INT(1, countScan(table, moved), "a = 50000 after the update");
+        ASSERT_EQUALS_INT(11, countScan(table, negative), "a < 0 after the insert and the grown records");
+        ASSERT_EQUALS_INT(101, countScan(table, notSmall), "NOT (a < 2900) with the update");
+        if (round == 0) {
+            TEST_CHECK(closeTable(table));
+            TEST_CHECK(openTable(table, "test_table_z"));
+        }
+    }
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_z"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    free(rids);
+    freeExpr(small);
+    freeExpr(equal);
+    freeExpr(notSmall);
+    freeExpr(moved);
+    freeExpr(negative);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// number of records of the table satisfying cond
+int
+countScan(RM_TableData *table, Expr *cond) {
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    int rc, scanned = 0;
+    Record *r;
+
+    TEST_CHECK(createRecord(&r, table->schema));
+    TEST_CHECK(startScan(table, sc, cond));
+    while ((rc = next(sc, r)) == RC_OK)
+        scanned++;
+    if (rc != RC_RM_NO_MORE_TUPLES)
+        TEST_CHECK(rc);
+    TEST_CHECK(closeScan(sc));
+
+    freeRecord(r);
+    free(sc);
+    return scanned;
+}
+
+// ************************************************************
+void
+testSelectivityEstimates(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    int numInserts = 5000, numConds = 4, k, round;
+    double actual[] = {0.2, 0.1, 0.02, 0.8};
+    double estimate;
+    RID *rids;
+    Schema *schema;
+    Expr *conds[4], *small, *equal, *left, *right;
+    testName = "test estimating the selectivity of conditions with the statistics of a table";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    // a < 1000, c = 3, a < 1000 AND c = 3, NOT (a < 1000)
+    MAKE_CONS(left, stringToValue("i1000"));
+    MAKE_ATTRREF(right, 0);
+    MAKE_BINOP_EXPR(conds[0], right, left, OP_COMP_SMALLER);
+    MAKE_CONS(left, stringToValue("i3"));
+    MAKE_ATTRREF(right, 2);
+    MAKE_BINOP_EXPR(conds[1], right, left, OP_COMP_EQUAL);
+    MAKE_CONS(left, stringToValue("i1000"));
+    MAKE_ATTRREF(right, 0);
+    MAKE_BINOP_EXPR(small, right, left, OP_COMP_SMALLER);
+    MAKE_CONS(left, stringToValue("i3"));
+    MAKE_ATTRREF(right, 2);
+    MAKE_BINOP_EXPR(equal, right, left, OP_COMP_EQUAL);
+    MAKE_BINOP_EXPR(conds[2], small, equal, OP_BOOL_AND);
+    MAKE_CONS(left, stringToValue("i1000"));
+    MAKE_ATTRREF(right, 0);
+    MAKE_BINOP_EXPR(small, right, left, OP_COMP_SMALLER);
+    MAKE_UNOP_EXPR(conds[3], small, OP_BOOL_NOT);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_e", schema));
+    TEST_CHECK(openTable(table, "test_table_e"));
+    insertNumberedRecords(table, schema, rids, numInserts);
+
+    // default selectivities without statistics
+    for (k = 0; k < numConds; k++) {
+        estimate = estimateSelectivity(table, conds[k]);
+        ASSERT_TRUE(estimate >= 0 && estimate <= 1, "default selectivity");
+    }
+
+    // all the pages, a sample of the pages, then the statistics written in the table read back
+    for (round = 0; round < 3; round++) {
+        if (round == 0) {
+            TEST_CHECK(analyzeTable(table, 0));
+        } else if (round == 1) {
+            TEST_CHECK(analyzeTable(table, 10));
+        } else {
+            TEST_CHECK(closeTable(table));
+            TEST_CHECK(openTable(table, "test_table_e"));
+        }
+        for (k = 0; k < numConds; k++) {
+            estimate = estimateSelectivity(table, conds[k]);
+            ASSERT_TRUE(fabs(estimate - actual[k]) < 0.05, "estimated selectivity close to the actual one");
+        }
+    }
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_e"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    free(rids);
+    for (k = 0; k < numConds; k++)
+        freeExpr(conds[k]);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testSampleScans(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    int numInserts = 20000, seed, i, rc, scanned, wrong;
+    int sampled[2];
+    char *seen[2];
+    double estimate;
+    Record *r;
+    RID *rids;
+    Schema *schema;
+    Value *value;
+    Expr *sel, *left, *right;
+    testName = "test scans reading a sample of the table";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_s", schema));
+    TEST_CHECK(openTable(table, "test_table_s"));
+    insertNumberedRecords(table, schema, rids, numInserts);
+
+    // the fractions are probabilities in (0, 1]
+    ASSERT_EQUALS_INT(RC_RM_INVALID_SAMPLE_FRACTION, startSampleScan(table, sc, NULL, 0, 1, 1), "page fraction 0");
+    ASSERT_EQUALS_INT(RC_RM_INVALID_SAMPLE_FRACTION, startSampleScan(table, sc, NULL, 1.5, 1, 1), "page fraction 1.5");
+    ASSERT_EQUALS_INT(RC_RM_INVALID_SAMPLE_FRACTION, startSampleScan(table, sc, NULL, 0.5, 0, 1), "record fraction 0");
+    ASSERT_EQUALS_INT(RC_RM_INVALID_SAMPLE_FRACTION, startSampleScan(table, sc, NULL, 0.5, -1, 1),
+                      "record fraction -1");
+
+    TEST_CHECK(startSampleScan(table, sc, NULL, 1, 1, 1));
+    scanned = 0;
+    TEST_CHECK(createRecord(&r, schema));
+    while ((rc = next(sc, r)) == RC_OK)
+        scanned++;
+    if (rc != RC_RM_NO_MORE_TUPLES)
+        TEST_CHECK(rc);
+    TEST_CHECK(closeScan(sc));
+    ASSERT_EQUALS_INT(numInserts, scanned, "fractions 1 return the whole table");
+
+    // c < 3, the count of the sample scaled by the fractions estimates the one of the table. Whole pages are left out,
+    // the estimate varies with the seed by up to a third.
+    MAKE_CONS(left, stringToValue("i3"));
+    MAKE_ATTRREF(right, 2);
+    MAKE_BINOP_EXPR(sel, right, left, OP_COMP_SMALLER);
+    for (seed = 0; seed < 2; seed++) {
+        seen[seed] = (char *) calloc(numInserts, sizeof(char));
+        sampled[seed] = 0;
+        wrong = 0;
+        TEST_CHECK(startSampleScan(table, sc, sel, 0.5, 0.5, seed + 1));
+        while ((rc = next(sc, r)) == RC_OK) {
+            sampled[seed]++;
+            TEST_CHECK(getAttr(r, schema, 0, &value));
+            i = value->v.intV;
+            freeVal(value);
+            if (i < 0 || i >= numInserts || i % 10 >= 3 || seen[seed][i]++ > 0)
+                wrong++;
+        }
+        if (rc != RC_RM_NO_MORE_TUPLES)
+            TEST_CHECK(rc);
+        TEST_CHECK(closeScan(sc));
+        ASSERT_EQUALS_INT(0, wrong, "the sample holds records satisfying the condition once");
+        estimate = sampled[seed] / (0.5 * 0.5);
+        ASSERT_TRUE(estimate > 0.7 * numInserts * 0.3 && estimate < 1.3 * numInserts * 0.3,
+                    "estimated number of records satisfying the condition");
+    }
+    ASSERT_TRUE(sampled[0] != sampled[1] || memcmp(seen[0], seen[1], numInserts) != 0,
+                "another seed gives another sample");
+
+    // the same seed gives the same sample
+    scanned = 0;
+    wrong = 0;
+    TEST_CHECK(startSampleScan(table, sc, sel, 0.5, 0.5, 1));
+    while ((rc = next(sc, r)) == RC_OK) {
+        scanned++;
+        TEST_CHECK(getAttr(r, schema, 0, &value));
+        if (!seen[0][value->v.intV])
+            wrong++;
+        freeVal(value);
+    }
+    if (rc != RC_RM_NO_MORE_TUPLES)
+        TEST_CHECK(rc);
+    TEST_CHECK(closeScan(sc));
+    ASSERT_EQUALS_INT(sampled[0], scanned, "same seed, same number of records");
+    ASSERT_EQUALS_INT(0, wrong, "same seed, same records");
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_s"));
+    TEST_CHECK(shutdownRecordManager());
+
+    freeRecord(r);
+    free(table);
+    free(sc);
+    free(rids);
+    free(seen[0]);
+    free(seen[1]);
+    freeExpr(sel);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testVacuumTable(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    SM_FileHandle fh;
+    int numInserts = 5000, numPagesBefore, numMoves, i, k, found, wrong = 0;
+    RM_RecordMove *moves;
+    Record *r;
+    RID *rids;
+    char **values;
+    Schema *schema;
+    testName = "test vacuuming a table: records move to the first pages and the file is cut";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+    values = (char **) calloc(numInserts, sizeof(char *));
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_v", schema));
+    TEST_CHECK(openTable(table, "test_table_v"));
+    for (i = 0; i < numInserts; i++) {
+        values[i] = i % 2 ? "vv" : "vvvv";
+        r = testRecord(schema, i, values[i], -i);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    // records growing out of their full page move to the last pages, the vacuum moves them again under the same RID
+    for (i = 5; i < numInserts; i += 10) {
+        values[i] = "vvvv";
+        r = testRecord(schema, i, values[i], -i);
+        r->id = rids[i];
+        TEST_CHECK(updateRecord(table, r));
+        freeRecord(r);
+    }
+    // a record in five is left on every page
+    for (i = 0; i < numInserts; i++) {
+        if (i % 5 != 0) {
+            TEST_CHECK(deleteRecord(table, rids[i]));
+            values[i] = NULL;
+        }
+    }
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openPageFile("test_table_v", &fh));
+    numPagesBefore = fh.totalNumPages;
+    TEST_CHECK(closePageFile(&fh));
+
+    TEST_CHECK(openTable(table, "test_table_v"));
+    TEST_CHECK(vacuumTable(table, &moves, &numMoves));
+    ASSERT_TRUE(numMoves > 0, "records of the last pages moved");
+    for (k = 0; k < numMoves; k++) {
+        found = 0;
+        for (i = 0; i < numInserts; i++) {
+            if (values[i] != NULL && rids[i].page == moves[k].from.page && rids[i].slot == moves[k].from.slot) {
+                rids[i] = moves[k].to;
+                found++;
+            }
+        }
+        if (found != 1 || moves[k].to.page >= moves[k].from.page)
+            wrong++;
+    }
+    free(moves);
+    ASSERT_EQUALS_INT(0, wrong, "every move takes a record to an earlier page");
+    checkGrownRecords(table, schema, rids, values, numInserts);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openPageFile("test_table_v", &fh));
+    ASSERT_TRUE(fh.totalNumPages < numPagesBefore, "the empty pages at the end of the file are cut");
+    TEST_CHECK(closePageFile(&fh));
+
+    // the records are intact after reopening and the table can grow again
+    TEST_CHECK(openTable(table, "test_table_v"));
+    checkGrownRecords(table, schema, rids, values, numInserts);
+    for (i = 1; i < numInserts; i += 5) {
+        values[i] = "new";
+        r = testRecord(schema, i, values[i], -i);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    checkGrownRecords(table, schema, rids, values, numInserts);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_v"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    free(rids);
+    free(values);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testDictionaryEncoding(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_TableFormat formats[] = {RM_FORMAT_ROW, RM_FORMAT_PAX};
+    bool dictionaryEncoded[] = {false, true, false};
+    char *names[] = {"aa", "bb", "cc", "dd", ""};
+    int numInserts = 3000, f, i;
+    Record *r;
+    RID *rids;
+    RID id;
+    char **values;
+    char value[5], *last = "fffe";
+    Schema *schema;
+    Expr *sel, *left, *right;
+    testName = "test dictionary encoded string attributes";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+    values = (char **) calloc(numInserts, sizeof(char *));
+
+    // b = "cc"
+    MAKE_CONS(left, stringToValue("scc"));
+    MAKE_ATTRREF(right, 1);
+    MAKE_BINOP_EXPR(sel, right, left, OP_COMP_EQUAL);
+
+    TEST_CHECK(initRecordManager(NULL));
+    for (f = 0; f < 2; f++) {
+        TEST_CHECK(createTableWithDictionaries("test_table_d", schema, formats[f], dictionaryEncoded));
+        TEST_CHECK(openTable(table, "test_table_d"));
+        for (i = 0; i < numInserts; i++) {
+            values[i] = names[i % 5];
+            r = testRecord(schema, i, values[i], -i);
+            TEST_CHECK(insertRecord(table, r));
+            rids[i] = r->id;
+            freeRecord(r);
+        }
+        checkGrownRecords(table, schema, rids, values, numInserts);
+        ASSERT_EQUALS_INT(numInserts / 5, countScan(table, sel), "condition on the encoded attribute");
+
+        // the dictionary is written with the table and read back when it is opened
+        TEST_CHECK(closeTable(table));
+        TEST_CHECK(openTable(table, "test_table_d"));
+        checkGrownRecords(table, schema, rids, values, numInserts);
+
+        // new values get new codes
+        for (i = 2; i < numInserts; i += 5) {
+            values[i] = i % 2 ? "ee" : "ffff";
+            r = testRecord(schema, i, values[i], -i);
+            r->id = rids[i];
+            TEST_CHECK(updateRecord(table, r));
+            freeRecord(r);
+        }
+        ASSERT_EQUALS_INT(0, countScan(table, sel), "no record uses the value anymore");
+        TEST_CHECK(closeTable(table));
+        TEST_CHECK(openTable(table, "test_table_d"));
+        checkGrownRecords(table, schema, rids, values, numInserts);
+
+        TEST_CHECK(closeTable(table));
+        TEST_CHECK(deleteTable("test_table_d"));
+    }
+
+    // a dictionary holds 65535 strings, the code 0xFFFF is never given
+    TEST_CHECK(createTableWithDictionaries("test_table_d", schema, RM_FORMAT_ROW, dictionaryEncoded));
+    TEST_CHECK(openTable(table, "test_table_d"));
+    r = testRecord(schema, 0, "0000", 0);
+    TEST_CHECK(insertRecord(table, r));
+    id = r->id;
+    freeRecord(r);
+    for (i = 1; i <= 0xFFFF; i++) {
+        sprintf(value, "%04x", i);
+        r = testRecord(schema, 0, value, 0);
+        r->id = id;
+        if (i < 0xFFFF) {
+            TEST_CHECK(updateRecord(table, r));
+        } else {
+            ASSERT_EQUALS_INT(RC_RM_DICTIONARY_FULL, updateRecord(table, r), "no code is left for the 65536th string");
+        }
+        freeRecord(r);
+    }
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openTable(table, "test_table_d"));
+    checkGrownRecords(table, schema, &id, &last, 1);
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_d"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    free(rids);
+    free(values);
+    freeExpr(sel);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testCompressTable(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    SM_FileHandle fh;
+    int numInserts = 5000, i, status;
+    long plainSize;
+    pid_t pid;
+    Record *r;
+    RID *rids;
+    char **values;
+    Schema *schema;
+    testName = "test a compressed table";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+    values = (char **) calloc(numInserts, sizeof(char *));
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_c", schema));
+    TEST_CHECK(openTable(table, "test_table_c"));
+    for (i = 0; i < numInserts; i++) {
+        values[i] = "cccc";
+        r = testRecord(schema, i, values[i], -i);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    TEST_CHECK(closeTable(table));
+
+    // the table must be closed
+    TEST_CHECK(openPageFile("test_table_c", &fh));
+    plainSize = getFileSize(&fh);
+    TEST_CHECK(closePageFile(&fh));
+    TEST_CHECK(compressTable("test_table_c"));
+    TEST_CHECK(openPageFile("test_table_c", &fh));
+    ASSERT_TRUE(getFileSize(&fh) < plainSize, "the compressed table is smaller");
+    TEST_CHECK(closePageFile(&fh));
+
+    TEST_CHECK(openTable(table, "test_table_c"));
+    checkGrownRecords(table, schema, rids, values, numInserts);
+
+    // the pages written after the compression, the new ones too
+    for (i = 0; i < numInserts; i += 3) {
+        TEST_CHECK(deleteRecord(table, rids[i]));
+        values[i] = NULL;
+    }
+    for (i = 1; i < numInserts; i += 3) {
+        values[i] = "u";
+        r = testRecord(schema, i, values[i], -i);
+        r->id = rids[i];
+        TEST_CHECK(updateRecord(table, r));
+        freeRecord(r);
+    }
+    for (i = 0; i < numInserts; i += 3) {
+        values[i] = "new";
+        r = testRecord(schema, i, values[i], -i);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    checkGrownRecords(table, schema, rids, values, numInserts);
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openTable(table, "test_table_c"));
+    checkGrownRecords(table, schema, rids, values, numInserts);
+    TEST_CHECK(closeTable(table));
+
+    // the child evicts pages of the compressed table and stops without closing it, the file is still readable
+    for (i = 2; i < numInserts; i += 3) {
+        values[i] = "a longer string grown out of its page";
+    }
+    fflush(stdout);
+    pid = fork();
+    if (pid == 0) {
+        bool failed = openTable(table, "test_table_c") != RC_OK;
+        for (i = 2; i < numInserts && !failed; i += 3) {
+            r = testRecord(schema, i, values[i], -i);
+            r->id = rids[i];
+            failed = updateRecord(table, r) != RC_OK;
+            freeRecord(r);
+        }
+        if (!failed) {
+            failed = commitTable(table) != RC_OK;
+        }
+        _exit(failed ? 1 : 0);
+    }
+    ASSERT_TRUE(pid > 0, "the process is forked");
+    ASSERT_TRUE(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0,
+                "the changes are committed");
+    TEST_CHECK(openTable(table, "test_table_c"));
+    checkGrownRecords(table, schema, rids, values, numInserts);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_c"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    free(rids);
+    free(values);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testWriteAheadLog(void) {
+    WAL_Log log;
+    WAL_Record record;
+    WAL_LSN lsns[10], position, base;
+    SM_FileHandle fh;
+    char data[8];
+    int i;
+    testName = "test the write-ahead log";
+
+    destroyPageFile("test_table_w.wal");
+    TEST_CHECK(openLog(&log, "test_table_w.wal"));
+    ASSERT_TRUE(log.nextLSN == 0, "a new log is empty");
+    for (i = 0; i < 10; i++) {
+        sprintf(data, "rec%d", i);
+        lsns[i] = appendLogRecord(&log, WAL_UPDATE, i + 1, i, data, i % 2 == 0 ? (int) strlen(data) + 1 : 0);
+        ASSERT_TRUE(i == 0 || lsns[i] > lsns[i - 1], "the LSNs grow");
+    }
+    TEST_CHECK(flushLog(&log, lsns[9]));
+    ASSERT_TRUE(log.durableLSN == lsns[9], "the flushed records are durable");
+
+    position = log.base;
+    for (i = 0; i < 10; i++) {
+        TEST_CHECK(readLogRecord(&log, &position, &record));
+        ASSERT_TRUE(record.lsn == lsns[i], "the record ends at its LSN");
+        ASSERT_EQUALS_INT(WAL_UPDATE, record.type, "type of the record");
+        ASSERT_EQUALS_INT(i + 1, record.page, "page of the record");
+        ASSERT_EQUALS_INT(i, record.slot, "slot of the record");
+        if (i % 2 == 0) {
+            sprintf(data, "rec%d", i);
+            ASSERT_EQUALS_STRING(data, record.data, "data of the record");
+        }
+        else {
+            ASSERT_TRUE(record.data == NULL, "a record without data");
+        }
+        free(record.data);
+    }
+    ASSERT_ERROR(readLogRecord(&log, &position, &record), "no record after the last one");
+    TEST_CHECK(closeLog(&log));
+
+    // a torn last record
+    TEST_CHECK(openPageFile("test_table_w.wal", &fh));
+    TEST_CHECK(truncateBytes(getFileSize(&fh) - 3, &fh));
+    TEST_CHECK(closePageFile(&fh));
+    TEST_CHECK(openLog(&log, "test_table_w.wal"));
+    ASSERT_TRUE(log.nextLSN == lsns[8], "the log ends after the last complete record");
+    sprintf(data, "again");
+    lsns[9] = appendLogRecord(&log, WAL_INSERT, 10, 9, data, (int) strlen(data) + 1);
+    TEST_CHECK(closeLog(&log));
+    TEST_CHECK(openLog(&log, "test_table_w.wal"));
+    position = lsns[8];
+    TEST_CHECK(readLogRecord(&log, &position, &record));
+    ASSERT_EQUALS_INT(WAL_INSERT, record.type, "the record appended after the torn one");
+    ASSERT_EQUALS_STRING("again", record.data, "data of the record appended after the torn one");
+    free(record.data);
+
+    // the LSNs keep growing after a reset
+    base = log.nextLSN;
+    TEST_CHECK(resetLog(&log, base));
+    position = base;
+    ASSERT_ERROR(readLogRecord(&log, &position, &record), "a reset log is empty");
+    lsns[0] = appendLogRecord(&log, WAL_DELETE, 1, 0, NULL, 0);
+    ASSERT_TRUE(lsns[0] > base, "the LSNs grow after a reset");
+    TEST_CHECK(closeLog(&log));
+    TEST_CHECK(openLog(&log, "test_table_w.wal"));
+    ASSERT_TRUE(log.base == base, "the base of the log is kept");
+    position = log.base;
+    TEST_CHECK(readLogRecord(&log, &position, &record));
+    ASSERT_EQUALS_INT(WAL_DELETE, record.type, "the record appended after the reset");
+    ASSERT_TRUE(record.lsn == lsns[0], "LSN of the record appended after the reset");
+    TEST_CHECK(closeLog(&log));
+    TEST_CHECK(destroyPageFile("test_table_w.wal"));
+
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testCrashRecovery(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    SM_FileHandle fh;
+    int numInserts = 3000, i, status;
+    pid_t pid;
+    Record *r;
+    RID *rids;
+    char **values;
+    Schema *schema;
+    testName = "test recovery from the write-ahead log";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+    values = (char **) calloc(numInserts, sizeof(char *));
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_r", schema));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    for (i = 0; i < numInserts; i++) {
+        values[i] = "aaaa";
+        r = testRecord(schema, i, values[i], -i);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    TEST_CHECK(closeTable(table));
+
+    // the closed table was checkpointed
+    TEST_CHECK(openPageFile("test_table_r.wal", &fh));
+    ASSERT_EQUALS_INT(PAGE_SIZE, (int) getFileSize(&fh), "the log of a closed table is empty");
+    TEST_CHECK(closePageFile(&fh));
+
+    // the child commits its changes and stops without closing the table, they are redone when the table is opened
+    for (i = 0; i < numInserts; i += 3) {
+        values[i] = NULL;
+    }
+    for (i = 1; i < numInserts; i += 3) {
+        values[i] = "a longer string grown out of its page";
+    }
+    fflush(stdout);
+    pid = fork();
+    if (pid == 0) {
+        bool failed = openTable(table, "test_table_r") != RC_OK;
+        for (i = 0; i < numInserts && !failed; i++) {
+            if (i % 3 == 0) {
+                failed = deleteRecord(table, rids[i]) != RC_OK;
+            }
+            else if (i % 3 == 1) {
+                r = testRecord(schema, i, values[i], -i);
+                r->id = rids[i];
+                failed = updateRecord(table, r) != RC_OK;
+                freeRecord(r);
+            }
+        }
+        if (!failed) {
+            failed = commitTable(table) != RC_OK;
+        }
+        _exit(failed ? 1 : 0);
+    }
+    ASSERT_TRUE(pid > 0, "the process is forked");
+    ASSERT_TRUE(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0,
+                "the changes are committed");
+
+    TEST_CHECK(openTable(table, "test_table_r"));
+    ASSERT_EQUALS_INT(numInserts - numInserts / 3, getNumTuples(table), "number of records after recovery");
+    checkGrownRecords(table, schema, rids, values, numInserts);
+    TEST_CHECK(openPageFile("test_table_r.wal", &fh));
+    ASSERT_EQUALS_INT(PAGE_SIZE, (int) getFileSize(&fh), "the log of a recovered table is empty");
+    TEST_CHECK(closePageFile(&fh));
+
+    // and the recovered table keeps working
+    for (i = 0; i < numInserts; i += 3) {
+        values[i] = "new";
+        r = testRecord(schema, i, values[i], -i);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(openTable(table, "test_table_r"));
+    checkGrownRecords(table, schema, rids, values, numInserts);
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_r"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    free(rids);
+    free(values);
+    freeSchema(schema);
+    TEST_DONE();
+}
+
+// ************************************************************
+void
+testGovernedTablePool(void) {
+    RM_TableData *table = (RM_TableData *) malloc(sizeof(RM_TableData));
+    RM_ScanHandle *sc = (RM_ScanHandle *) malloc(sizeof(RM_ScanHandle));
+    int numInserts = 1000, i;
+    Record *r;
+    RID *rids;
+    char **values;
+    Schema *schema;
+    testName = "test a table under a small memory budget";
+    schema = testSchema();
+    rids = (RID *) malloc(sizeof(RID) * numInserts);
+    values = (char **) calloc(numInserts, sizeof(char *));
+
+    TEST_CHECK(initRecordManager(NULL));
+    TEST_CHECK(createTable("test_table_m", schema));
+    TEST_CHECK(openTable(table, "test_table_m"));
+    for (i = 0; i < numInserts; i++) {
+        values[i] = "";
+        r = testRecord(schema, i, values[i], -i);
+        TEST_CHECK(insertRecord(table, r));
+        rids[i] = r->id;
+        freeRecord(r);
+    }
+
+    // the governor leaves the table the frames of a scan and of a record moving to another page
+    TEST_CHECK(setBufferPoolBudget(2));
+    TEST_CHECK(startScan(table, sc, NULL));
+    TEST_CHECK(createRecord(&r, schema));
+    TEST_CHECK(next(sc, r));
+    freeRecord(r);
+    for (i = 0; i < numInserts; i++) {
+        values[i] = "gggg";
+        r = testRecord(schema, i, values[i], -i);
+        r->id = rids[i];
+        TEST_CHECK(updateRecord(table, r));
+        freeRecord(r);
+    }
+    TEST_CHECK(closeScan(sc));
+    checkGrownRecords(table, schema, rids, values, numInserts);
+    TEST_CHECK(setBufferPoolBudget(0));
+
+    TEST_CHECK(closeTable(table));
+    TEST_CHECK(deleteTable("test_table_m"));
+    TEST_CHECK(shutdownRecordManager());
+
+    free(table);
+    free(sc);
+    free(rids);
+    free(values);
+    freeSchema(schema);
+    TEST_DONE();
+}
@@ -0,0 +1,206 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "wal_mgr.h"
+
+// Appended records are written to the file when they fill the buffer or when they must be durable
+#define WAL_INITIAL_BUFFER_SIZE (16 * PAGE_SIZE)
+
+// Header of the log, in the reserved page after the number of pages written by the storage manager
+#define WAL_HEADER_OFFSET 64
+#define WAL_MAGIC 0x57414c31
+
+// Records are stored from the first page of the file
+#define WAL_RECORDS_OFFSET ((long)PAGE_SIZE)
+
+// Stored before the data of every record, the checksum covers the other fields and the data
+typedef struct WAL_RecordHeader {
+	int length;
+	int type;
+	int page;
+	int slot;
+	uint32_t checksum;
+} WAL_RecordHeader;
+
+// FNV-1a, a record with a different checksum was not completely written
+uint32_t logChecksum(WAL_RecordHeader* header, char* data) {
+	uint32_t hash = 2166136261u;
+	int fields[4] = {header->length, header->type, header->page, header->slot};
+	unsigned char* bytes = (unsigned char*)fields;
+	for (int i = 0; i < (int)sizeof(fields); i++) {
+		hash = (hash ^ bytes[i]) * 16777619u;
+	}
+	for (int i = 0; i < header->length; i++) {
+		hash = (hash ^ (unsigned char)data[i]) * 16777619u;
+	}
+	return hash;
+}
+
+// Offset in the file of a position of the log
+long logOffset(WAL_Log* log, WAL_LSN lsn) {
+	return WAL_RECORDS_OFFSET + (lsn - log->base);
+}
+
+RC writeLogHeader(WAL_Log* log) {
+	char header[sizeof(int) + sizeof(WAL_LSN)];
+	int magic = WAL_MAGIC;
+	memcpy(header, &magic, sizeof(int));
+	memcpy(header + sizeof(int), &log->base, sizeof(WAL_LSN));
+	return writeBytes(WAL_HEADER_OFFSET, sizeof(header), &log->fileHandle, header);
+}
+
+// Open the file of the log and read its header, the file is created if it does not exist
+RC openLogFile(WAL_Log* log) {
+	if (openPageFile(log->fileName, &log->fileHandle) != RC_OK) {
+		if (createPageFile(log->fileName) != RC_OK || openPageFile(log->fileName, &log->fileHandle) != RC_OK) {
+			return RC_FILE_NOT_FOUND;
+		}
+		log->base = 0;
+		if (truncateBytes(WAL_RECORDS_OFFSET, &log->fileHandle) != RC_OK || writeLogHeader(log) != RC_OK
+				|| syncPageFile(&log->fileHandle) != RC_OK) {
+			closePageFile(&log->fileHandle);
+			return RC_WRITE_FAILED;
+		}
+		return RC_OK;
+	}
+
+	char header[sizeof(int) + sizeof(WAL_LSN)];
+	int magic = 0;
+	if (readBytes(WAL_HEADER_OFFSET, sizeof(header), &log->fileHandle, header) == RC_OK) {
+		memcpy(&magic, header, sizeof(int));
+		memcpy(&log->base, header + sizeof(int), sizeof(WAL_LSN));
+	}
+	if (magic != WAL_MAGIC) {
+		closePageFile(&log->fileHandle);
+		return RC_READ_NON_EXISTING_PAGE;
+	}
+	return RC_OK;
+}
+
+RC openLog(WAL_Log* log, char* fileName) {
+	log->fileName = malloc(strlen(fileName) + 1);
+	strcpy(log->fileName, fileName);
+	RC rc = openLogFile(log);
+	if (rc != RC_OK) {
+		free(log->fileName);
+		return rc;
+	}
+	log->bufferCapacity = WAL_INITIAL_BUFFER_SIZE;
+	log->buffer = malloc(log->bufferCapacity);
+	log->bufferLength = 0;
+
+	// after the last complete record
+	WAL_LSN end = log->base;
+	WAL_Record record;
+	while (readLogRecord(log, &end, &record) == RC_OK) {
+		free(record.data);
+	}
+	long endOffset = logOffset(log, end);
+	if (getFileSize(&log->fileHandle) > endOffset && truncateBytes(endOffset, &log->fileHandle) != RC_OK) {
+		closeLog(log);
+		return RC_WRITE_FAILED;
+	}
+	log->nextLSN = end;
+	log->writtenLSN = end;
+	log->durableLSN = end;
+	return RC_OK;
+}
+
+RC closeLog(WAL_Log* log) {
+	RC rc = flushLog(log, log->nextLSN);
+	free(log->buffer);
+	log->buffer = NULL;
+	closePageFile(&log->fileHandle);
+	free(log->fileName);
+	return rc;
+}
+
+// Write the buffer to the file, without waiting for the disk
+RC writeLogBuffer(WAL_Log* log) {
+	if (log->bufferLength == 0) {
+		return RC_OK;
+	}
+	if (writeBytes(logOffset(log, log->writtenLSN), log->bufferLength, &log->fileHandle, log->buffer) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	log->writtenLSN += log->bufferLength;
+	log->bufferLength = 0;
+	return RC_OK;
+}
+
+WAL_LSN appendLogRecord(WAL_Log* log, WAL_RecordType type, int page, int slot, char* data, int length) {
+	WAL_RecordHeader header = {length, type, page, slot, 0};
+	header.checksum = logChecksum(&header, data);
+	int size = sizeof(WAL_RecordHeader) + length;
+	if (log->bufferLength + size > log->bufferCapacity) {
+		writeLogBuffer(log);
+	}
+	// the records stay in the buffer when they could not be written, the flush making them durable fails then
+	while (log->bufferLength + size > log->bufferCapacity) {
+		log->bufferCapacity *= 2;
+		log->buffer = realloc(log->buffer, log->bufferCapacity);
+	}
+	memcpy(log->buffer + log->bufferLength, &header, sizeof(WAL_RecordHeader));
+	if (length > 0) {
+		memcpy(log->buffer + log->bufferLength + sizeof(WAL_RecordHeader), data, length);
+	}
+	log->bufferLength += size;
+	log->nextLSN += size;
+	return log->nextLSN;
+}
+
+RC flushLog(WAL_Log* log, WAL_LSN lsn) {
+	if (lsn <= log->durableLSN) {
+		return RC_OK;
+	}
+	if (writeLogBuffer(log) != RC_OK || syncPageFile(&log->fileHandle) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	log->durableLSN = log->writtenLSN;
+	return RC_OK;
+}
+
+RC resetLog(WAL_Log* log, WAL_LSN base) {
+	log->bufferLength = 0;
+	log->base = base;
+	if (truncateBytes(WAL_RECORDS_OFFSET, &log->fileHandle) != RC_OK || writeLogHeader(log) != RC_OK
+			|| syncPageFile(&log->fileHandle) != RC_OK) {
+		return RC_WRITE_FAILED;
+	}
+	log->nextLSN = base;
+	log->writtenLSN = base;
+	log->durableLSN = base;
+	return RC_OK;
+}
+
+RC readLogRecord(WAL_Log* log, WAL_LSN* position, WAL_Record* record) {
+	WAL_RecordHeader header;
+	if (readBytes(logOffset(log, *position), sizeof(WAL_RecordHeader), &log->fileHandle, (char*)&header) != RC_OK) {
+		return RC_WAL_END_OF_LOG;
+	}
+	if (header.length < 0 || header.length > PAGE_SIZE || header.type < WAL_INSERT || header.type > WAL_MOVE_OUT) {
+		return RC_WAL_END_OF_LOG;
+	}
+	char* data = malloc(header.length > 0 ? header.length : 1);
+	long dataOffset = logOffset(log, *position) + sizeof(WAL_RecordHeader);
+	if (header.length > 0 && readBytes(dataOffset, header.length, &log->fileHandle, data) != RC_OK) {
+		free(data);
+		return RC_WAL_END_OF_LOG;
+	}
+	if (logChecksum(&header, data) != header.checksum) {
+		free(data);
+		return RC_WAL_END_OF_LOG;
+	}
+	*position += sizeof(WAL_RecordHeader) + header.length;
+	record->lsn = *position;
+	record->type = header.type;
+	record->page = header.page;
+	record->slot = header.slot;
+	record->length = header.length;
+	if (header.length == 0) {
+		free(data);
+		data = NULL;
+	}
+	record->data = data;
+	return RC_OK;
+}
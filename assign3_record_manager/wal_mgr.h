@@ -0,0 +1,72 @@
+#ifndef WAL_MGR_H
+#define WAL_MGR_H
+
+#include "dberror.h"
+#include "dt.h"
+#include "storage_mgr.h"
+
+/*
+ * Write-ahead log of the changes of the records of a table. Every change is appended to the log before the page it
+ * changes can be written, so the pages do not need to be written when a change is committed: after a crash, the records
+ * of the log are applied again to the pages that were not written with them (redo).
+ * The log is a page file: its reserved page holds the LSN of its first record, the records follow it.
+ */
+
+// Log sequence number: position in the log of the end of a record. It keeps growing when the log is emptied.
+typedef long WAL_LSN;
+
+typedef enum WAL_RecordType {
+	WAL_INSERT = 1,
+	WAL_UPDATE = 2,
+	WAL_DELETE = 3,
+	WAL_NEW_PAGE = 4, // the page becomes an empty data page
+	WAL_MOVE_IN = 5, // a record grown out of its page gets a slot of this one, the RID of its home slot follows it
+	WAL_FORWARD = 6, // the slot keeps the RID of the slot its record moved to
+	WAL_MOVE_OUT = 7 // the slot of a moved record is freed, the record is deleted or moves again
+} WAL_RecordType;
+
+// Log record read back by readLogRecord
+typedef struct WAL_Record {
+	WAL_LSN lsn;
+	WAL_RecordType type;
+	int page;
+	int slot;
+	int length;
+	char* data; // the record for an insert or an update, the RID of the new slot for a forward, NULL for a delete
+} WAL_Record;
+
+typedef struct WAL_Log {
+	SM_FileHandle fileHandle;
+	char* fileName;
+	WAL_LSN base; // LSN of the beginning of the first record of the file
+	WAL_LSN nextLSN; // end of the last appended record
+	WAL_LSN writtenLSN; // the records before are written to the file, the buffer holds the records after
+	WAL_LSN durableLSN; // the records before are on the disk
+	char* buffer;
+	int bufferLength;
+	int bufferCapacity;
+} WAL_Log;
+
+/*
+ * The log is created if the file does not exist. It is positioned after its last complete record, a record partially
+ * written when the program stopped is removed.
+ */
+RC openLog(WAL_Log* log, char* fileName);
+RC closeLog(WAL_Log* log);
+
+// Returns the LSN of the record
+WAL_LSN appendLogRecord(WAL_Log* log, WAL_RecordType type, int page, int slot, char* data, int length);
+
+// The records up to lsn are on the disk when it returns, nothing is done if they already are
+RC flushLog(WAL_Log* log, WAL_LSN lsn);
+
+// Remove all the records, the next one starts at base which must not be smaller than the LSNs already given
+RC resetLog(WAL_Log* log, WAL_LSN base);
+
+/*
+ * Read the record starting at *position (log->base for the first one) and move *position to its end. Returns
+ * RC_WAL_END_OF_LOG after the last complete record. record->data is allocated and freed by the caller.
+ */
+RC readLogRecord(WAL_Log* log, WAL_LSN* position, WAL_Record* record);
+
+#endif
@@ -6,6 +6,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 typedef struct BT_FreePage BT_FreePage;
@@ -374,15 +375,48 @@ void nodeFromPageHandle(BM_PageHandle * pageHandle, Node * node){
     pageHandle->data += sizeof (int);
 }
 
+/*
+ * read the node stored in page pageNumber without pinning it. The page is copied and only decoded once the copy is
+ * validated, a torn page could hold any node type and number of keys. After OPTIMISTIC_READ_RETRIES changed copies, or
+ * while a writer holds the page, the node is read pinned.
+ */
+RC readNodeOptimistic(IndexMgr * indexMgr, Node * node, int pageNumber){
+    BM_PageHandle pageHandle;
+    BM_PageHandle cursor; // nodeFromPageHandle moves the data pointer
+    unsigned long version;
+    char copy[PAGE_SIZE];
+    for (int attempt = 0; attempt < OPTIMISTIC_READ_RETRIES; attempt++) {
+        RC rc = readPageOptimistic(indexMgr->bufferPool, &pageHandle, pageNumber, &version);
+        if (rc == RC_BM_PAGE_BEING_WRITTEN) {
+            break;
+        }
+        if (rc != RC_OK) {
+            return rc;
+        }
+        memcpy(copy, pageHandle.data, PAGE_SIZE);
+        if (validatePageRead(indexMgr->bufferPool, &pageHandle, version)) {
+            cursor.pageNum = pageNumber;
+            cursor.data = copy;
+            nodeFromPageHandle(&cursor, node);
+            return RC_OK;
+        }
+    }
+
+    if (pinPage(indexMgr->bufferPool, &pageHandle, pageNumber) != RC_OK) {
+        return RC_READ_NON_EXISTING_PAGE;
+    }
+    cursor = pageHandle;
+    nodeFromPageHandle(&cursor, node);
+    return unpinPage(indexMgr->bufferPool, &pageHandle);
+}
+
 void recursivelyFindNode(BTreeHandle * tree, Value * key, Node * node, int pageNumber){
     IndexMgr * indexMgr = (IndexMgr *) tree->mgmtData;
-    BM_PageHandle * pageHandle = MAKE_PAGE_HANDLE();
-    if (pinPage(indexMgr->bufferPool, pageHandle, pageNumber) != RC_OK){
-        return NULL;
+    // the traversal does not pin the nodes, so it never touches the fix counts of the upper levels of the tree
+    if (readNodeOptimistic(indexMgr, node, pageNumber) != RC_OK){
+        return;
     }
 
-    nodeFromPageHandle(pageHandle, node);
-
     if (node->isLeaf == TRUE){ // we are the bottom of the tree
         return;
     }
@@ -29,6 +29,8 @@ typedef struct BM_BufferPool {
     void *mgmtData; // use this one to store the bookkeeping info your buffer
     int numberOfWriteIO;
     int numberOfReadIO;
+    int numberOfHits; // pins of pages already in the pool
+    long numberOfReadBytes; // read from the page file, less than a block per read for a compressed page file
     // manager needs for a buffer pool
 } BM_BufferPool;
 
@@ -37,20 +39,73 @@ typedef struct BM_PageHandle {
     char *data;
 } BM_PageHandle;
 
+/*
+ * Called with every page a pool is about to write to its file, under the lock of the pool. The page is not written if it
+ * does not return RC_OK, write-ahead logging uses it to write the log of the changes of the page first.
+ */
+typedef RC (*BM_BeforeWriteHook)(void *hookData, PageNumber pageNum, char *data);
+
 typedef struct BM_FrameHandle {
     BM_PageHandle * page; //the page in this frame
     int positionInFramesArray;
     bool isDirty;
     int fixCount;
     time_t lastAccess;
+    unsigned long version; // odd while a writer may be modifying the page, changes each time the content changes
+    int numaNode; // NUMA node of the frame memory, -1 if unknown
 } BM_FrameHandle;
 
 typedef struct BM_FramesHandle {
     BM_FrameHandle ** frames;
     int lastPinnedPosition;
     int actualUsedFrames;
+    void **retired; // memory optimistic readers may still look at, freed at shutdown
+    int numberOfRetired;
+    void *memory; // memory holding the pages of the frames
+    void *lock; // mutex held by the calls changing the pool, so several threads can use it
+    int sizeHolds; // the memory governor does not resize the pool while it is not 0
+    int minFrames; // the memory governor never shrinks the pool under this number of frames
+    void *compressedFile; // directory of the pages of a compressed page file, NULL for a plain page file
+    BM_BeforeWriteHook beforeWrite; // NULL if the pool has none
+    void *beforeWriteData; // passed to beforeWrite
 } BM_FramesHandle;
 
+// Memory backing the frames of a pool
+typedef enum BM_HugePages {
+    BM_HUGE_PAGES_NONE = 0,
+    BM_HUGE_PAGES_TRANSPARENT = 1, // 2 MB aligned memory advised for transparent huge pages
+    BM_HUGE_PAGES_EXPLICIT = 2 // reserved 2 MB huge pages, transparent ones are used if none are available
+} BM_HugePages;
+
+typedef enum BM_NumaPolicy {
+    BM_NUMA_NONE = 0,
+    BM_NUMA_INTERLEAVE = 1, // frames spread over all the nodes
+    BM_NUMA_BIND = 2 // every frame on numaNode
+} BM_NumaPolicy;
+
+typedef struct BM_MemoryOptions {
+    BM_HugePages hugePages;
+    BM_NumaPolicy numaPolicy;
+    int numaNode;
+} BM_MemoryOptions;
+
+/*
+ * Bulk read access strategy: a small private ring of frames.
+ * Pages loaded through the strategy are remembered in the ring and their frames are recycled round-robin,
+ * so a large sequential scan does not evict the whole pool.
+ */
+typedef struct BM_AccessStrategy {
+    PageNumber *ring; // pages loaded through this strategy, NO_PAGE while the ring is not full
+    int ringSize;
+    int nextVictim; // position in the ring of the next frame to recycle
+} BM_AccessStrategy;
+
+// Codec of the pages of a compressed page file
+typedef enum BM_PageCodec {
+    BM_CODEC_NONE = 0,
+    BM_CODEC_LZ = 1 // LZ77 in the block format of LZ4: runs of literals and copies of earlier bytes of the page
+} BM_PageCodec;
+
 // convenience macros
 #define MAKE_POOL()					\
 		((BM_BufferPool *) malloc (sizeof(BM_BufferPool)))
@@ -62,8 +117,35 @@ typedef struct BM_FramesHandle {
 RC initBufferPool(BM_BufferPool *const bm, const char *const pageFileName,
                   const int numPages, ReplacementStrategy strategy,
                   void *stratData);
+RC initBufferPoolWithMemoryOptions(BM_BufferPool *const bm, const char *const pageFileName,
+                  const int numPages, ReplacementStrategy strategy,
+                  void *stratData, BM_MemoryOptions *options);
 RC shutdownBufferPool(BM_BufferPool *const bm);
 RC forceFlushPool(BM_BufferPool *const bm);
+RC resizeBufferPool(BM_BufferPool *const bm, const int newNumPages);
+RC ensurePoolCapacity(BM_BufferPool *const bm, const int numberOfPages);
+RC truncatePool(BM_BufferPool *const bm, const int numberOfPages);
+RC setBeforeWriteHook(BM_BufferPool *const bm, BM_BeforeWriteHook beforeWrite, void *hookData);
+
+/*
+ * Compressed page files: every page is stored encoded with a codec, so reading it takes fewer bytes than a block.
+ * Pools detect them at init and encode the pages they write. The file must not be open in a pool.
+ */
+RC compressPageFile(char *fileName, BM_PageCodec codec);
+
+/*
+ * Memory governor: every pool registers itself at init. Once a budget is set, frames are moved between the pools
+ * according to their miss rates so that the pools together never use more than the budget.
+ */
+RC setBufferPoolBudget(const int totalFrames);
+RC rebalanceBufferPools(void);
+
+// The governor leaves the pool alone until the hold is released, for callers that resize it temporarily
+void holdBufferPoolSize(BM_BufferPool *const bm);
+void releaseBufferPoolSize(BM_BufferPool *const bm);
+
+// The governor never shrinks the pool under minFrames frames, for callers pinning several pages at once
+RC setBufferPoolMinimum(BM_BufferPool *const bm, const int minFrames);
 
 // Buffer Manager Interface Access Pages
 RC markDirty (BM_BufferPool *const bm, BM_PageHandle *const page);
@@ -71,6 +153,27 @@ RC unpinPage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC forcePage (BM_BufferPool *const bm, BM_PageHandle *const page);
 RC pinPage (BM_BufferPool *const bm, BM_PageHandle *const page,
             const PageNumber pageNum);
+RC pinPageWithStrategy (BM_BufferPool *const bm, BM_PageHandle *const page,
+            const PageNumber pageNum, BM_AccessStrategy *strategy);
+
+// Buffer Manager Interface Access Strategies
+BM_AccessStrategy *createAccessStrategy (int ringSize);
+void freeAccessStrategy (BM_AccessStrategy *strategy);
+
+/*
+ * Buffer Manager Interface Optimistic Reads
+ * The page is read without being pinned: readPageOptimistic gives the frame version, the caller copies what it needs
+ * and then calls validatePageRead. If the page changed (or was evicted) meanwhile the read must be retried.
+ * It returns RC_BM_PAGE_BEING_WRITTEN when the page is being written or keeps moving, the page must then be pinned.
+ * Writers must call markDirty before modifying a page, the write ends when the page is unpinned.
+ */
+
+// Number of optimistic reads of a page tried before pinning it
+#define OPTIMISTIC_READ_RETRIES 3
+
+RC readPageOptimistic (BM_BufferPool *const bm, BM_PageHandle *const page,
+            const PageNumber pageNum, unsigned long *version);
+bool validatePageRead (BM_BufferPool *const bm, BM_PageHandle *const page, const unsigned long version);
 
 // Statistics Interface
 PageNumber *getFrameContents (BM_BufferPool *const bm);
@@ -78,5 +181,6 @@ bool *getDirtyFlags (BM_BufferPool *const bm);
 int *getFixCounts (BM_BufferPool *const bm);
 int getNumReadIO (BM_BufferPool *const bm);
 int getNumWriteIO (BM_BufferPool *const bm);
+long getNumReadBytes (BM_BufferPool *const bm);
 
 #endif
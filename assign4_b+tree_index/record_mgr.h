@@ -12,25 +12,81 @@ typedef struct RM_ScanHandle
     void *mgmtData;
 } RM_ScanHandle;
 
+// Record read in place in its pinned page (see borrowRecord), its attributes are read with the getBorrowed functions
+typedef struct RM_BorrowedRecord
+{
+	RID id;
+	char *data; // record as encoded in the page, the page itself for a PAX table
+	int length;
+	Schema *schema;
+	void *tableMgmtData; // manager of the table of the record
+	void *mgmtData;
+} RM_BorrowedRecord;
+
+// Records found by one thread of a parallel scan, stored one after the other with their in memory layout
+typedef struct RM_ScanOutput
+{
+	int numberOfRecords;
+	RID *ids;
+	char *data;
+	int capacity;
+} RM_ScanOutput;
+
+// Record moved by vacuumTable from one RID to another
+typedef struct RM_RecordMove
+{
+	RID from;
+	RID to;
+} RM_RecordMove;
+
+// Layout of the data pages of a table, chosen when the table is created
+typedef enum RM_TableFormat {
+	RM_FORMAT_ROW = 0, // records stored one after the other in a slotted page
+	RM_FORMAT_PAX = 1 // records stored column by column, one minipage per attribute
+} RM_TableFormat;
+
 // table and manager
 extern RC initRecordManager (void *mgmtData);
 extern RC shutdownRecordManager ();
 extern RC createTable (char *name, Schema *schema);
+extern RC createTableWithFormat (char *name, Schema *schema, RM_TableFormat format);
+extern RC createTableWithDictionaries (char *name, Schema *schema, RM_TableFormat format, bool *dictionaryEncoded);
 extern RC openTable (RM_TableData *rel, char *name);
 extern RC closeTable (RM_TableData *rel);
 extern RC deleteTable (char *name);
+extern RC compressTable (char *name);
+extern RC commitTable (RM_TableData *rel);
 extern int getNumTuples (RM_TableData *rel);
 
 // handling records in a table
 extern RC insertRecord (RM_TableData *rel, Record *record);
+extern RC insertRecords (RM_TableData *rel, Record **records, int n);
 extern RC deleteRecord (RM_TableData *rel, RID id);
 extern RC updateRecord (RM_TableData *rel, Record *record);
 extern RC getRecord (RM_TableData *rel, RID id, Record *record);
+extern RC vacuumTable (RM_TableData *rel, RM_RecordMove **moves, int *numberOfMoves);
 
 // scans
 extern RC startScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond);
+extern RC startProjectedScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, int *attrs, int numberOfAttrs);
+extern RC startSampleScan (RM_TableData *rel, RM_ScanHandle *scan, Expr *cond, double pageFraction, double recordFraction, unsigned int seed);
 extern RC next (RM_ScanHandle *scan, Record *record);
 extern RC closeScan (RM_ScanHandle *scan);
+extern RC parallelScan (RM_TableData *rel, Expr *cond, int numberOfThreads, RM_ScanOutput *outputs);
+extern void freeScanOutput (RM_ScanOutput *output);
+
+// statistics for the estimation of the selectivity of a condition
+extern RC analyzeTable (RM_TableData *rel, int numberOfSamplePages);
+extern double estimateSelectivity (RM_TableData *rel, Expr *cond);
+
+// borrowed records: no copy, the record stays in its page which is kept pinned
+extern RC borrowRecord (RM_TableData *rel, RID id, RM_BorrowedRecord *record);
+extern RC releaseBorrowedRecord (RM_BorrowedRecord *record);
+extern RC nextBorrowed (RM_ScanHandle *scan, RM_BorrowedRecord *record);
+extern int getBorrowedInt (RM_BorrowedRecord *record, int attrNum);
+extern float getBorrowedFloat (RM_BorrowedRecord *record, int attrNum);
+extern bool getBorrowedBool (RM_BorrowedRecord *record, int attrNum);
+extern char *getBorrowedString (RM_BorrowedRecord *record, int attrNum, int *length);
 
 // dealing with schemas
 extern int getRecordSize (Schema *schema);
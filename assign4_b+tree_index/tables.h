@@ -39,6 +39,7 @@ typedef struct Schema
 	char **attrNames;
 	DataType *dataTypes;
 	int *typeLength;
+	int *attrOffsets; // offset of each attribute in a record, attrOffsets[numAttr] is the size of the record
 	int *keyAttrs;
 	int keySize;
 } Schema;